@@ -0,0 +1,130 @@
+/*
+ * edge_main.cpp — Fixed-configuration NMEA → route tool for edge units
+ *
+ * The embedded build of the route pipeline: Pipeline<EdgePipelineConfig>
+ * with every knob fixed at compile time — GP/GN RMC, checksums verified
+ * for the RMCs only, emit-on-arrival timestamp dedup and the degree
+ * jitter filter — so the stages it switches off are not compiled in.
+ * There are no options.  Input is read through one fixed buffer, and
+ * each route point is written the moment it is kept.  The points are
+ * CSV rows (`timestamp_ms,latitude,longitude,speed_mps`, as
+ * --export-csv), each flushed as it is written.  The line counters go
+ * to stderr at the end.  Nothing is allocated per line.
+ *
+ * Build:  make edge      (produces build/nmea_edge)
+ * Usage:  ./nmea_edge [file.nmea …]      (no files, or "-": standard input)
+ */
+
+#include "output.h"
+#include "pipeline.h"
+#include "route_io.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+
+// ─── Edge constants ────────────────────────────────────────────────────────
+
+static constexpr std::size_t kReadBufferBytes = 64 * 1024;   // longest line kept
+static constexpr int         kStdoutFd        = 1;
+
+/// Writes each route point as a CSV row and flushes it.
+struct CsvRowSink {
+    FdWriter* out;
+
+    void operator()(const GpsRecord& rec) const
+    {
+        out->number(static_cast<std::size_t>(rec.timestamp_ms));   // RMC dates are post-1980
+        out->put(',');
+        out->coord(rec.lat_e7, kExportCoordPrecision);
+        out->put(',');
+        out->coord(rec.lon_e7, kExportCoordPrecision);
+        out->put(',');
+        out->fixed(rec.speed, kExportSpeedPrecision);
+        out->put('\n');
+        out->flush();
+    }
+};
+
+using EdgePipeline = Pipeline<EdgePipelineConfig, CsvRowSink>;
+
+/// Feed `in` to `pipeline` whole lines at a time through `buf`.  A line
+/// longer than the buffer is dropped; returns how many were.
+static std::size_t feed_stream(std::FILE* in, EdgePipeline& pipeline, char* buf)
+{
+    std::size_t held = 0, overlong = 0;
+    bool skipping = false;   // inside a line that did not fit
+    for (;;) {
+        const std::size_t n = std::fread(buf + held, 1, kReadBufferBytes - held, in);
+        if (n == 0)
+            break;
+        held += n;
+
+        const std::string_view text(buf, held);
+        const std::size_t      nl = text.rfind('\n');
+        if (nl == std::string_view::npos) {
+            if (held == kReadBufferBytes) {   // no '\n' in a full buffer
+                overlong += !skipping;
+                skipping = true;
+                held     = 0;
+            }
+            continue;
+        }
+        std::size_t start = 0;
+        if (skipping) {   // the rest of the dropped line
+            start    = text.find('\n') + 1;
+            skipping = false;
+        }
+        const std::size_t end = nl + 1;
+        pipeline.feed(text.substr(start, end - start));
+        std::memmove(buf, buf + end, held - end);
+        held -= end;
+    }
+    if (held && !skipping)
+        pipeline.feed(std::string_view(buf, held));   // last line, no '\n'
+    return overlong;
+}
+
+int main(int argc, char* argv[])
+{
+    static char buf[kReadBufferBytes];
+    FdWriter out(kStdoutFd);
+    EdgePipeline pipeline(CsvRowSink{&out});
+
+    out.write("timestamp_ms,latitude,longitude,speed_mps\n");
+    std::size_t overlong = 0;
+    int status = 0;
+    const auto run = [&](const char* path) {
+        const bool stdin_input = std::strcmp(path, "-") == 0;
+        std::FILE* in = stdin_input ? stdin : std::fopen(path, "rb");
+        if (!in) {
+            std::cerr << "Warning: cannot open '" << path << "', skipping.\n";
+            status = 1;
+            return;
+        }
+        overlong += feed_stream(in, pipeline, buf);
+        if (!stdin_input)
+            std::fclose(in);
+    };
+    if (argc < 2)
+        run("-");
+    for (int i = 1; i < argc; ++i)
+        run(argv[i]);
+    pipeline.flush();
+    if (!out.flush())
+        status = 1;
+
+    const PipelineCounters& c = pipeline.counters();
+    std::cerr << "lines " << c.lines << ", skipped " << c.skipped
+              << ", checksum failures " << c.checksum_fail << ", parse failures "
+              << c.parse_fail << ", records " << c.records << ", late " << c.late_dropped
+              << ", route points " << c.route_points;
+    if (c.future_dropped)
+        std::cerr << ", future dropped " << c.future_dropped;
+    if (overlong)
+        std::cerr << ", overlong lines dropped " << overlong;
+    std::cerr << '\n';
+    return status;
+}
@@ -1,23 +1,39 @@
 /*
  * main.cpp — GNSS NMEA-file processor (C++17, production-grade)
  *
- * Thin orchestrator: reads NMEA files, delegates to nmea_parser for
- * validation/extraction, dedup for filtering, and output for presentation.
+ * Thin orchestrator: parses the command line via cli, hands the inputs to
+ * ingest (reader + nmea_parser, optionally multi-threaded), dedup for
+ * filtering, and output for presentation.
  *
  * Build:  make            (Linux / MinGW on Windows)
- * Usage:  ./nmea_parser file1.nmea [file2.nmea …]
+ * Usage:  ./nmea_parser [--jobs N] [--stream | --pipeline] file1.nmea [file2.nmea …]
+ *         ./nmea_parser --live tcp://host:port | gpsd://host | serial:/dev/ttyX
  */
 
-#include "nmea_parser.h"
+#include "arena.h"
+#include "checkpoint.h"
+#include "cli.h"
 #include "dedup.h"
+#include "ingest.h"
+#include "live.h"
+#include "nmea_parser.h"
 #include "output.h"
+#include "parallel.h"
+#include "pipeline.h"
+#include "query.h"
+#include "route_io.h"
+#include "sentence.h"
+#include "spatial.h"
+#include "stats.h"
+#include "track.h"
 #include "gpsd_config.h"
 #include "gpsd.h"
 
+#include <chrono>
 #include <cstddef>
-#include <fstream>
-#include <iomanip>
+#include <cstdint>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -27,110 +43,497 @@ static constexpr int kDisplayPrecision = 6;
 static constexpr int kColIndex         = 6;
 static constexpr int kColCoord         = 14;
 static constexpr int kSeparatorWidth   = 44;
+static constexpr int kStdoutFd         = 1;
+
+// ─── Route table printing ──────────────────────────────────────────────────
+
+/// Prints route-table rows through the gpsd structs.  gps_device_t is
+/// ~110 KB, so a single instance is allocated and reused for every row
+/// rather than carried in each record.  Rows are formatted straight into
+/// the writer's buffer; flush std::cout before the first one.
+class RouteTablePrinter {
+public:
+    explicit RouteTablePrinter(FdWriter& out)
+        : out_(out), dev_(std::make_unique<gps_device_t>()) {}
+
+    void header()
+    {
+        out_.write("=== Route Points ===\n");
+        out_.write("#", kColIndex);
+        out_.write("Latitude", kColCoord);
+        out_.write("Longitude", kColCoord);
+        out_.write("Speed (m/s)\n");
+        for (int i = 0; i < kSeparatorWidth; ++i)
+            out_.put('-');
+        out_.put('\n');
+    }
+
+    void row(std::size_t number, const GpsRecord& rec)
+    {
+        // Speed from gps_device_t; lat/lon straight from the record's
+        // fixed-point units, so the printed digits are exact.
+        to_gpsd(rec, ns_, dev_->gpsdata);
+
+        out_.number(number, kColIndex);
+        out_.coord(rec.lat_e7, kDisplayPrecision, kColCoord);
+        out_.coord(rec.lon_e7, kDisplayPrecision, kColCoord);
+        out_.fixed(dev_->gpsdata.fix.speed, kDisplayPrecision);
+        out_.put('\n');
+    }
+
+private:
+    FdWriter&                     out_;
+    ntrip_stream_t                ns_{};
+    std::unique_ptr<gps_device_t> dev_;
+};
+
+/// The route table and Maps URL(s) for one route.
+static void print_route(FdWriter& out, RouteTablePrinter& printer,
+                        const std::vector<GpsRecord>& route, std::size_t url_waypoints)
+{
+    printer.header();
+    for (std::size_t i = 0; i < route.size(); ++i)
+        printer.row(i + 1, route[i]);
+
+    const std::size_t urls = google_maps_url_count(route.size(), url_waypoints);
+    if (urls == 1) {
+        out.write("\n=== Google Maps URL ===\n");
+    } else {
+        out.write("\n=== Google Maps URLs (");
+        out.number(urls);
+        out.write(") ===\n");
+    }
+    write_google_maps_urls(out, route, url_waypoints);
+}
+
+/// Write the --export-* files for one route and its `index`; `suffix`
+/// names its track (empty without --track-by).
+static bool export_route(const CliOptions& opts, const std::vector<GpsRecord>& route,
+                         const RouteIndex& index, const std::string& suffix,
+                         std::string& error)
+{
+    const auto target = [&](const std::string& path) {
+        return suffix.empty() ? path : track_path(path, suffix);
+    };
+    return (opts.export_bin.empty() ||
+            write_route_binary(route, target(opts.export_bin), opts.export_encoding, error)) &&
+           (opts.export_geojson.empty() ||
+            write_route_geojson(route, target(opts.export_geojson), error)) &&
+           (opts.export_csv.empty() || write_route_csv(route, target(opts.export_csv), error)) &&
+           (opts.export_index.empty() || index.save(target(opts.export_index), error));
+}
+
+/// The "Lines by type" summary row (--fast-reject / --checksum-all).
+static void print_line_types(std::ostream& os, const IngestCounters& c)
+{
+    os << "  Lines by type        :";
+    for (std::size_t t = 1; t < kSentenceTypeCount; ++t)
+        os << ' ' << sentence_type_name(static_cast<SentenceType>(t)) << ' ' << c.by_type[t] << ',';
+    os << " other " << c.by_type[0] << '\n';
+}
+
+// ─── Live mode ─────────────────────────────────────────────────────────────
+
+/// Consume a live stream, printing each route point the moment it clears
+/// dedup, then a summary with per-point latency once the stream ends.
+static int run_live_mode(const CliOptions& opts)
+{
+    LiveSource src;
+    std::string error;
+    if (!parse_live_source(opts.live, src, error)) {
+        std::cerr << "Error: " << error << '\n';
+        return 1;
+    }
+
+    LiveOptions live_opts;
+    live_opts.window_ms = opts.window_ms.value_or(0);
+    live_opts.spatial   = opts.spatial;
+    live_opts.checksum  = opts.ingest.checksum;
+
+    std::cout.flush();
+    FdWriter          out(kStdoutFd);
+    RouteTablePrinter printer(out);
+    std::size_t number = 0;
+    LiveStats stats;
+    bool ok = run_live(src, live_opts, [&](const GpsRecord& rec) {
+        if (number == 0)
+            printer.header();
+        printer.row(++number, rec);
+        out.flush();   // one row per fix, as it happens
+    }, stats, error);
+    if (!ok) {
+        std::cerr << "Error: " << error << '\n';
+        if (stats.bytes_read == 0)
+            return 1;   // never connected — nothing to summarise
+    }
+
+    const auto& c = stats.counters;
+    const std::int64_t mean_us = stats.route_points
+        ? stats.latency_sum_us / static_cast<std::int64_t>(stats.route_points) : 0;
+    std::cout << "\n=== Processing Summary ===\n"
+              << "  Bytes received       : " << stats.bytes_read << '\n'
+              << "  Total lines read     : " << c.lines_total << '\n';
+    if (opts.line_types)
+        print_line_types(std::cout, c);
+    std::cout << "  Checksum failures    : " << c.checksum_fail << '\n'
+              << "  Not relevant (skipped): " << c.not_relevant << '\n'
+              << "  Parse/validation fail: " << c.parse_fail << '\n'
+              << "  Valid records parsed : " << stats.records_parsed << '\n'
+              << "  Late (past window)   : " << stats.late_dropped << '\n';
+    if (stats.future_dropped)
+        std::cout << "  Future (unconfirmed) : " << stats.future_dropped << '\n';
+    if (stats.overlong_lines)
+        std::cout << "  Overlong (dropped)   : " << stats.overlong_lines << '\n';
+    std::cout << "  After timestamp dedup: " << stats.after_lww << '\n'
+              << "  After spatial dedup  : " << stats.route_points << '\n'
+              << "  Latency min/mean/max : " << stats.latency_min_us << " / "
+              << mean_us << " / " << stats.latency_max_us << " us\n";
+    return ok ? 0 : 1;
+}
 
 int main(int argc, char* argv[])
 {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <file.nmea> [file2.nmea …]\n";
+    CliOptions opts;
+    std::string error;
+    if (!parse_cli(argc, argv, opts, error)) {
+        std::cerr << "Error: " << error << "\n\n";
+        print_usage(argv[0]);
         return 1;
     }
 
-    // ── Stage 1: Read & parse ───────────────────────────────────────────
-    std::vector<GpsRecord> all_records;
-    std::size_t lines_total    = 0;
-    std::size_t checksum_fail  = 0;
-    std::size_t not_relevant   = 0;
-    std::size_t parse_fail     = 0;
-
-    for (int argi = 1; argi < argc; ++argi) {
-        std::ifstream ifs(argv[argi]);
-        if (!ifs) {
-            std::cerr << "Warning: cannot open '" << argv[argi]
-                      << "', skipping.\n";
-            continue;
-        }
+    if (!opts.live.empty())
+        return run_live_mode(opts);
 
-        std::string line;
-        while (std::getline(ifs, line)) {
-            // Strip trailing CR (files may use \r\n line endings).
-            if (!line.empty() && line.back() == '\r')
-                line.pop_back();
-            if (line.empty())
-                continue;
+    // ── Tracks: without --track-by everything is track 0.
+    const bool tracked = opts.ingest.track_by != TrackBy::kNone;
+    TrackTable tracks;
+    if (opts.ingest.track_by == TrackBy::kFile)
+        tracks = plan_file_tracks(opts.inputs, opts.track_map, opts.ingest.file_tracks);
+    else if (opts.ingest.track_by == TrackBy::kTalker)
+        tracks = plan_talker_tracks();
+    else
+        tracks.names.emplace_back();
+    const std::size_t track_count = tracks.names.size();
 
-            ++lines_total;
+    using Clock = std::chrono::steady_clock;
+    const auto run_start  = Clock::now();
+    const auto elapsed_ns = [](Clock::time_point since) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count();
+    };
 
-            // Pass 1 — checksum.
-            auto cs_result = verify_checksum(line);
-            if (cs_result == ChecksumResult::kIncomplete) {
-                ++parse_fail;
-                continue;
+    std::vector<TrackRoute> routes;   // one per track with records, in track order
+    IngestCounters          counters;
+    StageTimes&             timing = counters.timing;
+    std::size_t             records_parsed = 0;
+    std::size_t             late_dropped   = 0;
+    std::size_t             future_dropped = 0;
+    std::int64_t            ingest_ns      = 0;
+
+    if (opts.stream) {
+        // ── Stages 1+2, streaming: parse → windowed LWW → spatial filter,
+        //    one record at a time; nothing but the routes is retained.
+        //    Each track has its own window and filter: a Pipeline with
+        //    the runtime config, fed decoded records.  Spatial dedup
+        //    runs inside the LWW sink, so its time is reported under
+        //    temporal dedup; only --simplify, which needs the whole
+        //    route, is timed as the spatial stage.  --pipeline runs the
+        //    reading and parsing on other threads and times the sink
+        //    itself.  --checkpoint restores each track's route and
+        //    pipeline state from the last run, reads only what was
+        //    appended since and saves the state again before the
+        //    windows are flushed.
+        RuntimePipelineConfig route_config;
+        route_config.window_ms = opts.window_ms.value_or(kDefaultReorderWindowMs);
+        route_config.spatial   = opts.spatial;
+        struct TrackStream {
+            TrackRoute                                  result;
+            Pipeline<RuntimePipelineConfig, VectorSink> route;
+
+            TrackStream(std::uint32_t track, const RuntimePipelineConfig& config)
+                : route(VectorSink{&result.route}, config)
+            {
+                result.track = track;
             }
-            if (cs_result == ChecksumResult::kMismatch) {
-                ++checksum_fail;
-                continue;
+        };
+        std::vector<std::unique_ptr<TrackStream>> streams(track_count);
+        const RecordSink push = [&](const GpsRecord& rec) {
+            ++records_parsed;
+            auto& ts = streams[rec.track];
+            if (!ts)
+                ts = std::make_unique<TrackStream>(rec.track, route_config);
+            ++ts->result.records;
+            ts->route.push(rec);
+        };
+        const bool          resume      = !opts.checkpoint.empty();
+        const std::uint64_t fingerprint = checkpoint_fingerprint(opts.ingest, route_config);
+        std::vector<std::uint64_t> offsets;
+        if (resume) {
+            Checkpoint  cp;
+            std::string why;
+            if (load_checkpoint(opts.checkpoint, cp, why) &&
+                checkpoint_matches(cp, fingerprint, opts.inputs, why)) {
+                for (const InputMark& mark : cp.inputs)
+                    offsets.push_back(mark.offset);
+                counters += cp.counters;
+                for (TrackCheckpoint& t : cp.tracks) {
+                    if (t.track >= track_count)
+                        continue;
+                    auto& ts = streams[t.track];
+                    ts = std::make_unique<TrackStream>(t.track, route_config);
+                    ts->result.records = t.records;
+                    ts->result.route   = std::move(t.route);
+                    ts->route.restore(t.state);
+                    records_parsed += t.records;
+                }
+            } else if (!why.empty()) {
+                std::cerr << "Warning: ignoring checkpoint '" << opts.checkpoint << "': " << why
+                          << "; reading the inputs from the start.\n";
             }
-
-            // Classify known-but-unsupported sentence types.
-            if (is_not_relevant(line)) {
-                ++not_relevant;
-                continue;
+        }
+        const auto start = Clock::now();
+        if (opts.pipeline)
+            pipeline_files(opts.inputs, opts.ingest, push, counters);
+        else
+            stream_files(opts.inputs, opts.ingest, push, counters, resume ? &offsets : nullptr);
+        if (resume) {
+            Checkpoint cp;
+            cp.options  = fingerprint;
+            cp.counters = counters;
+            for (std::size_t i = 0; i < opts.inputs.size(); ++i) {
+                InputMark& mark = cp.inputs.emplace_back();
+                if (!mark_input(opts.inputs[i], offsets[i], mark)) {
+                    mark.path   = opts.inputs[i];   // unreadable: checked again next run
+                    mark.offset = offsets[i];
+                }
             }
-
-            // Pass 2 — field validation & extraction.
-            GpsRecord rec{};
-            if (!parse_gprmc(line, rec)) {
-                ++parse_fail;
+            for (const auto& ts : streams)
+                if (ts)
+                    cp.tracks.push_back({ts->result.track, ts->result.records,
+                                         ts->route.state(), ts->result.route});
+            if (!save_checkpoint(cp, opts.checkpoint, error)) {
+                std::cerr << "Error: " << error << '\n';
+                return 1;
+            }
+        }
+        std::size_t after_lww = 0;
+        for (auto& ts : streams) {
+            if (!ts)
                 continue;
+            ts->route.flush();
+            const PipelineCounters& c = ts->route.counters();
+            ts->result.after_lww     = c.after_lww;
+            ts->result.after_spatial = c.route_points;
+            late_dropped   += c.late_dropped;
+            future_dropped += c.future_dropped;
+            after_lww    += ts->result.after_lww;
+        }
+        if constexpr (kStatsEnabled) {
+            ingest_ns = elapsed_ns(start);
+            if (!opts.pipeline) {
+                std::int64_t parse_ns = 0;
+                for (Stage s : {Stage::kRead, Stage::kChecksum, Stage::kClassify, Stage::kParse})
+                    parse_ns += timing[s].ns;
+                timing[Stage::kTemporalDedup].ns = ingest_ns - parse_ns;
+            }
+            timing[Stage::kTemporalDedup].items = records_parsed;
+            for (Stage s : {Stage::kRead, Stage::kChecksum, Stage::kClassify, Stage::kParse,
+                            Stage::kTemporalDedup, Stage::kSpatialDedup})
+                mark_peak_rss(timing[s]);
+        }
+        {
+            StageTimer timer(timing[Stage::kSpatialDedup]);
+            for (auto& ts : streams) {
+                if (!ts)
+                    continue;
+                if (opts.spatial.simplify != SimplifyAlgorithm::kNone)
+                    ts->result.route = simplify_route(ts->result.route, opts.spatial);
+                routes.push_back(std::move(ts->result));
             }
+        }
+        timing[Stage::kSpatialDedup].items = after_lww;
+        mark_peak_rss(timing[Stage::kSpatialDedup]);
+    } else {
+        // ── Stage 1: Read & parse ───────────────────────────────────────
+        //    Records and chunk buffers live in one arena that is released
+        //    as soon as the routes have been copied out.
+        Arena arena;
+        const auto start = Clock::now();
+        const Span<GpsRecord> all_records = ingest_files(opts.inputs, opts.ingest, arena, counters);
+        ingest_ns = elapsed_ns(start);
+        records_parsed = all_records.size();
+        for (Stage s : {Stage::kRead, Stage::kChecksum, Stage::kClassify, Stage::kParse})
+            mark_peak_rss(timing[s]);
 
-            all_records.push_back(std::move(rec));
+        // ── Stage 2: Deduplication ──────────────────────────────────────
+        //    Both passes compact the arena records in place, so the only
+        //    second copy is the final route.  With tracks, each track's
+        //    slice goes through both passes as one task on its own thread.
+        if (tracked) {
+            routes = dedup_tracks(all_records, track_count, opts.dedup_engine, opts.spatial,
+                                  resolve_jobs(opts.ingest.jobs), arena, timing);
+            mark_peak_rss(timing[Stage::kTemporalDedup]);
+        } else {
+            TrackRoute r;
+            r.records = records_parsed;
+            {
+                StageTimer timer(timing[Stage::kTemporalDedup]);
+                r.after_lww = dedup_last_write_wins_in_place(all_records, opts.dedup_engine);
+            }
+            timing[Stage::kTemporalDedup].items = records_parsed;
+            mark_peak_rss(timing[Stage::kTemporalDedup]);
+            {
+                StageTimer timer(timing[Stage::kSpatialDedup]);
+                r.after_spatial = dedup_spatial_metric_in_place(
+                    Span<GpsRecord>(all_records.data(), r.after_lww), opts.spatial);
+                r.route.assign(all_records.begin(), all_records.begin() + r.after_spatial);
+                if (opts.spatial.simplify != SimplifyAlgorithm::kNone)
+                    r.route = simplify_route(r.route, opts.spatial);
+            }
+            timing[Stage::kSpatialDedup].items = r.after_lww;
+            routes.push_back(std::move(r));
         }
+        mark_peak_rss(timing[Stage::kSpatialDedup]);
     }
 
-    // ── Stage 2: Deduplication ──────────────────────────────────────────
-    auto deduped = dedup_last_write_wins(all_records);
-    auto route   = dedup_spatial(deduped, kSpatialEpsilon);
+    std::size_t after_lww = 0, after_spatial = 0, simplified = 0;
+    for (const TrackRoute& r : routes) {
+        after_lww     += r.after_lww;
+        after_spatial += r.after_spatial;
+        simplified    += r.route.size();
+    }
+
+    // ── Query: --from / --to / --bbox keep the matching points of each
+    //    route, by one linear pass (one query does not repay an index);
+    //    everything below sees only those.  --export-index builds and
+    //    saves the index of the route exported, for later queries.
+    std::vector<std::size_t> unqueried(routes.size());   // per route, before the query
+    std::vector<RouteIndex>  indexes(routes.size());
+    std::size_t              route_points = simplified;
+    if (opts.query.active() || !opts.export_index.empty()) {
+        StageTimer timer(timing[Stage::kOutput]);
+        route_points = 0;
+        for (std::size_t i = 0; i < routes.size(); ++i) {
+            std::vector<GpsRecord>& route = routes[i].route;
+            unqueried[i] = route.size();
+            if (opts.query.active())
+                route = select_route(route, opts.query);
+            if (!opts.export_index.empty())
+                indexes[i] = RouteIndex(route);
+            route_points += route.size();
+        }
+    }
 
     // ── Stage 3: Populate gpsd structs & print ──────────────────────────
-    std::cout << "=== Processing Summary ===\n"
-              << "  Total lines read     : " << lines_total << '\n'
-              << "  Checksum failures    : " << checksum_fail << '\n'
-              << "  Not relevant (skipped): " << not_relevant << '\n'
-              << "  Parse/validation fail: " << parse_fail << '\n'
-              << "  Valid records parsed : " << all_records.size() << '\n'
-              << "  After timestamp dedup: " << deduped.size() << '\n'
-              << "  After spatial dedup  : " << route.size() << '\n'
-              << '\n';
-
-    if (route.empty()) {
-        std::cout << "No valid GPS points found.\n";
-        return 0;
+    //    Skipped when an export writes to stdout, which then carries
+    //    nothing but that export.
+    if (!opts.data_to_stdout) {
+        std::cout << "=== Processing Summary ===\n"
+                  << "  Total lines read     : " << counters.lines_total << '\n';
+        if (opts.line_types)
+            print_line_types(std::cout, counters);
+        std::cout << "  Checksum failures    : " << counters.checksum_fail << '\n'
+                  << "  Not relevant (skipped): " << counters.not_relevant << '\n'
+                  << "  Parse/validation fail: " << counters.parse_fail << '\n';
+        if (opts.ingest.fusion.enabled)
+            std::cout << "  GGA/GSA decoded      : " << counters.epoch_lines << '\n'
+                      << "  Fused with GGA/GSA   : " << counters.fused << '\n'
+                      << "  Quality rejected     : " << counters.quality_rejected << '\n';
+        if (!opts.ingest.cache_dir.empty())
+            std::cout << "  Parse cache hits     : " << counters.cache_hits << " of "
+                      << counters.cache_hits + counters.cache_misses << " inputs\n";
+        std::cout << "  Valid records parsed : " << records_parsed << '\n';
+        if (opts.stream)
+            std::cout << "  Late (past window)   : " << late_dropped << '\n';
+        if (future_dropped)
+            std::cout << "  Future (unconfirmed) : " << future_dropped << '\n';
+        std::cout << "  After timestamp dedup: " << after_lww << '\n'
+                  << "  After spatial dedup  : " << after_spatial << '\n';
+        if (opts.spatial.simplify != SimplifyAlgorithm::kNone)
+            std::cout << "  After simplification : " << simplified << '\n';
+        if (opts.query.active())
+            std::cout << "  Query matches        : " << route_points << '\n';
+        if (tracked)
+            std::cout << "  Tracks               : " << routes.size() << '\n';
+        std::cout << '\n';
+
+        {
+            StageTimer timer(timing[Stage::kOutput]);
+            std::cout.flush();
+            FdWriter          out(kStdoutFd);
+            RouteTablePrinter printer(out);
+            for (std::size_t i = 0; i < routes.size(); ++i) {
+                const TrackRoute& r = routes[i];
+                if (tracked) {
+                    if (i > 0)
+                        out.put('\n');
+                    out.write("=== Track: ");
+                    out.write(tracks.names[r.track]);
+                    out.write(" ===\n  Valid records parsed : ");
+                    out.number(r.records);
+                    out.write("\n  After timestamp dedup: ");
+                    out.number(r.after_lww);
+                    out.write("\n  After spatial dedup  : ");
+                    out.number(r.after_spatial);
+                    if (opts.spatial.simplify != SimplifyAlgorithm::kNone) {
+                        out.write("\n  After simplification : ");
+                        out.number(opts.query.active() ? unqueried[i] : r.route.size());
+                    }
+                    if (opts.query.active()) {
+                        out.write("\n  Query matches        : ");
+                        out.number(r.route.size());
+                    }
+                    out.write("\n\n");
+                }
+                if (!r.route.empty())
+                    print_route(out, printer, r.route, opts.url_waypoints);
+            }
+            out.flush();
+        }
     }
+    if (route_points == 0)
+        (opts.data_to_stdout ? std::cerr : std::cout) << (simplified == 0 ? "No valid GPS points found.\n"
+                                      : "No route points match the query.\n");
+    timing[Stage::kOutput].items = route_points;
+    mark_peak_rss(timing[Stage::kOutput]);
 
-    std::cout << std::fixed << std::setprecision(kDisplayPrecision);
-    std::cout << "=== Route Points ===\n";
-    std::cout << std::left
-              << std::setw(kColIndex) << "#"
-              << std::setw(kColCoord) << "Latitude"
-              << std::setw(kColCoord) << "Longitude"
-              << "Speed (m/s)\n";
-    std::cout << std::string(kSeparatorWidth, '-') << '\n';
-
-    for (std::size_t i = 0; i < route.size(); ++i) {
-        // Access lat/lon from ntrip_stream_t, speed from gps_device_t
-        const ntrip_stream_t& ns = route[i].stream;
-        gps_device_t dev{};
-        dev.gpsdata.fix.speed = route[i].gpsdata.fix.speed;
-
-        std::cout << std::setw(kColIndex) << (i + 1)
-                  << std::setw(kColCoord) << ns.latitude
-                  << std::setw(kColCoord) << ns.longitude
-                  << dev.gpsdata.fix.speed << '\n';
+    {
+        // ── Exports: written even for an empty route, so downstream jobs
+        //    always find their file.  With tracks, one file per track.
+        StageTimer timer(timing[Stage::kOutput]);
+        bool ok = true;
+        if (!tracked)
+            ok = routes.empty() ? export_route(opts, {}, RouteIndex{}, {}, error)
+                                : export_route(opts, routes[0].route, indexes[0], {}, error);
+        for (std::size_t i = 0; ok && tracked && i < routes.size(); ++i)
+            ok = export_route(opts, routes[i].route, indexes[i], tracks.names[routes[i].track],
+                              error);
+        if (!ok) {
+            std::cerr << "Error: " << error << '\n';
+            return 1;
+        }
     }
 
-    std::cout << "\n=== Google Maps URL ===\n"
-              << build_google_maps_url(route) << '\n';
+    if (opts.stats || !opts.stats_json.empty()) {
+        StatsReport report;
+        report.mode        = opts.pipeline ? "pipeline" : opts.stream ? "stream" : "batch";
+        report.jobs        = opts.stream && !opts.pipeline ? 1 : resolve_jobs(opts.ingest.jobs);
+        report.wall_ns     = elapsed_ns(run_start);
+        report.ingest_ns   = ingest_ns;
+        report.input_bytes = timing[Stage::kRead].bytes;
+        report.lines       = counters.lines_total;
+        report.peak_rss_kb = peak_rss_kb();
+        report.stages      = timing;
+        report.rejects     = counters.rejects;
+        report.inputs      = opts.inputs;
+
+        if (opts.stats)
+            print_stats_table(report, opts.data_to_stdout ? std::cerr : std::cout);
+        if (!opts.stats_json.empty() &&
+            !write_stats_json(report, opts.stats_json, error)) {
+            std::cerr << "Error: " << error << '\n';
+            return 1;
+        }
+    }
 
     return 0;
 }
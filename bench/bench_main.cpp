@@ -0,0 +1,445 @@
+/*
+ * bench_main.cpp — Microbenchmarks for the parser, dedup and output stages
+ *
+ * Build:  make bench     (produces build/bench/nmea_bench and runs it)
+ * Usage:  ./nmea_bench [--size BYTES] [--seed N] [--filter SUBSTR]
+ *
+ * Every benchmark runs over the same synthetic corpus (see synth.h) so the
+ * numbers are comparable between stages and across commits.
+ */
+
+#include "arena.h"
+#include "codec.h"
+#include "dedup.h"
+#include "ingest.h"
+#include "nmea_parser.h"
+#include "output.h"
+#include "pipeline.h"
+#include "query.h"
+#include "reader.h"
+#include "reject.h"
+#include "ring.h"
+#include "route_io.h"
+#include "scan.h"
+#include "spatial.h"
+#include "synth.h"
+#include "track.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef NMEA_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef NMEA_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// ─── Harness ────────────────────────────────────────────────────────────────
+
+static constexpr double      kMinSeconds   = 0.25;   // per benchmark
+static constexpr std::size_t kDefaultBytes = 8u << 20;
+
+/// Defeat dead-code elimination of benchmark results.
+static volatile std::size_t g_sink;
+
+struct BenchCase {
+    const char*                  name;
+    std::size_t                  items;   // items processed per iteration
+    std::size_t                  bytes;   // bytes processed per iteration (0 = n/a)
+    std::function<std::size_t()> body;
+};
+
+static void run_case(const BenchCase& c)
+{
+    using Clock = std::chrono::steady_clock;
+    std::size_t iters = 0;
+    const auto  start = Clock::now();
+    double      secs  = 0.0;
+    do {
+        g_sink = g_sink + c.body();
+        ++iters;
+        secs = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (secs < kMinSeconds);
+
+    const double items = static_cast<double>(c.items) * static_cast<double>(iters);
+    std::printf("%-28s %10.1f ns/item %12.3f Mitems/s", c.name,
+                secs * 1e9 / items, items / secs / 1e6);
+    if (c.bytes)
+        std::printf(" %9.1f MB/s",
+                    static_cast<double>(c.bytes) * static_cast<double>(iters) / secs / 1e6);
+    std::printf("\n");
+}
+
+// ─── Compressed corpus ─────────────────────────────────────────────────────
+
+#ifdef NMEA_HAVE_ZLIB
+/// `text` as one gzip member at zlib's default level.
+static std::string gzip_bytes(std::string_view text)
+{
+    z_stream z{};
+    deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&z, static_cast<uLong>(text.size())), '\0');
+    z.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(text.data()));
+    z.avail_in  = static_cast<uInt>(text.size());
+    z.next_out  = reinterpret_cast<Bytef*>(out.data());
+    z.avail_out = static_cast<uInt>(out.size());
+    deflate(&z, Z_FINISH);
+    out.resize(z.total_out);
+    deflateEnd(&z);
+    return out;
+}
+#endif
+
+#ifdef NMEA_HAVE_ZSTD
+/// `text` as one zstd frame at the library's default level.
+static std::string zstd_bytes(std::string_view text)
+{
+    std::string out(ZSTD_compressBound(text.size()), '\0');
+    const std::size_t n = ZSTD_compress(out.data(), out.size(), text.data(), text.size(),
+                                        ZSTD_CLEVEL_DEFAULT);
+    out.resize(ZSTD_isError(n) ? 0 : n);
+    return out;
+}
+#endif
+
+/// Decode `data` block by block on the calling thread.
+static std::size_t decode_blocks(std::string_view data)
+{
+    BlockDecoder decoder(data, detect_compression(data));
+    DecodedBlock block;
+    std::size_t  bytes = 0;
+    while (decoder.next(block))
+        bytes += block.text().size();
+    return bytes;
+}
+
+/// Parse `data` as ingest does a compressed input: decoding on a
+/// DecodeStream thread, parsing each block as it arrives.
+static std::size_t decode_and_ingest(std::string_view data)
+{
+    DecodeStream stream(data, detect_compression(data));
+    DecodedBlock block;
+    const IngestOptions opts;
+    IngestCounters counters;
+    std::vector<GpsRecord> out;
+    while (stream.next(block))
+        ingest_buffer(block.text(), opts, block.lookback_text(), out, counters);
+    return out.size();
+}
+
+// ─── Main ───────────────────────────────────────────────────────────────────
+
+int main(int argc, char* argv[])
+{
+    SynthOptions opts;
+    std::size_t  bytes = kDefaultBytes;
+    std::string  filter;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string_view arg = argv[i];
+        if      (arg == "--size")   bytes = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (arg == "--seed")   opts.seed = std::strtoull(argv[i + 1], nullptr, 10);
+        else if (arg == "--filter") filter = argv[i + 1];
+        else {
+            std::fprintf(stderr, "Usage: %s [--size BYTES] [--seed N] [--filter SUBSTR]\n",
+                         argv[0]);
+            return 1;
+        }
+    }
+
+    // Build the corpus and its derived inputs once.
+    std::string corpus;
+    NmeaSynth(opts).generate_bytes(bytes, corpus);
+
+    std::vector<std::string_view> lines;
+    std::vector<std::string_view> rmc_lines;
+    LineCursor cursor(corpus);
+    for (std::string_view line; cursor.next(line);) {
+        lines.push_back(line);
+        if (line.size() > 6 && line.substr(3, 3) == "RMC")
+            rmc_lines.push_back(line);
+    }
+
+    std::vector<GpsRecord> records;
+    IngestCounters counters;
+    ingest_buffer(corpus, records, counters);
+    const std::vector<GpsRecord> unique = dedup_last_write_wins(records);
+    const std::vector<GpsRecord> route  = dedup_spatial(unique, kSpatialEpsilon);
+
+    std::printf("corpus: %zu bytes, %zu lines, %zu records, %zu unique, %zu route points\n",
+                corpus.size(), lines.size(), records.size(), unique.size(), route.size());
+    std::printf("scan kernel: %s\n\n", scan_kernel_name());
+
+    std::vector<ChecksumResult> results(lines.size());
+    Arena scratch;   // reset per iteration, so blocks are reused warm
+
+    // The corpus dealt round-robin onto kBenchTracks tracks.
+    constexpr std::size_t kBenchTracks = 8;
+    std::vector<GpsRecord> tracked = records;
+    for (std::size_t i = 0; i < tracked.size(); ++i)
+        tracked[i].track = static_cast<std::uint32_t>(i % kBenchTracks);
+    std::vector<GpsRecord> work;
+
+    // Records handed between two threads, kBenchRingBatch per push/pop.
+    constexpr std::size_t kBenchRingSlots = 1024;
+    constexpr std::size_t kBenchRingBatch = 64;
+    const int null_fd = ::open("/dev/null", O_WRONLY);
+
+    // Route files for the reload benchmarks, one per encoding.
+    const std::filesystem::path tmp = std::filesystem::temp_directory_path();
+    const std::string raw_route   = (tmp / "nmea_bench_raw.nrt").string();
+    const std::string delta_route = (tmp / "nmea_bench_delta.nrt").string();
+    std::string io_error;
+    write_route_binary(route, raw_route, RouteEncoding::kRaw, io_error);
+    write_route_binary(route, delta_route, RouteEncoding::kDelta, io_error);
+
+    // Queries over the route: time windows of 1/kBenchQueries of its span,
+    // alternating with ~200 m boxes around evenly spaced points.
+    constexpr std::size_t  kBenchQueries  = 64;
+    constexpr std::int32_t kBenchBoxUnits = 10'000;   // 1e-3 degree
+    std::vector<RouteQuery> queries;
+    if (!route.empty()) {
+        const std::int64_t t0   = route.front().timestamp_ms;
+        const std::int64_t step = (route.back().timestamp_ms - t0) / kBenchQueries + 1;
+        for (std::size_t q = 0; q < kBenchQueries; ++q) {
+            RouteQuery& query = queries.emplace_back();
+            const GpsRecord& at = route[q * route.size() / kBenchQueries];
+            if (q % 2 == 0) {
+                query.from_ms = t0 + static_cast<std::int64_t>(q) * step;
+                query.to_ms   = *query.from_ms + step;
+            } else {
+                query.bbox = GeoBox{at.lat_e7 - kBenchBoxUnits, at.lon_e7 - kBenchBoxUnits,
+                                    at.lat_e7 + kBenchBoxUnits, at.lon_e7 + kBenchBoxUnits};
+            }
+        }
+    }
+    const RouteIndex route_index(route);
+
+    std::vector<BenchCase> cases = {
+        {"verify_checksum", lines.size(), corpus.size(), [&] {
+             std::size_t ok = 0;
+             for (std::string_view l : lines)
+                 ok += verify_checksum(l) == ChecksumResult::kOk;
+             return ok;
+         }},
+        {"verify_checksum_batch", lines.size(), corpus.size(), [&] {
+             verify_checksum_batch(lines.data(), lines.size(), results.data());
+             return static_cast<std::size_t>(results.back());
+         }},
+        {"is_not_relevant", lines.size(), corpus.size(), [&] {
+             std::size_t n = 0;
+             for (std::string_view l : lines)
+                 n += is_not_relevant(l);
+             return n;
+         }},
+        {"parse_gprmc", rmc_lines.size(), 0, [&] {
+             std::size_t n = 0;
+             GpsRecord rec;
+             for (std::string_view l : rmc_lines)
+                 n += parse_gprmc(l, rec);
+             return n;
+         }},
+        {"ingest_buffer", lines.size(), corpus.size(), [&] {
+             std::vector<GpsRecord> out;
+             IngestCounters c;
+             ingest_buffer(corpus, out, c);
+             return out.size();
+         }},
+        {"ingest_buffer[fast-reject]", lines.size(), corpus.size(), [&] {
+             std::vector<GpsRecord> out;
+             IngestCounters c;
+             IngestOptions o;
+             o.checksum = ChecksumPolicy::kRelevant;
+             ingest_buffer(corpus, o, {}, out, c);
+             return out.size();
+         }},
+        {"pipeline[edge]", lines.size(), corpus.size(), [&] {
+             std::vector<GpsRecord> route;
+             Pipeline<EdgePipelineConfig, VectorSink> p(VectorSink{&route});
+             p.feed(corpus);
+             p.flush();
+             return route.size();
+         }},
+        {"pipeline[default]", lines.size(), corpus.size(), [&] {
+             std::vector<GpsRecord> route;
+             Pipeline<DefaultPipelineConfig, VectorSink> p(VectorSink{&route});
+             p.feed(corpus);
+             p.flush();
+             return route.size();
+         }},
+        {"pipeline[runtime]", lines.size(), corpus.size(), [&] {
+             std::vector<GpsRecord> route;
+             Pipeline<RuntimePipelineConfig, VectorSink> p(VectorSink{&route});
+             p.feed(corpus);
+             p.flush();
+             return route.size();
+         }},
+        {"reject_stats_add", lines.size(), 0, [&] {
+             RejectStats r;
+             std::uint64_t at = 0;
+             for (std::string_view line : lines) {
+                 r.add(RejectReason::kBadTime, SentenceType::kRMC, line, {0, at});
+                 at += line.size() + 1;
+             }
+             return r.total();
+         }},
+        {"dedup_lww[map]", records.size(), 0, [&] {
+             return dedup_last_write_wins(records, DedupEngine::kOrderedMap).size();
+         }},
+        {"dedup_lww[sort]", records.size(), 0, [&] {
+             return dedup_last_write_wins(records, DedupEngine::kSortUnique).size();
+         }},
+        {"dedup_lww[hash]", records.size(), 0, [&] {
+             return dedup_last_write_wins(records, DedupEngine::kHashTable).size();
+         }},
+        {"dedup_lww_indices[sort]", records.size(), 0, [&] {
+             scratch.reset();
+             return dedup_last_write_wins_indices(records, scratch).size();
+         }},
+        {"dedup_lww_indices[hash]", records.size(), 0, [&] {
+             scratch.reset();
+             return dedup_last_write_wins_indices(records, scratch, DedupEngine::kHashTable).size();
+         }},
+        {"dedup_tracks[8]", records.size(), 0, [&] {
+             scratch.reset();
+             work = tracked;
+             StageTimes timing;
+             return dedup_tracks(work, kBenchTracks, kDefaultDedupEngine, SpatialOptions{}, 1,
+                                 scratch, timing).size();
+         }},
+        {"spsc_ring[batch 64]", records.size(), 0, [&] {
+             SpscRing<GpsRecord> ring(kBenchRingSlots);
+             std::thread producer([&] {
+                 std::vector<GpsRecord> batch(kBenchRingBatch);
+                 for (std::size_t i = 0; i < records.size(); i += kBenchRingBatch) {
+                     const std::size_t n = std::min(kBenchRingBatch, records.size() - i);
+                     std::copy(records.begin() + i, records.begin() + i + n, batch.begin());
+                     ring.push(batch.data(), n);
+                 }
+                 ring.close();
+             });
+             GpsRecord   batch[kBenchRingBatch];
+             std::size_t received = 0;
+             while (const std::size_t n = ring.pop(batch, kBenchRingBatch))
+                 received += n;
+             producer.join();
+             return received;
+         }},
+        {"dedup_spatial", unique.size(), 0, [&] {
+             return dedup_spatial(unique, kSpatialEpsilon).size();
+         }},
+        {"dedup_spatial_metric[degrees]", unique.size(), 0, [&] {
+             return dedup_spatial_metric(unique, SpatialOptions{}).size();
+         }},
+        {"dedup_spatial_metric[equirect]", unique.size(), 0, [&] {
+             SpatialOptions o;
+             o.metric = SpatialMetric::kEquirectangular;
+             return dedup_spatial_metric(unique, o).size();
+         }},
+        {"dedup_spatial_metric[haversine]", unique.size(), 0, [&] {
+             SpatialOptions o;
+             o.metric = SpatialMetric::kHaversine;
+             return dedup_spatial_metric(unique, o).size();
+         }},
+        {"simplify_douglas_peucker", route.size(), 0, [&] {
+             return simplify_douglas_peucker(route, kDefaultDpToleranceM).size();
+         }},
+        {"simplify_visvalingam", route.size(), 0, [&] {
+             return simplify_visvalingam(route, kDefaultVwAreaM2).size();
+         }},
+        {"build_google_maps_url", route.size(), 0, [&] {
+             return build_google_maps_url(route).size();
+         }},
+        {"write_google_maps_urls[25]", route.size(), 0, [&] {
+             FdWriter out(null_fd);
+             return write_google_maps_urls(out, route, kGoogleMapsMaxWaypoints);
+         }},
+        {"fdwriter_fixed", route.size(), 0, [&] {
+             FdWriter out(null_fd);
+             for (const GpsRecord& r : route) {
+                 out.coord(r.lat_e7, 6, 14);
+                 out.coord(r.lon_e7, 6, 14);
+                 out.fixed(r.speed, 6);
+                 out.put('\n');
+             }
+             return static_cast<std::size_t>(out.flush());
+         }},
+        {"write_route_binary[raw]", route.size(), 0, [&] {
+             return static_cast<std::size_t>(
+                 write_route_binary(route, "/dev/null", RouteEncoding::kRaw, io_error));
+         }},
+        {"write_route_binary[delta]", route.size(), 0, [&] {
+             return static_cast<std::size_t>(
+                 write_route_binary(route, "/dev/null", RouteEncoding::kDelta, io_error));
+         }},
+        {"write_route_csv", route.size(), 0, [&] {
+             return static_cast<std::size_t>(write_route_csv(route, "/dev/null", io_error));
+         }},
+        {"route_file_columns[raw]", route.size(), 0, [&] {
+             RouteFile file;
+             std::int64_t sum = 0;
+             if (file.open(raw_route, io_error))
+                 for (std::size_t i = 0; i < file.size(); ++i)
+                     sum += file.columns().lat_e7[i];
+             return static_cast<std::size_t>(sum);
+         }},
+        {"route_file_load[raw]", route.size(), 0, [&] {
+             std::vector<GpsRecord> out;
+             read_route_binary(raw_route, out, io_error);
+             return out.size();
+         }},
+        {"route_file_load[delta]", route.size(), 0, [&] {
+             std::vector<GpsRecord> out;
+             read_route_binary(delta_route, out, io_error);
+             return out.size();
+         }},
+        {"route_index_build", route.size(), 0, [&] {
+             return RouteIndex(route).size();
+         }},
+        {"route_query[index]", queries.size(), 0, [&] {
+             std::size_t hits = 0;
+             for (const RouteQuery& q : queries)
+                 hits += route_index.find(route, q).size();
+             return hits;
+         }},
+        {"route_query[scan]", queries.size(), 0, [&] {
+             std::size_t hits = 0;
+             for (const RouteQuery& q : queries)
+                 for (const GpsRecord& r : route)
+                     hits += q.matches(r);
+             return hits;
+         }},
+    };
+
+    // Compressed inputs, for each format this build decodes.
+#ifdef NMEA_HAVE_ZLIB
+    const std::string gz = gzip_bytes(corpus);
+    cases.push_back({"block_decoder[gzip]", lines.size(), corpus.size(),
+                     [&] { return decode_blocks(gz); }});
+    cases.push_back({"decode_stream+ingest[gzip]", lines.size(), corpus.size(),
+                     [&] { return decode_and_ingest(gz); }});
+#endif
+#ifdef NMEA_HAVE_ZSTD
+    const std::string zst = zstd_bytes(corpus);
+    cases.push_back({"block_decoder[zstd]", lines.size(), corpus.size(),
+                     [&] { return decode_blocks(zst); }});
+    cases.push_back({"decode_stream+ingest[zstd]", lines.size(), corpus.size(),
+                     [&] { return decode_and_ingest(zst); }});
+#endif
+
+    for (const BenchCase& c : cases)
+        if (filter.empty() || std::string_view(c.name).find(filter) != std::string_view::npos)
+            run_case(c);
+    std::filesystem::remove(raw_route);
+    std::filesystem::remove(delta_route);
+    return 0;
+}
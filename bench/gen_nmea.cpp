@@ -0,0 +1,123 @@
+/*
+ * gen_nmea.cpp — Synthetic NMEA capture generator
+ *
+ * Build:  make bench     (produces build/bench/nmea_gen)
+ * Usage:  ./nmea_gen --size 2G -o day.nmea [--dup-rate R] [--incomplete-rate R]
+ *                    [--gga-rate R] [--gsa-rate R] [--seed N]
+ */
+
+#include "synth.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+// ─── Generator CLI constants ───────────────────────────────────────────────
+
+static constexpr std::size_t kFlushBytes   = 1u << 20;   // write in ~1 MiB blocks
+static constexpr std::size_t kDefaultBytes = 1u << 20;
+
+/// Parse "123", "64K", "512M", "2G" into bytes.
+static bool parse_size(const std::string& text, std::size_t& out)
+{
+    char* end = nullptr;
+    unsigned long long v = std::strtoull(text.c_str(), &end, 10);
+    if (end == text.c_str())
+        return false;
+    switch (*end) {
+    case '\0':           break;
+    case 'K': case 'k':  v <<= 10; ++end; break;
+    case 'M': case 'm':  v <<= 20; ++end; break;
+    case 'G': case 'g':  v <<= 30; ++end; break;
+    default:             return false;
+    }
+    if (*end != '\0')
+        return false;
+    out = static_cast<std::size_t>(v);
+    return true;
+}
+
+static bool parse_rate(const std::string& text, double& out)
+{
+    char* end = nullptr;
+    out = std::strtod(text.c_str(), &end);
+    return end != text.c_str() && *end == '\0' && out >= 0.0 && out <= 1.0;
+}
+
+static void print_usage(const char* prog)
+{
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  -o FILE               output file (default stdout)\n"
+              << "  --size BYTES[K|M|G]   amount to generate (default 1M)\n"
+              << "  --epochs N            generate exactly N epochs instead\n"
+              << "  --dup-rate R          per-epoch duplicate RMC probability (0.1)\n"
+              << "  --incomplete-rate R   per-epoch truncated RMC probability (0.1)\n"
+              << "  --gga-rate R          per-epoch $GPGGA probability (1.0)\n"
+              << "  --gsa-rate R          per-epoch $GPGSA probability (1.0)\n"
+              << "  --seed N              RNG seed (1)\n";
+}
+
+int main(int argc, char* argv[])
+{
+    SynthOptions opts;
+    std::size_t  bytes  = kDefaultBytes;
+    std::size_t  epochs = 0;
+    std::string  path;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        const std::string v = argv[++i];
+        bool ok = true;
+        if      (arg == "-o")                path = v;
+        else if (arg == "--size")            ok = parse_size(v, bytes);
+        else if (arg == "--epochs")          ok = parse_size(v, epochs);
+        else if (arg == "--dup-rate")        ok = parse_rate(v, opts.duplicate_rate);
+        else if (arg == "--incomplete-rate") ok = parse_rate(v, opts.incomplete_rate);
+        else if (arg == "--gga-rate")        ok = parse_rate(v, opts.gga_rate);
+        else if (arg == "--gsa-rate")        ok = parse_rate(v, opts.gsa_rate);
+        else if (arg == "--seed")            opts.seed = std::strtoull(v.c_str(), nullptr, 10);
+        else                                 ok = false;
+        if (!ok) {
+            std::cerr << "Error: bad argument '" << arg << ' ' << v << "'\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::FILE* fp = path.empty() ? stdout : std::fopen(path.c_str(), "wb");
+    if (!fp) {
+        std::cerr << "Error: cannot open '" << path << "' for writing\n";
+        return 1;
+    }
+
+    NmeaSynth   synth(opts);
+    std::string block;
+    block.reserve(kFlushBytes + 1024);
+    std::size_t written = 0;
+    std::size_t done_epochs = 0;
+    auto more = [&] { return epochs ? done_epochs < epochs : written < bytes; };
+    while (more()) {
+        block.clear();
+        while (block.size() < kFlushBytes && more()) {
+            synth.next_epoch(block);
+            ++done_epochs;
+            if (!epochs && written + block.size() >= bytes)
+                break;
+        }
+        if (std::fwrite(block.data(), 1, block.size(), fp) != block.size()) {
+            std::cerr << "Error: write failed\n";
+            return 1;
+        }
+        written += block.size();
+    }
+
+    if (fp != stdout)
+        std::fclose(fp);
+    return 0;
+}
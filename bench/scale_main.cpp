@@ -0,0 +1,535 @@
+/*
+ * scale_main.cpp — End-to-end throughput and scaling harness
+ *
+ * Build:  make bench-tools   (produces build/bench/nmea_scale)
+ * Usage:  ./nmea_scale [--bin PATH] [--data DIR] [--scales 1,10,100,1000,10000]
+ *                      [--jobs 1,2,4] [--modes batch,stream,pipeline,piped] [--repeat N]
+ *                      [--work-dir DIR] [--json FILE] [--keep]
+ *
+ * Microbenchmarks time stages in isolation; this runs the real
+ * nmea_parser binary, as a user would, on each data_for_checks/ capture
+ * (clean, duplicated lines, incomplete lines, both) amplified 1x to
+ * 10000x, in every mode and at every job count.  The modes are batch
+ * (the input file memory-mapped), --stream, --pipeline, and piped: batch
+ * reading the input from a pipe on stdin, which InputFile cannot map and
+ * reads into a buffer instead.  Every run's output is compared with the
+ * serial baseline (batch, one job) of the same input, so a run that keeps
+ * different points is a failure, not just a number.  Results go out as JSON: lines/s,
+ * MB/s, peak RSS and, against one job of the same mode, speedup and
+ * scaling efficiency.  The exit status is 1 if any output differed.
+ */
+
+#include "nmea_parser.h"
+#include "util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+// ─── Harness constants ─────────────────────────────────────────────────────
+
+static constexpr int          kRmcDateField   = 9;     // DDMMYY, after splitting on ','
+static constexpr std::size_t  kDateChars      = 6;
+static constexpr int          kCenturyPivot   = 80;    // as the parser: YY < 80 → 20YY
+static constexpr std::size_t  kChecksumChars  = 2;
+static constexpr std::size_t  kTalkerChars    = 3;     // "$GP" before the type
+static constexpr std::size_t  kPipeChunk      = 64 * 1024;
+static constexpr double       kBytesPerMB     = 1e6;
+static constexpr const char*  kLateLine       = "  Late (past window)";   // --stream only
+
+namespace {
+
+// ─── Options ────────────────────────────────────────────────────────────────
+
+struct HarnessOptions {
+    std::string              binary   = "build/nmea_parser";
+    std::string              data_dir = "data_for_checks";
+    std::vector<std::size_t> scales   = {1, 10, 100, 1000, 10000};
+    std::vector<std::size_t> jobs;                 // default: 1, 2, 4, … up to the cores
+    std::vector<std::string> modes    = {"batch", "stream", "pipeline", "piped"};
+    std::size_t              repeat   = 1;         // best of N runs
+    std::string              work_dir;             // default: <tmp>/nmea_scale
+    std::string              json     = "-";
+    bool                     keep     = false;     // leave the amplified inputs behind
+};
+
+/// Parse a comma-separated list of positive integers.
+bool parse_list(std::string_view text, std::vector<std::size_t>& out)
+{
+    out.clear();
+    while (!text.empty()) {
+        const std::size_t comma = std::min(text.find(','), text.size());
+        const std::string item(text.substr(0, comma));
+        char* end = nullptr;
+        const unsigned long long v = std::strtoull(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || v == 0)
+            return false;
+        out.push_back(static_cast<std::size_t>(v));
+        text.remove_prefix(std::min(comma + 1, text.size()));
+    }
+    return !out.empty();
+}
+
+bool parse_modes(std::string_view text, std::vector<std::string>& out)
+{
+    out.clear();
+    while (!text.empty()) {
+        const std::size_t comma = std::min(text.find(','), text.size());
+        const std::string mode(text.substr(0, comma));
+        if (mode != "batch" && mode != "stream" && mode != "pipeline" && mode != "piped")
+            return false;
+        out.push_back(mode);
+        text.remove_prefix(std::min(comma + 1, text.size()));
+    }
+    return !out.empty();
+}
+
+void print_usage(const char* prog)
+{
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  --bin PATH        nmea_parser binary (build/nmea_parser)\n"
+              << "  --data DIR        captures to amplify (data_for_checks)\n"
+              << "  --scales LIST     amplification factors (1,10,100,1000,10000)\n"
+              << "  --jobs LIST       job counts (1,2,4,… up to the core count)\n"
+              << "  --modes LIST      batch, stream, pipeline, piped (all)\n"
+              << "  --repeat N        keep the fastest of N runs (1)\n"
+              << "  --work-dir DIR    where amplified inputs go (<tmp>/nmea_scale)\n"
+              << "  --json FILE       write the report to FILE (- = stdout, default)\n"
+              << "  --keep            keep the amplified inputs\n";
+}
+
+// ─── Amplification ──────────────────────────────────────────────────────────
+
+/// Proleptic Gregorian date of a day number (inverse of days_from_civil).
+void civil_from_days(std::int64_t z, int& y, int& m, int& d)
+{
+    z += 719468;
+    const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const auto doe = static_cast<int>(z - era * 146097);                  // [0, 146096]
+    const int  yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int  doy = doe - (365 * yoe + yoe / 4 - yoe / 100);              // [0, 365]
+    const int  mp  = (5 * doy + 2) / 153;                                  // [0, 11]
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int>(yoe + era * 400) + (m <= 2);
+}
+
+int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+/// An RMC line whose date can be moved: where its date and checksum
+/// digits are, and the day the date names.  Lines without a complete
+/// date and "*HH" tail are copied unchanged.
+struct DatedLine {
+    std::size_t  date = 0, star = 0;
+    int          checksum = 0;
+    std::int64_t day = 0;
+};
+
+bool find_date(std::string_view line, DatedLine& out)
+{
+    if (line.size() < kTalkerChars + 3 || line[0] != '$' ||
+        line.substr(kTalkerChars, 3) != "RMC")
+        return false;
+    out.star = line.rfind('*');
+    if (out.star == std::string_view::npos || out.star + 1 + kChecksumChars > line.size())
+        return false;
+    const int hi = hex_value(line[out.star + 1]), lo = hex_value(line[out.star + 2]);
+    if (hi < 0 || lo < 0)
+        return false;
+    out.checksum = hi * 16 + lo;
+
+    std::size_t pos = 0;
+    for (int field = 0; field < kRmcDateField; ++field) {
+        pos = line.find(',', pos);
+        if (pos == std::string_view::npos || pos > out.star)
+            return false;
+        ++pos;
+    }
+    out.date = pos;
+    if (out.date + kDateChars > out.star || (out.date + kDateChars < out.star &&
+                                             line[out.date + kDateChars] != ','))
+        return false;
+    int digits[kDateChars];
+    for (std::size_t i = 0; i < kDateChars; ++i) {
+        const char c = line[out.date + i];
+        if (c < '0' || c > '9')
+            return false;
+        digits[i] = c - '0';
+    }
+    const int dd = digits[0] * 10 + digits[1];
+    const int mm = digits[2] * 10 + digits[3];
+    const int yy = digits[4] * 10 + digits[5];
+    out.day = days_from_civil(yy < kCenturyPivot ? 2000 + yy : 1900 + yy, mm, dd);
+    return true;
+}
+
+/// `text` repeated `scale` times.  Copy c moves every RMC date on by c
+/// times the days the capture spans, and adjusts the checksum by the
+/// bytes that changed — so a line that failed its checksum still fails —
+/// making each copy new days of the same route rather than a duplicate
+/// of the first (or, for a capture crossing midnight, an overlap).  Returns the number
+/// of lines written.
+std::size_t amplify(std::string_view text, std::size_t scale, std::ofstream& out)
+{
+    static constexpr char kHex[] = "0123456789ABCDEF";
+    struct Line {
+        std::string_view text;   // including its '\n'
+        bool             dated;
+        DatedLine        at;
+    };
+    std::vector<Line> lines;
+    for (std::size_t pos = 0; pos < text.size();) {
+        const std::size_t nl  = text.find('\n', pos);
+        const std::size_t end = nl == std::string_view::npos ? text.size() : nl + 1;
+        Line& line = lines.emplace_back();
+        line.text  = text.substr(pos, end - pos);
+        line.dated = find_date(line.text, line.at);
+        pos = end;
+    }
+    if (!text.empty() && text.back() != '\n')
+        lines.push_back({"\n", false, {}});
+    bool         dated     = false;
+    std::int64_t first_day = 0, last_day = 0;
+    for (const Line& line : lines) {
+        if (!line.dated)
+            continue;
+        first_day = dated ? std::min(first_day, line.at.day) : line.at.day;
+        last_day  = dated ? std::max(last_day, line.at.day) : line.at.day;
+        dated     = true;
+    }
+    const std::int64_t span = last_day - first_day + 1;   // days per copy
+
+    std::string copy;
+    for (std::size_t c = 0; c < scale; ++c) {
+        copy.clear();
+        for (const Line& line : lines) {
+            const std::size_t start = copy.size();
+            copy.append(line.text);
+            if (!line.dated || c == 0)
+                continue;
+            int y = 0, m = 0, d = 0;
+            civil_from_days(line.at.day + static_cast<std::int64_t>(c) * span, y, m, d);
+            const char date[kDateChars] = {
+                static_cast<char>('0' + d / 10), static_cast<char>('0' + d % 10),
+                static_cast<char>('0' + m / 10), static_cast<char>('0' + m % 10),
+                static_cast<char>('0' + y % 100 / 10), static_cast<char>('0' + y % 10)};
+            int checksum = line.at.checksum;
+            for (std::size_t i = 0; i < kDateChars; ++i) {
+                checksum ^= static_cast<unsigned char>(copy[start + line.at.date + i]) ^
+                            static_cast<unsigned char>(date[i]);
+                copy[start + line.at.date + i] = date[i];
+            }
+            copy[start + line.at.star + 1] = kHex[checksum >> 4];
+            copy[start + line.at.star + 2] = kHex[checksum & 0xf];
+        }
+        out.write(copy.data(), static_cast<std::streamsize>(copy.size()));
+    }
+    return lines.size() * scale;
+}
+
+// ─── Runs ───────────────────────────────────────────────────────────────────
+
+struct RunResult {
+    bool          ok          = false;   // exited with status 0
+    double        wall_s      = 0.0;
+    long          peak_rss_kb = 0;
+    std::uint64_t output_hash = 0;       // FNV-1a of stdout, mode-only lines dropped
+};
+
+/// Run `argv` with stdout to `out_path` and stderr discarded; the peak
+/// RSS is the child's own, from wait4.  With a `pipe_from` file the child
+/// reads it on stdin through a pipe (so not mapped), written by us.
+RunResult run_binary(const std::vector<std::string>& args, const std::string& out_path,
+                     const std::string& pipe_from = {})
+{
+    RunResult result;
+    std::vector<char*> argv;
+    for (const std::string& a : args)
+        argv.push_back(const_cast<char*>(a.c_str()));
+    argv.push_back(nullptr);
+
+    int fds[2] = {-1, -1};
+    if (!pipe_from.empty() && ::pipe(fds) != 0)
+        return result;
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (!pipe_from.empty()) {
+        posix_spawn_file_actions_adddup2(&actions, fds[0], 0);
+        posix_spawn_file_actions_addclose(&actions, fds[0]);
+        posix_spawn_file_actions_addclose(&actions, fds[1]);
+    }
+    posix_spawn_file_actions_addopen(&actions, 1, out_path.c_str(),
+                                     O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    pid_t pid = 0;
+    const int rc = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (!pipe_from.empty()) {
+        ::close(fds[0]);
+        if (rc == 0) {
+            std::ifstream in(pipe_from, std::ios::binary);
+            char chunk[kPipeChunk];
+            while (in.read(chunk, sizeof chunk) || in.gcount() > 0) {
+                const char* p = chunk;
+                for (std::streamsize left = in.gcount(); left > 0;) {
+                    const ssize_t n = ::write(fds[1], p, static_cast<std::size_t>(left));
+                    if (n <= 0)
+                        break;   // the child stopped reading; its status says why
+                    p += n;
+                    left -= n;
+                }
+            }
+        }
+        ::close(fds[1]);
+    }
+    if (rc != 0)
+        return result;
+    int status = 0;
+    struct rusage usage{};
+    if (wait4(pid, &status, 0, &usage) != pid)
+        return result;
+    result.wall_s      = std::chrono::duration<double>(Clock::now() - start).count();
+    result.peak_rss_kb = usage.ru_maxrss;   // KiB on Linux
+    result.ok          = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+    std::ifstream in(out_path, std::ios::binary);
+    std::uint64_t h = kFnvOffset;
+    std::string   line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, std::char_traits<char>::length(kLateLine), kLateLine) == 0)
+            continue;
+        line.push_back('\n');
+        h = fnv1a(h, line.data(), line.size());
+    }
+    result.output_hash = h;
+    return result;
+}
+
+struct Measurement {
+    std::string   corpus;
+    std::size_t   scale = 0;
+    std::string   mode;
+    std::size_t   jobs  = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t lines = 0;
+    RunResult     run;
+    double        speedup = 1.0;     // vs one job of the same mode
+    bool          matches = false;   // output equals the serial batch baseline
+};
+
+std::string json_escape(std::string_view text)
+{
+    std::string out;
+    for (const char c : text) {
+        if (c == '"' || c == '\\')
+            out.push_back('\\');
+        out.push_back(c);
+    }
+    return out;
+}
+
+void write_json(std::ostream& os, const HarnessOptions& opts,
+                const std::vector<Measurement>& results, std::size_t mismatches)
+{
+    os << std::fixed << std::setprecision(3)
+       << "{\n"
+       << "  \"binary\": \"" << json_escape(opts.binary) << "\",\n"
+       << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n"
+       << "  \"repeat\": " << opts.repeat << ",\n"
+       << "  \"mismatches\": " << mismatches << ",\n"
+       << "  \"runs\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Measurement& m = results[i];
+        const double secs = m.run.wall_s > 0 ? m.run.wall_s : 1e-9;
+        os << (i ? ",\n" : "\n")
+           << "    {\"corpus\": \"" << json_escape(m.corpus) << "\""
+           << ", \"scale\": " << m.scale
+           << ", \"mode\": \"" << m.mode << "\""
+           << ", \"jobs\": " << m.jobs
+           << ", \"input_bytes\": " << m.bytes
+           << ", \"lines\": " << m.lines
+           << ", \"wall_ms\": " << m.run.wall_s * 1e3
+           << ", \"lines_per_sec\": " << static_cast<double>(m.lines) / secs
+           << ", \"mb_per_sec\": " << static_cast<double>(m.bytes) / kBytesPerMB / secs
+           << ", \"peak_rss_kb\": " << m.run.peak_rss_kb
+           << ", \"speedup\": " << m.speedup
+           << ", \"efficiency\": " << m.speedup / static_cast<double>(m.jobs)
+           << ", \"exit_ok\": " << (m.run.ok ? "true" : "false")
+           << ", \"output_matches\": " << (m.matches ? "true" : "false") << "}";
+    }
+    os << "\n  ]\n}\n";
+}
+
+} // namespace
+
+// ─── Main ───────────────────────────────────────────────────────────────────
+
+int main(int argc, char* argv[])
+{
+    std::signal(SIGPIPE, SIG_IGN);   // a child that dies mid-input is reported, not fatal
+    HarnessOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        bool ok = true;
+        if (arg == "--bin" && has_value)
+            opts.binary = argv[++i];
+        else if (arg == "--data" && has_value)
+            opts.data_dir = argv[++i];
+        else if (arg == "--scales" && has_value)
+            ok = parse_list(argv[++i], opts.scales);
+        else if (arg == "--jobs" && has_value)
+            ok = parse_list(argv[++i], opts.jobs);
+        else if (arg == "--modes" && has_value)
+            ok = parse_modes(argv[++i], opts.modes);
+        else if (arg == "--repeat" && has_value)
+            ok = (opts.repeat = std::strtoul(argv[++i], nullptr, 10)) > 0;
+        else if (arg == "--work-dir" && has_value)
+            opts.work_dir = argv[++i];
+        else if (arg == "--json" && has_value)
+            opts.json = argv[++i];
+        else if (arg == "--keep")
+            opts.keep = true;
+        else
+            ok = false;
+        if (!ok) {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (opts.jobs.empty()) {
+        const std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        for (std::size_t j = 1; j < cores; j *= 2)
+            opts.jobs.push_back(j);
+        opts.jobs.push_back(cores);
+        if (cores == 1)
+            opts.jobs.push_back(2);   // still exercise the threaded paths
+    }
+    const std::filesystem::path work = opts.work_dir.empty()
+        ? std::filesystem::temp_directory_path() / "nmea_scale"
+        : std::filesystem::path(opts.work_dir);
+    std::error_code ec;
+    std::filesystem::create_directories(work, ec);
+    if (ec) {
+        std::cerr << "Error: cannot create '" << work.string() << "': " << ec.message() << '\n';
+        return 2;
+    }
+
+    std::vector<std::filesystem::path> captures;
+    for (const auto& entry : std::filesystem::directory_iterator(opts.data_dir, ec))
+        if (entry.is_regular_file() && entry.path().extension() == ".nmea")
+            captures.push_back(entry.path());
+    std::sort(captures.begin(), captures.end());
+    if (captures.empty()) {
+        std::cerr << "Error: no .nmea captures in '" << opts.data_dir << "'\n";
+        return 2;
+    }
+
+    std::vector<Measurement> results;
+    std::size_t mismatches = 0;
+    const std::string out_path = (work / "stdout.txt").string();
+    for (const auto& capture : captures) {
+        std::ifstream in(capture, std::ios::binary);
+        const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        const std::string corpus = capture.stem().string();
+
+        for (const std::size_t scale : opts.scales) {
+            const std::string input = (work / (corpus + ".x" + std::to_string(scale) + ".nmea")).string();
+            std::uint64_t lines = 0;
+            {
+                std::ofstream out(input, std::ios::binary | std::ios::trunc);
+                lines = amplify(text, scale, out);
+            }
+            const std::uint64_t bytes = std::filesystem::file_size(input, ec);
+
+            // The serial baseline: batch, one job, whatever --modes and
+            // --jobs ask to be measured.
+            const RunResult base = run_binary({opts.binary, "--jobs", "1", input}, out_path);
+            if (!base.ok) {
+                std::cerr << "Error: '" << opts.binary << "' failed on '" << input << "'\n";
+                std::filesystem::remove(out_path, ec);
+                if (!opts.keep)
+                    std::filesystem::remove(input, ec);
+                return 2;
+            }
+            for (const std::string& mode : opts.modes) {
+                double one_job_s = 0.0;
+                for (const std::size_t jobs : opts.jobs) {
+                    if (mode == "stream" && jobs > 1)
+                        continue;   // --stream ignores --jobs
+                    std::vector<std::string> args = {opts.binary, "--jobs", std::to_string(jobs)};
+                    if (mode == "stream" || mode == "pipeline")
+                        args.push_back("--" + mode);
+                    const bool piped = mode == "piped";
+                    args.push_back(piped ? "/dev/stdin" : input);
+
+                    Measurement m{corpus, scale, mode, jobs, bytes, lines, {}, 1.0, false};
+                    for (std::size_t r = 0; r < opts.repeat; ++r) {
+                        const RunResult run = run_binary(args, out_path, piped ? input : std::string());
+                        if (r == 0 || !run.ok || run.wall_s < m.run.wall_s)
+                            m.run = run;
+                        if (!run.ok)
+                            break;
+                    }
+                    m.matches = m.run.ok && m.run.output_hash == base.output_hash;
+                    if (jobs == 1)
+                        one_job_s = m.run.wall_s;
+                    if (one_job_s > 0.0 && m.run.wall_s > 0.0)
+                        m.speedup = one_job_s / m.run.wall_s;
+                    mismatches += !m.matches;
+                    std::cerr << corpus << " x" << scale << ' ' << mode << " j" << jobs << ": "
+                              << std::fixed << std::setprecision(1) << m.run.wall_s * 1e3
+                              << " ms, " << m.run.peak_rss_kb << " KiB"
+                              << (m.matches ? "" : "  OUTPUT DIFFERS") << '\n';
+                    results.push_back(m);
+                }
+            }
+            if (!opts.keep)
+                std::filesystem::remove(input, ec);
+        }
+    }
+    std::filesystem::remove(out_path, ec);
+    if (!opts.keep && opts.work_dir.empty())
+        std::filesystem::remove(work, ec);
+
+    if (opts.json == "-") {
+        write_json(std::cout, opts, results, mismatches);
+    } else {
+        std::ofstream file(opts.json);
+        if (!file) {
+            std::cerr << "Error: cannot write '" << opts.json << "'\n";
+            return 2;
+        }
+        write_json(file, opts, results, mismatches);
+    }
+    return mismatches ? 1 : 0;
+}
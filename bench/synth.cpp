@@ -0,0 +1,145 @@
+/*
+ * synth.cpp — Synthetic NMEA route generator (shared by nmea_gen and nmea_bench)
+ */
+
+#include "synth.h"
+
+#include <cmath>
+#include <cstdio>
+
+// ─── Generator constants ───────────────────────────────────────────────────
+
+static constexpr double kPi              = 3.14159265358979323846;
+static constexpr double kMetresPerDegLat = 111320.0;
+static constexpr double kKnotsToMps      = 0.514444;
+static constexpr double kMinSpeedKnots   = 5.0;
+static constexpr double kMaxSpeedKnots   = 95.0;
+static constexpr double kMaxTurnDeg      = 25.0;    // per epoch
+static constexpr double kCorrectionDeg   = 3e-5;    // jitter of a re-emitted fix
+static constexpr std::size_t kSentenceMax = 128;
+static constexpr int    kDaysInMonth[]   = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+// ─── Internal helpers ───────────────────────────────────────────────────────
+
+/// Format |deg| as NMEA DDMM.mmm (lat, 2 degree digits) or DDDMM.mmm (lon).
+static void format_coord(double deg, int deg_digits, char* buf, std::size_t n)
+{
+    deg = std::fabs(deg);
+    int whole = static_cast<int>(deg);
+    double minutes = (deg - whole) * 60.0;
+    std::snprintf(buf, n, "%0*d%06.3f", deg_digits, whole, minutes);
+}
+
+// ─── NmeaSynth ──────────────────────────────────────────────────────────────
+
+NmeaSynth::NmeaSynth(const SynthOptions& opts)
+    : opts_(opts), rng_(opts.seed),
+      lat_(opts.start_lat), lon_(opts.start_lon),
+      heading_deg_(90.0), speed_knots_(40.0),
+      prev_lat_(opts.start_lat), prev_lon_(opts.start_lon),
+      hh_(opts.start_hour), mm_(0), ss_(0),
+      day_(opts.start_day), month_(opts.start_month), year_(opts.start_year),
+      prev_hh_(opts.start_hour), prev_mm_(0), prev_ss_(0),
+      prev_day_(opts.start_day), prev_month_(opts.start_month),
+      prev_year_(opts.start_year)
+{
+}
+
+void NmeaSynth::append_sentence(const char* body, std::string& out, bool truncate)
+{
+    unsigned char cs = 0;
+    for (const char* p = body; *p; ++p)
+        cs ^= static_cast<unsigned char>(*p);
+
+    char line[kSentenceMax + 8];
+    int len = std::snprintf(line, sizeof line, "$%s*%02X", body, cs);
+    if (truncate && len > 2)
+        len = 1 + static_cast<int>(rng_() % static_cast<unsigned>(len - 1));
+    out.append(line, static_cast<std::size_t>(len));
+    out.push_back('\n');
+}
+
+void NmeaSynth::advance_clock()
+{
+    prev_hh_  = hh_;   prev_mm_    = mm_;     prev_ss_   = ss_;
+    prev_day_ = day_;  prev_month_ = month_;  prev_year_ = year_;
+    if (++ss_ < 60) return;
+    ss_ = 0;
+    if (++mm_ < 60) return;
+    mm_ = 0;
+    if (++hh_ < 24) return;
+    hh_ = 0;
+    if (++day_ <= kDaysInMonth[month_ - 1]) return;
+    day_ = 1;
+    if (++month_ <= 12) return;
+    month_ = 1;
+    year_ = (year_ + 1) % 100;
+}
+
+std::size_t NmeaSynth::next_epoch(std::string& out)
+{
+    // Random-walk the vehicle: gentle turns, bounded speed changes.
+    heading_deg_ += (unit_(rng_) * 2.0 - 1.0) * kMaxTurnDeg;
+    heading_deg_ = std::fmod(heading_deg_ + 360.0, 360.0);
+    speed_knots_ += (unit_(rng_) * 2.0 - 1.0) * 8.0;
+    speed_knots_ = std::fmin(std::fmax(speed_knots_, kMinSpeedKnots), kMaxSpeedKnots);
+
+    const double metres = speed_knots_ * kKnotsToMps;
+    const double rad    = heading_deg_ * kPi / 180.0;
+    prev_lat_ = lat_;
+    prev_lon_ = lon_;
+    lat_ += metres * std::cos(rad) / kMetresPerDegLat;
+    lon_ += metres * std::sin(rad) /
+            (kMetresPerDegLat * std::cos(lat_ * kPi / 180.0));
+
+    char lat_s[24], lon_s[24], body[kSentenceMax];
+    format_coord(lat_, 2, lat_s, sizeof lat_s);
+    format_coord(lon_, 3, lon_s, sizeof lon_s);
+    const char ns = lat_ >= 0 ? 'N' : 'S';
+    const char ew = lon_ >= 0 ? 'E' : 'W';
+
+    std::size_t lines = 0;
+    if (unit_(rng_) < opts_.gga_rate) {
+        std::snprintf(body, sizeof body,
+                      "GPGGA,%02d%02d%02d.273,%s,%c,%s,%c,1,12,1.0,0.0,M,0.0,M,,",
+                      hh_, mm_, ss_, lat_s, ns, lon_s, ew);
+        append_sentence(body, out, false);
+        ++lines;
+    }
+    if (unit_(rng_) < opts_.gsa_rate) {
+        append_sentence("GPGSA,A,3,01,02,03,04,05,06,07,08,09,10,11,12,1.0,1.0,1.0",
+                        out, false);
+        ++lines;
+    }
+
+    std::snprintf(body, sizeof body,
+                  "GPRMC,%02d%02d%02d.273,A,%s,%c,%s,%c,%05.1f,%05.1f,%02d%02d%02d,000.0,W",
+                  hh_, mm_, ss_, lat_s, ns, lon_s, ew, speed_knots_, heading_deg_,
+                  day_, month_, year_);
+    append_sentence(body, out, unit_(rng_) < opts_.incomplete_rate);
+    ++lines;
+
+    // Corrected re-emission of the previous epoch, as in the dup captures.
+    if (unit_(rng_) < opts_.duplicate_rate) {
+        const double dlat = prev_lat_ + (unit_(rng_) - 0.5) * kCorrectionDeg;
+        const double dlon = prev_lon_ + (unit_(rng_) - 0.5) * kCorrectionDeg;
+        format_coord(dlat, 2, lat_s, sizeof lat_s);
+        format_coord(dlon, 3, lon_s, sizeof lon_s);
+        std::snprintf(body, sizeof body,
+                      "GPRMC,%02d%02d%02d.273,A,%s,%c,%s,%c,%05.1f,000.0,%02d%02d%02d,000.0,W",
+                      prev_hh_, prev_mm_, prev_ss_, lat_s, ns, lon_s, ew,
+                      speed_knots_, prev_day_, prev_month_, prev_year_);
+        append_sentence(body, out, false);
+        ++lines;
+    }
+
+    advance_clock();
+    return lines;
+}
+
+void NmeaSynth::generate_bytes(std::size_t bytes, std::string& out)
+{
+    const std::size_t target = out.size() + bytes;
+    while (out.size() < target)
+        next_epoch(out);
+}
@@ -0,0 +1,58 @@
+/*
+ * synth.h — Synthetic NMEA route generator (shared by nmea_gen and nmea_bench)
+ *
+ * Models the data_for_checks/fake_ampm_route*.nmea captures: one epoch per
+ * second made of $GPGGA, $GPGSA and $GPRMC, with corrected re-emissions of
+ * recent RMC epochs (duplicates) and truncated lines (incomplete).
+ */
+
+#ifndef SYNTH_H
+#define SYNTH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+
+/// Knobs for the generated stream.  Rates are probabilities per epoch.
+struct SynthOptions {
+    std::uint64_t seed            = 1;
+    double        duplicate_rate  = 0.1;    // extra RMC re-emitting a recent epoch
+    double        incomplete_rate = 0.1;    // an RMC line truncated mid-sentence
+    double        gga_rate        = 1.0;    // epoch carries a $GPGGA
+    double        gsa_rate        = 1.0;    // epoch carries a $GPGSA
+    double        start_lat       = 31.930433;
+    double        start_lon       = 34.796117;
+    int           start_hour      = 18;     // UTC start time of day
+    int           start_day       = 12;     // DDMMYY start date
+    int           start_month     = 2;
+    int           start_year      = 26;
+};
+
+/// Stateful generator: each `next_epoch` appends one epoch's lines
+/// (newline-terminated) to `out`.  Deterministic for a given seed.
+class NmeaSynth {
+public:
+    explicit NmeaSynth(const SynthOptions& opts);
+
+    /// Append the next epoch; returns the number of lines appended.
+    std::size_t next_epoch(std::string& out);
+
+    /// Append epochs until `out` has grown by at least `bytes`.
+    void generate_bytes(std::size_t bytes, std::string& out);
+
+private:
+    void append_sentence(const char* body, std::string& out, bool truncate);
+    void advance_clock();
+
+    SynthOptions  opts_;
+    std::mt19937_64 rng_;
+    std::uniform_real_distribution<double> unit_{0.0, 1.0};
+
+    double lat_, lon_, heading_deg_, speed_knots_;
+    double prev_lat_, prev_lon_;
+    int    hh_, mm_, ss_, day_, month_, year_;
+    int    prev_hh_, prev_mm_, prev_ss_, prev_day_, prev_month_, prev_year_;
+};
+
+#endif // SYNTH_H
@@ -0,0 +1,233 @@
+#!/bin/sh
+# check.sh — Regression checks over the data_for_checks/ captures
+#
+# Usage:  sh data_for_checks/check.sh BINARY [EDGE_BINARY]   (make check)
+#         sh data_for_checks/check.sh BINARY --update
+#
+# Each capture, and all of them together, is parsed and the route table
+# and a CSV export (seven-decimal coordinates, epoch timestamps, speeds)
+# are diffed against data_for_checks/expected/, as are each capture's
+# per-reason reject counts from --stats and --stats-json.  Every other
+# way of building the same route is then checked against the default
+# run: the parallel ingest, each dedup engine, --stream, --pipeline,
+# --fast-reject, the parse cache, a gzip/zstd copy of the input, a
+# one-track --track run and an incremental --checkpoint run over the
+# capture cut in two; the parallel ingest must also give the same reject
+# counts.  With EDGE_BINARY, nmea_edge's rows must equal the CSV export
+# of the run its fixed configuration mirrors (--stream --window 0
+# --fast-reject).  Option-specific runs over one capture (route queries,
+# metric spatial dedup, simplification, --fuse thresholds) are pinned to
+# their own expected files.  --update rewrites every expected file from
+# BINARY instead; review the diff before committing them.
+#
+# Mode-specific summary lines ("Late (past window)", "Lines by type",
+# "Parse cache hits") are dropped before comparing.
+
+bin=$1
+edge=
+update=
+if [ "$2" = "--update" ]; then update=1; else edge=$2; fi
+dir=$(dirname "$0")
+expected=$dir/expected
+work=${TMPDIR:-/tmp}/nmea_check.$$
+failures=0
+
+if [ -z "$bin" ] || [ ! -x "$bin" ]; then
+    echo "usage: $0 BINARY [EDGE_BINARY | --update]" >&2
+    exit 2
+fi
+mkdir -p "$work" || exit 2
+trap 'rm -rf "$work"' EXIT
+
+# Drop the summary lines that only some modes print.
+common() {
+    grep -v -e '^  Late (past window)' -e '^  Lines by type' -e '^  Parse cache hits' "$1"
+}
+
+# check NAME FILE EXPECTED — report whether FILE equals EXPECTED.
+check() {
+    if cmp -s "$2" "$3"; then
+        echo "ok    $1"
+    else
+        echo "FAIL  $1"
+        diff "$3" "$2" | head -n 10
+        failures=$((failures + 1))
+    fi
+}
+
+# pin NAME FILE EXPECTED — check FILE against EXPECTED, or with --update
+# make it the new EXPECTED.
+pin() {
+    if [ -n "$update" ]; then
+        cp "$2" "$3"
+    else
+        check "$1" "$2" "$3"
+    fi
+}
+
+# pinned NAME EXPECTED ARGS... — pin the output of BINARY ARGS...
+pinned() {
+    name=$1 out=$2
+    shift 2
+    "$bin" "$@" > "$work/pinned" 2>&1
+    pin "$name" "$work/pinned" "$out"
+}
+
+# same NAME FILE — FILE, mode lines dropped, equals the default run.
+same() {
+    common "$2" > "$work/got"
+    check "$1" "$work/got" "$work/default.common"
+}
+
+# rejects TEXT JSON — the per-reason reject counts of a --stats run and
+# of its --stats-json file, without the (randomly drawn) sample lines.
+rejects() {
+    awk '/^=== /{on = ($0 == "=== Rejected Lines ===")} /^  Sample/{on = 0} on' "$1"
+    sed -n '/^  "rejects": {/,/^    "sampled_from"/p' "$2"
+}
+
+[ -n "$update" ] && mkdir -p "$expected"
+
+for f in "$dir"/*.nmea; do
+    name=$(basename "$f" .nmea)
+
+    "$bin" "$f" > "$work/default" 2>&1
+    pin "$name: route table" "$work/default" "$expected/$name.out"
+    "$bin" --export-csv - "$f" > "$work/csv" 2>&1
+    pin "$name: decoded CSV" "$work/csv" "$expected/$name.csv"
+    "$bin" --export-bin "$work/route.bin" "$f" > /dev/null 2>&1
+    "$bin" --export-bin - "$f" > "$work/out" 2>&1
+    check "$name: --export-bin - (stdout)" "$work/out" "$work/route.bin"
+    common "$work/default" > "$work/default.common"
+
+    "$bin" --stats --stats-json "$work/stats.json" "$f" > "$work/out" 2>&1
+    rejects "$work/out" "$work/stats.json" > "$work/rejects"
+    pin "$name: reject counts" "$work/rejects" "$expected/$name.rejects"
+    "$bin" --stats --stats-json "$work/stats.json" --jobs 3 --chunk-size 256 "$f" > "$work/out" 2>&1
+    rejects "$work/out" "$work/stats.json" > "$work/rejects"
+    check "$name: reject counts, --jobs 3" "$work/rejects" "$expected/$name.rejects"
+
+    "$bin" --jobs 3 --chunk-size 256 "$f" > "$work/out" 2>&1
+    same "$name: --jobs 3 --chunk-size 256" "$work/out"
+    for engine in hash map; do
+        "$bin" --dedup-engine $engine "$f" > "$work/out" 2>&1
+        same "$name: --dedup-engine $engine" "$work/out"
+    done
+    "$bin" --stream "$f" > "$work/out" 2>&1
+    same "$name: --stream" "$work/out"
+    "$bin" --pipeline --jobs 2 "$f" > "$work/out" 2>&1
+    same "$name: --pipeline --jobs 2" "$work/out"
+    "$bin" --fast-reject "$f" > "$work/out" 2>&1
+    same "$name: --fast-reject" "$work/out"
+
+    "$bin" --cache-dir "$work/cache" "$f" > /dev/null 2>&1
+    "$bin" --cache-dir "$work/cache" "$f" > "$work/out" 2>&1
+    same "$name: --cache-dir (hit)" "$work/out"
+    rm -rf "$work/cache"
+
+    if command -v gzip > /dev/null; then
+        gzip -c "$f" > "$work/in.gz"
+        if "$bin" "$work/in.gz" > "$work/out" 2> "$work/err" && [ ! -s "$work/err" ]; then
+            same "$name: gzip input" "$work/out"
+        else
+            echo "skip  $name: gzip input ($(head -n 1 "$work/err"))"
+        fi
+    fi
+    if command -v zstd > /dev/null; then
+        zstd -q -c "$f" > "$work/in.zst"
+        if "$bin" "$work/in.zst" > "$work/out" 2> "$work/err" && [ ! -s "$work/err" ]; then
+            same "$name: zstd input" "$work/out"
+        else
+            echo "skip  $name: zstd input ($(head -n 1 "$work/err"))"
+        fi
+    fi
+
+    "$bin" --track one="$f" --export-csv "$work/track.csv" > /dev/null 2>&1
+    check "$name: --track CSV" "$work/track.one.csv" "$work/csv"
+
+    # Half the lines, then the rest appended: the second run resumes.
+    lines=$(wc -l < "$f")
+    head -n $((lines / 2)) "$f" > "$work/grow.nmea"
+    "$bin" --checkpoint "$work/cp" "$work/grow.nmea" > /dev/null 2>&1
+    tail -n +$((lines / 2 + 1)) "$f" >> "$work/grow.nmea"
+    "$bin" --checkpoint "$work/cp" "$work/grow.nmea" > "$work/out" 2>&1
+    same "$name: --checkpoint, resumed" "$work/out"
+    rm -f "$work/cp" "$work/grow.nmea"
+
+    if [ -n "$edge" ]; then
+        "$bin" --stream --window 0 --fast-reject --export-csv - "$f" > "$work/csv" 2>&1
+        "$edge" "$f" > "$work/out" 2> /dev/null
+        check "$name: nmea_edge" "$work/out" "$work/csv"
+        "$edge" < "$f" > "$work/out" 2> /dev/null
+        check "$name: nmea_edge (stdin)" "$work/out" "$work/csv"
+    fi
+done
+
+pinned "all: route table" "$expected/all.out" "$dir"/*.nmea
+pinned "all: decoded CSV" "$expected/all.csv" --export-csv - "$dir"/*.nmea
+
+# Option-specific runs on one capture: each appends "# ARGS" and the
+# --export-csv output of those ARGS to $work/NAME.
+route=$dir/fake_ampm_route.nmea
+runs() {
+    out=$work/$1
+    shift
+    echo "# $*" >> "$out"
+    "$bin" "$@" --export-csv - "$route" >> "$out" 2>&1
+}
+
+# Route queries (2026-02-12 18:34:34.273Z onwards, around 31.93 N 34.79 E):
+# ISO and Unix-ms times, an exclusive --to, boxes (one crossing the
+# antimeridian, so it keeps everything east of its west edge) and a query
+# matching nothing.
+: > "$work/query"
+runs query --from 2026-02-12T18:34:40Z --to "2026-02-12 18:34:50.273"
+runs query --from 1770921290273
+runs query --to 2026-02-12T18:34:45
+runs query --from 2026-02-12
+runs query --from 2026-02-13
+runs query --bbox 34.7940,31.9290,34.7965,31.9305
+runs query --bbox 34.7960,31.9,-179,32
+runs query --from 2026-02-12T18:34:50 --bbox 34.79,31.9295,34.80,32
+pin "queries: --from / --to / --bbox" "$work/query" "$expected/query.csv"
+pinned "queries: route table" "$expected/query.out" \
+    --from "2026-02-12 18:34:40" --bbox 34.7940,31.9290,34.7965,31.9305 "$route"
+
+# Metric spatial dedup, at a threshold that drops fixes, and both
+# simplifiers at their default and at a second tolerance.
+: > "$work/spatial"
+runs spatial --spatial haversine --spatial-eps-m 30
+runs spatial --spatial equirect --spatial-eps-m 30
+runs spatial --spatial-eps-m 40
+pin "spatial: metric dedup" "$work/spatial" "$expected/spatial.csv"
+: > "$work/simplify"
+runs simplify --simplify dp
+runs simplify --simplify vw
+runs simplify --simplify dp --simplify-tolerance 2
+runs simplify --simplify vw --simplify-tolerance 100
+pin "simplify: dp / vw" "$work/simplify" "$expected/simplify.csv"
+pinned "simplify: route table" "$expected/simplify.out" --simplify vw "$route"
+
+# --fuse thresholds that reject the capture's weak epochs (7 and 9
+# satellites, HDOP 2.6 and 1.8, PDOP 3.1 and 2.2).  The parallel run's
+# 256-byte chunks mostly start between an epoch's GGA/GSA and its RMC, so
+# it only matches the serial table if the lookback replay rebuilds them.
+: > "$work/fuse"
+runs fuse --fuse --min-sats 8
+runs fuse --fuse --max-hdop 2.0
+runs fuse --fuse --max-pdop 2.0 --max-vdop 1.5
+runs fuse --fuse --min-fix-quality 1
+pin "fuse: quality thresholds" "$work/fuse" "$expected/fuse.csv"
+pinned "fuse: route table" "$expected/fuse.out" --fuse --min-sats 8 --max-pdop 2.0 "$route"
+"$bin" --fuse --min-sats 8 --max-pdop 2.0 --jobs 3 --chunk-size 256 "$route" > "$work/fuse.jobs" 2>&1
+check "fuse: --jobs 3 --chunk-size 256" "$work/fuse.jobs" "$expected/fuse.out"
+
+if [ -n "$update" ]; then
+    echo "updated $expected"
+    exit 0
+fi
+if [ $failures -ne 0 ]; then
+    echo "$failures check(s) failed"
+    exit 1
+fi
+echo "all checks passed"
@@ -0,0 +1,105 @@
+/*
+ * arena.cpp — Monotonic arena allocator
+ */
+
+#include "arena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+// ─── Arena ──────────────────────────────────────────────────────────────────
+
+Arena::Arena(Arena&& other) noexcept
+    : blocks_(std::move(other.blocks_)), block_bytes_(other.block_bytes_),
+      cursor_(std::exchange(other.cursor_, nullptr)),
+      limit_(std::exchange(other.limit_, nullptr)),
+      used_(std::exchange(other.used_, 0)),
+      reserved_(std::exchange(other.reserved_, 0))
+{
+    other.blocks_.clear();
+}
+
+Arena& Arena::operator=(Arena&& other) noexcept
+{
+    if (this != &other) {
+        blocks_      = std::move(other.blocks_);
+        block_bytes_ = other.block_bytes_;
+        cursor_      = std::exchange(other.cursor_, nullptr);
+        limit_       = std::exchange(other.limit_, nullptr);
+        used_        = std::exchange(other.used_, 0);
+        reserved_    = std::exchange(other.reserved_, 0);
+        other.blocks_.clear();
+    }
+    return *this;
+}
+
+void* Arena::allocate(std::size_t bytes, std::size_t align)
+{
+    auto fits = [&](std::byte* p) {
+        const auto addr    = reinterpret_cast<std::uintptr_t>(p);
+        const auto aligned = (addr + align - 1) & ~(std::uintptr_t(align) - 1);
+        return aligned + bytes <= reinterpret_cast<std::uintptr_t>(limit_)
+            ? reinterpret_cast<std::byte*>(aligned) : nullptr;
+    };
+
+    std::byte* p = cursor_ ? fits(cursor_) : nullptr;
+    if (!p) {
+        // New block: double the last one (up to the cap), or exactly the
+        // request plus alignment slack if it is bigger than that.  Memory
+        // from new[] is left untouched, so pages are faulted in only as
+        // they are actually used.
+        std::size_t size = blocks_.empty()
+            ? block_bytes_ : std::min(blocks_.back().size * 2, kArenaMaxBlockBytes);
+        size = std::max(size, bytes + align);
+        blocks_.push_back({std::unique_ptr<std::byte[]>(new std::byte[size]), size});
+        reserved_ += size;
+        cursor_ = blocks_.back().mem.get();
+        limit_  = cursor_ + size;
+        p = fits(cursor_);
+    }
+    used_  += static_cast<std::size_t>(p + bytes - cursor_);
+    cursor_ = p + bytes;
+    return p;
+}
+
+void* Arena::grow(void* p, std::size_t old_bytes, std::size_t new_bytes, std::size_t align)
+{
+    if (!p)
+        return allocate(new_bytes, align);
+
+    auto* const base = static_cast<std::byte*>(p);
+    const bool  top  = base + old_bytes == cursor_;
+    if (top && new_bytes <= static_cast<std::size_t>(limit_ - base)) {
+        used_  += new_bytes - old_bytes;
+        cursor_ = base + new_bytes;
+        return p;
+    }
+
+    // The block it leaves holds nothing else: free it once copied.
+    const bool alone = top && base == blocks_.back().mem.get();
+    void* out = allocate(new_bytes, align);
+    std::memcpy(out, p, old_bytes);
+    if (alone) {
+        const auto old = blocks_.end() - 2;   // allocate() added a block
+        reserved_ -= old->size;
+        used_     -= old_bytes;
+        blocks_.erase(old);
+    }
+    return out;
+}
+
+void Arena::reset()
+{
+    if (blocks_.empty())
+        return;
+    auto largest = std::max_element(blocks_.begin(), blocks_.end(),
+                                    [](const Block& a, const Block& b) { return a.size < b.size; });
+    Block keep = std::move(*largest);
+    blocks_.clear();
+    blocks_.push_back(std::move(keep));
+    reserved_ = blocks_.back().size;
+    used_     = 0;
+    cursor_   = blocks_.back().mem.get();
+    limit_    = cursor_ + blocks_.back().size;
+}
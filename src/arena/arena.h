@@ -0,0 +1,199 @@
+/*
+ * arena.h — Monotonic arena allocator and non-owning spans
+ *
+ * An Arena hands out memory by bumping a pointer through large blocks and
+ * frees everything at once when it is reset or destroyed.  Batch ingest
+ * keeps a file's (or chunk's) records and the dedup index arrays in one
+ * arena, so a run makes a handful of large allocations instead of one
+ * per growing vector, and a reused arena does not fault its pages again.
+ * Only trivially destructible objects belong in an arena: nothing is
+ * ever destroyed individually.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/// Size of an arena's first block; later blocks double up to kArenaMaxBlockBytes.
+inline constexpr std::size_t kArenaBlockBytes    = 1u << 20;    // 1 MiB
+inline constexpr std::size_t kArenaMaxBlockBytes = 64u << 20;   // 64 MiB
+
+/// Non-owning view of `size()` contiguous `T` (C++17 has no std::span).
+template <typename T>
+class Span {
+public:
+    Span() = default;
+    Span(T* data, std::size_t size) : data_(data), size_(size) {}
+
+    /// Implicit view of a vector or another span whose elements convert
+    /// (so Span<T> and std::vector<T> both pass as Span<const T>).
+    template <typename V,
+              typename = std::enable_if_t<
+                  std::is_convertible_v<decltype(std::declval<V&>().data()), T*>>>
+    Span(V&& v) : data_(v.data()), size_(v.size()) {}
+
+    T*          data() const  { return data_; }
+    std::size_t size() const  { return size_; }
+    bool        empty() const { return size_ == 0; }
+    T*          begin() const { return data_; }
+    T*          end() const   { return data_ + size_; }
+    T&          operator[](std::size_t i) const { return data_[i]; }
+
+private:
+    T*          data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+/// Monotonic bump allocator.  Not thread-safe: give each worker its own.
+/// Move-only; moving keeps every pointer handed out valid.
+class Arena {
+public:
+    explicit Arena(std::size_t block_bytes = kArenaBlockBytes) : block_bytes_(block_bytes) {}
+
+    Arena(const Arena&)            = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&& other) noexcept;
+    Arena& operator=(Arena&& other) noexcept;
+
+    /// `bytes` of uninitialised memory aligned to `align` (a power of two).
+    /// Throws std::bad_alloc like operator new.
+    void* allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t));
+
+    /// Uninitialised storage for `n` objects of `T`.
+    template <typename T>
+    T* allocate_array(std::size_t n)
+    {
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "arena objects are never destroyed");
+        if (n > SIZE_MAX / sizeof(T))
+            throw std::bad_alloc();
+        return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+    }
+
+    /// Resize the allocation at `p` from `old_bytes` to `new_bytes`
+    /// (larger), keeping its contents.  When `p` is the latest allocation
+    /// it grows in place if its block has room; if it moves to a new block
+    /// and was alone in the old one, that block is freed.  Otherwise the
+    /// bytes are copied to a fresh allocation and the old one is simply
+    /// abandoned.  A null `p` is a plain allocate().
+    void* grow(void* p, std::size_t old_bytes, std::size_t new_bytes,
+               std::size_t align = alignof(std::max_align_t));
+
+    /// Copy `src` into the arena and return the copy.
+    template <typename T>
+    Span<T> copy(Span<const T> src)
+    {
+        T* out = allocate_array<T>(src.size());
+        std::uninitialized_copy(src.begin(), src.end(), out);
+        return {out, src.size()};
+    }
+
+    /// Forget every allocation but keep the largest block for reuse.
+    void reset();
+
+    std::size_t bytes_used() const     { return used_; }
+    std::size_t bytes_reserved() const { return reserved_; }
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> mem;
+        std::size_t                  size;
+    };
+
+    std::vector<Block> blocks_;
+    std::size_t        block_bytes_;
+    std::byte*         cursor_   = nullptr;
+    std::byte*         limit_    = nullptr;
+    std::size_t        used_     = 0;
+    std::size_t        reserved_ = 0;
+};
+
+/// Standard allocator over an Arena, for node containers (the ordered-map
+/// dedup engine).  `deallocate` is a no-op: a container may be destroyed
+/// while a Span over its arena storage stays valid.  Growable buffers use
+/// ArenaVector, which does not strand its old storage.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(Arena& arena) noexcept : arena_(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+    T*   allocate(std::size_t n) { return arena_->allocate_array<T>(n); }
+    void deallocate(T*, std::size_t) noexcept {}
+
+    Arena* arena() const noexcept { return arena_; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& o) const noexcept { return arena_ == o.arena(); }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& o) const noexcept { return arena_ != o.arena(); }
+
+private:
+    Arena* arena_;
+};
+
+/// Growable vector in an arena, for record buffers whose final size is
+/// only estimated.  While it is the arena's latest allocation it grows
+/// in place through Arena::grow, so outgrowing its reservation does not
+/// leave the old buffer behind as std::vector over an ArenaAllocator
+/// would.  Like every arena object its storage outlives it: a Span over
+/// `data()` stays valid after the vector is destroyed.
+template <typename T>
+class ArenaVector {
+    static_assert(std::is_trivially_copyable_v<T>, "ArenaVector moves elements with memcpy");
+
+public:
+    explicit ArenaVector(Arena& arena) noexcept : arena_(&arena) {}
+
+    ArenaVector(const ArenaVector&)            = delete;
+    ArenaVector& operator=(const ArenaVector&) = delete;
+
+    void reserve(std::size_t n)
+    {
+        if (n > capacity_)
+            grow_to(n);
+    }
+
+    void push_back(const T& value)
+    {
+        if (size_ == capacity_)
+            grow_to(capacity_ ? capacity_ * 2 : kArenaVectorMinCapacity);
+        data_[size_++] = value;
+    }
+
+    T*          data() const     { return data_; }
+    std::size_t size() const     { return size_; }
+    std::size_t capacity() const { return capacity_; }
+    bool        empty() const    { return size_ == 0; }
+    T*          begin() const    { return data_; }
+    T*          end() const      { return data_ + size_; }
+    T&          operator[](std::size_t i) const { return data_[i]; }
+
+private:
+    static constexpr std::size_t kArenaVectorMinCapacity = 16;
+
+    void grow_to(std::size_t n)
+    {
+        if (n > SIZE_MAX / sizeof(T))
+            throw std::bad_alloc();
+        data_     = static_cast<T*>(arena_->grow(data_, capacity_ * sizeof(T), n * sizeof(T),
+                                                 alignof(T)));
+        capacity_ = n;
+    }
+
+    Arena*      arena_;
+    T*          data_     = nullptr;
+    std::size_t size_     = 0;
+    std::size_t capacity_ = 0;
+};
+
+#endif // ARENA_H
@@ -0,0 +1,244 @@
+/*
+ * cache.cpp — Persistent per-input parse cache (--cache-dir)
+ */
+
+#include "cache.h"
+#include "route_io.h"
+#include "util.h"
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+// ─── Cache constants ───────────────────────────────────────────────────────
+
+static constexpr char          kCountersMagic[4] = {'N', 'M', 'C', 'C'};
+static constexpr std::size_t   kLineCounters     = 7;   // lines_total … quality_rejected
+static constexpr std::size_t   kRejectCounters   = kRejectReasonCount * kSentenceTypeCount;
+static constexpr std::size_t   kCounterFields    = kLineCounters + kSentenceTypeCount + kRejectCounters;
+static constexpr const char*   kRecordsSuffix    = ".nrt";
+static constexpr const char*   kCountersSuffix   = ".cnt";
+
+namespace {
+
+/// On-disk counters entry.  Holds the full key, so a name collision or a
+/// half-replaced entry reads as a miss.
+struct CountersEntry {
+    char          magic[4];
+    std::uint32_t version;
+    std::uint64_t size;
+    std::int64_t  mtime_ns;
+    std::uint64_t content;
+    std::uint64_t options;
+    std::uint64_t records;
+    std::uint64_t counters[kCounterFields];
+};
+
+// ─── Hashing ────────────────────────────────────────────────────────────────
+
+/// Hash of the sampled windows of `data` (all of it when small).
+std::uint64_t sample_hash(std::string_view data)
+{
+    constexpr std::size_t kFullHashBytes = kCacheSampleBytes * (kCacheSampleCount + 2);
+    if (data.size() <= kFullHashBytes)
+        return fnv1a(kFnvOffset, data.data(), data.size());
+
+    std::uint64_t h = fnv1a(kFnvOffset, data.data(), kCacheSampleBytes);
+    const std::size_t span = data.size() - 2 * kCacheSampleBytes;
+    for (std::size_t i = 1; i <= kCacheSampleCount; ++i) {
+        const std::size_t at = span / (kCacheSampleCount + 1) * i + kCacheSampleBytes / 2;
+        h = fnv1a(h, data.data() + at, kCacheSampleBytes);
+    }
+    return fnv1a(h, data.data() + data.size() - kCacheSampleBytes, kCacheSampleBytes);
+}
+
+/// Fingerprint of everything that changes what a parse yields.
+std::uint64_t options_fingerprint(const IngestOptions& opts)
+{
+    const FusionOptions& fusion = opts.fusion;
+    std::uint64_t h = fnv1a(kFnvOffset, kParseCacheVersion);
+    h = fnv1a(h, opts.checksum);
+    h = fnv1a(h, fusion.enabled);
+    if (fusion.enabled) {
+        const QualityFilter& f = fusion.filter;
+        h = fnv1a(h, f.min_fix_quality);
+        h = fnv1a(h, f.min_satellites);
+        h = fnv1a(h, f.max_hdop);
+        h = fnv1a(h, f.max_pdop);
+        h = fnv1a(h, f.max_vdop);
+    }
+    return h;
+}
+
+// ─── Entry files ────────────────────────────────────────────────────────────
+
+/// The counters stored in an entry, in on-disk order.  Reject counts are
+/// kept; the sampled lines are not, so a hit adds to the counts only.
+std::array<std::size_t*, kCounterFields> counter_fields(IngestCounters& c)
+{
+    std::array<std::size_t*, kCounterFields> fields = {
+        &c.lines_total, &c.checksum_fail, &c.not_relevant, &c.parse_fail,
+        &c.epoch_lines, &c.fused, &c.quality_rejected};
+    for (std::size_t t = 0; t < kSentenceTypeCount; ++t)
+        fields[kLineCounters + t] = &c.by_type[t];
+    std::size_t next = kLineCounters + kSentenceTypeCount;
+    for (auto& by_type : c.rejects.counts)
+        for (std::size_t& n : by_type)
+            fields[next++] = &n;
+    return fields;
+}
+
+void pack_counters(IngestCounters c, std::uint64_t* out)
+{
+    const auto fields = counter_fields(c);
+    for (std::size_t i = 0; i < kCounterFields; ++i)
+        out[i] = *fields[i];
+}
+
+void unpack_counters(const std::uint64_t* in, IngestCounters& c)
+{
+    const auto fields = counter_fields(c);
+    for (std::size_t i = 0; i < kCounterFields; ++i)
+        *fields[i] += static_cast<std::size_t>(in[i]);
+}
+
+/// Atomically replace `path` with `tmp`.
+bool publish(const std::string& tmp, const std::string& path)
+{
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    return !ec;
+}
+
+} // namespace
+
+// ─── Public API ─────────────────────────────────────────────────────────────
+
+std::string CacheKey::name() const
+{
+    std::uint64_t h = fnv1a(kFnvOffset, size);
+    h = fnv1a(h, mtime_ns);
+    h = fnv1a(h, content);
+    h = fnv1a(h, options);
+
+    static constexpr char kHex[] = "0123456789abcdef";
+    std::string out(16, '0');
+    for (std::size_t i = 0; i < out.size(); ++i)
+        out[out.size() - 1 - i] = kHex[(h >> (4 * i)) & 0xf];
+    return out;
+}
+
+ParseCache::ParseCache(const IngestOptions& opts)
+    : dir_(opts.cache_dir), options_(options_fingerprint(opts))
+{
+}
+
+CacheKey ParseCache::key(const std::string& path, std::string_view data) const
+{
+    CacheKey k;
+    k.size    = data.size();
+    k.content = sample_hash(data);
+    k.options = options_;
+    std::error_code ec;
+    const auto mtime = std::filesystem::last_write_time(path, ec);
+    if (!ec)
+        k.mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            mtime.time_since_epoch()).count();
+    return k;
+}
+
+/// Read and check the counters entry for `key`; on success the matching
+/// records file is mapped into `file`.
+static bool open_entry(const std::string& dir, const CacheKey& key, CountersEntry& entry,
+                       RouteFile& file)
+{
+    const std::string base = (std::filesystem::path(dir) / key.name()).string();
+    std::ifstream in(base + kCountersSuffix, std::ios::binary);
+    if (!in.read(reinterpret_cast<char*>(&entry), sizeof entry))
+        return false;
+    if (std::memcmp(entry.magic, kCountersMagic, sizeof kCountersMagic) != 0 ||
+        entry.version != kParseCacheVersion || entry.size != key.size ||
+        entry.mtime_ns != key.mtime_ns || entry.content != key.content ||
+        entry.options != key.options)
+        return false;
+
+    std::string error;
+    return file.open(base + kRecordsSuffix, error) &&
+           file.encoding() == RouteEncoding::kRaw && file.size() == entry.records;
+}
+
+bool ParseCache::load(const CacheKey& key, Arena& arena, Span<GpsRecord>& records,
+                      IngestCounters& counters) const
+{
+    CountersEntry entry;
+    RouteFile     file;
+    if (!open_entry(dir_, key, entry, file))
+        return false;
+
+    const RouteColumns& cols = file.columns();
+    GpsRecord* out = arena.allocate_array<GpsRecord>(cols.size);
+    for (std::size_t i = 0; i < cols.size; ++i)
+        out[i] = cols[i];
+    records = {out, cols.size};
+    unpack_counters(entry.counters, counters);
+    return true;
+}
+
+bool ParseCache::load(const CacheKey& key, const RecordSink& sink,
+                      IngestCounters& counters) const
+{
+    CountersEntry entry;
+    RouteFile     file;
+    if (!open_entry(dir_, key, entry, file))
+        return false;
+
+    const RouteColumns& cols = file.columns();
+    for (std::size_t i = 0; i < cols.size; ++i)
+        sink(cols[i]);
+    unpack_counters(entry.counters, counters);
+    return true;
+}
+
+void ParseCache::store(const CacheKey& key, Span<const GpsRecord> records,
+                       const IngestCounters& counters) const
+{
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    const std::string base = (std::filesystem::path(dir_) / key.name()).string();
+
+    // Records first, counters last: a counters file is only ever renamed
+    // into place once the records it describes are complete.
+    std::string error;
+    const std::string records_tmp = temp_name(base + kRecordsSuffix);
+    if (!write_route_binary(records, records_tmp, RouteEncoding::kRaw, error) ||
+        !publish(records_tmp, base + kRecordsSuffix)) {
+        std::filesystem::remove(records_tmp, ec);
+        std::cerr << "Warning: cannot write parse cache entry in '" << dir_ << "'\n";
+        return;
+    }
+
+    CountersEntry entry{};
+    std::memcpy(entry.magic, kCountersMagic, sizeof kCountersMagic);
+    entry.version  = kParseCacheVersion;
+    entry.size     = key.size;
+    entry.mtime_ns = key.mtime_ns;
+    entry.content  = key.content;
+    entry.options  = key.options;
+    entry.records  = records.size();
+    pack_counters(counters, entry.counters);
+
+    const std::string counters_tmp = temp_name(base + kCountersSuffix);
+    bool written;
+    {
+        std::ofstream out(counters_tmp, std::ios::binary | std::ios::trunc);
+        written = static_cast<bool>(out.write(reinterpret_cast<const char*>(&entry), sizeof entry));
+    }
+    if (!written || !publish(counters_tmp, base + kCountersSuffix)) {
+        std::filesystem::remove(counters_tmp, ec);
+        std::cerr << "Warning: cannot write parse cache entry in '" << dir_ << "'\n";
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * cache.h — Persistent per-input parse cache (--cache-dir)
+ *
+ * Stage 1 output for one input file — its validated records, in line
+ * order, and its line counters — is stored in a cache directory as a raw
+ * route file (see route_io.h) plus a small counters file.  Entries are
+ * keyed by the input's size, modification time and a hash of sampled
+ * content, together with every option that changes what parsing
+ * produces, so a later run on the same file goes straight to dedup.
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "arena.h"
+#include "fusion.h"
+#include "ingest.h"
+#include "nmea_parser.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/// Bump whenever parsing can produce different records or counters for
+/// the same bytes; older entries then simply miss.
+inline constexpr std::uint32_t kParseCacheVersion = 4;
+
+/// The content hash covers the first and last kCacheSampleBytes of a file
+/// and kCacheSampleCount evenly spaced kCacheSampleBytes windows between
+/// them, so keying a multi-gigabyte archive touches well under a
+/// megabyte.  Files up to kCacheSampleBytes × (kCacheSampleCount + 2)
+/// are hashed in full.
+inline constexpr std::size_t kCacheSampleBytes = 16u << 10;   // 16 KiB
+inline constexpr std::size_t kCacheSampleCount = 16;
+
+/// Identity of one input as the cache sees it.
+struct CacheKey {
+    std::uint64_t size     = 0;
+    std::int64_t  mtime_ns = 0;   // modification time, file clock
+    std::uint64_t content  = 0;   // sampled content hash
+    std::uint64_t options  = 0;   // fingerprint of the parse options
+
+    /// Entry base name: the key folded to 16 hex digits.
+    std::string name() const;
+};
+
+/// A cache directory.  Lookups and stores never fail the run: a missing,
+/// stale or unreadable entry is a miss, and a store that can't be
+/// written is reported on stderr and skipped.
+class ParseCache {
+public:
+    /// Cache in `opts.cache_dir` (created on the first store) for parses
+    /// with the fusion and checksum options of `opts`.
+    explicit ParseCache(const IngestOptions& opts);
+
+    /// Key for the input at `path`, whose contents are `data`.
+    CacheKey key(const std::string& path, std::string_view data) const;
+
+    /// Load the entry for `key`: the records go into a new array in
+    /// `arena`, the counters are added to `counters`.
+    bool load(const CacheKey& key, Arena& arena, Span<GpsRecord>& records,
+              IngestCounters& counters) const;
+
+    /// As above, handing each record to `sink` straight from the mapped
+    /// entry (for --stream, which keeps no record buffer).
+    bool load(const CacheKey& key, const RecordSink& sink, IngestCounters& counters) const;
+
+    /// Store one parsed input.  `counters` must cover that input alone.
+    void store(const CacheKey& key, Span<const GpsRecord> records,
+               const IngestCounters& counters) const;
+
+private:
+    std::string   dir_;
+    std::uint64_t options_;
+};
+
+#endif // CACHE_H
@@ -0,0 +1,384 @@
+/*
+ * checkpoint.cpp — Resumable streaming runs over growing inputs (--checkpoint)
+ */
+
+#include "checkpoint.h"
+#include "reader.h"
+#include "util.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <type_traits>
+
+// ─── Checkpoint constants ──────────────────────────────────────────────────
+
+static constexpr char          kCheckpointMagic[4] = {'N', 'M', 'C', 'K'};
+static constexpr std::size_t   kLineCounters       = 7;   // lines_total … quality_rejected
+static constexpr std::size_t   kRejectCounters     = kRejectReasonCount * kSentenceTypeCount;
+static constexpr std::size_t   kCounterFields      = kLineCounters + kSentenceTypeCount + kRejectCounters;
+
+namespace {
+
+// ─── Hashing ────────────────────────────────────────────────────────────────
+
+/// Hashes of the first and the last kCheckpointProbeBytes of the first
+/// `size` bytes of `data` (which holds at least that many).
+void probe_hashes(std::string_view data, std::uint64_t size, std::uint64_t& head,
+                  std::uint64_t& tail)
+{
+    const auto n     = static_cast<std::size_t>(size);
+    const auto probe = std::min(n, kCheckpointProbeBytes);
+    head = fnv1a(kFnvOffset, data.data(), probe);
+    tail = fnv1a(kFnvOffset, data.data() + n - probe, probe);
+}
+
+/// True if the input behind `mark` still starts with the bytes it had
+/// when the mark was taken.
+bool input_unchanged(const InputMark& mark)
+{
+    InputFile file;
+    if (!file.open(mark.path) || file.size() < mark.size)
+        return false;
+    std::uint64_t head, tail;
+    probe_hashes(file.data(), mark.size, head, tail);
+    return head == mark.head && tail == mark.tail;
+}
+
+// ─── Counters ───────────────────────────────────────────────────────────────
+
+/// The line counters kept in a checkpoint, in on-disk order (as in a
+/// parse cache entry).
+std::array<std::size_t*, kCounterFields> counter_fields(IngestCounters& c)
+{
+    std::array<std::size_t*, kCounterFields> fields = {
+        &c.lines_total, &c.checksum_fail, &c.not_relevant, &c.parse_fail,
+        &c.epoch_lines, &c.fused, &c.quality_rejected};
+    for (std::size_t t = 0; t < kSentenceTypeCount; ++t)
+        fields[kLineCounters + t] = &c.by_type[t];
+    std::size_t next = kLineCounters + kSentenceTypeCount;
+    for (auto& by_type : c.rejects.counts)
+        for (std::size_t& n : by_type)
+            fields[next++] = &n;
+    return fields;
+}
+
+std::array<std::size_t*, 9> pipeline_counter_fields(PipelineCounters& c)
+{
+    return {&c.lines, &c.skipped, &c.checksum_fail, &c.parse_fail, &c.records,
+            &c.late_dropped, &c.future_dropped, &c.after_lww, &c.route_points};
+}
+
+// ─── Binary encoding ────────────────────────────────────────────────────────
+//
+// Fixed-width native-endian fields; counts and sizes as 64-bit.  Records
+// are stored as they are laid out in memory, so the header carries
+// sizeof(GpsRecord) and a checkpoint from a different layout is refused.
+
+class Writer {
+public:
+    explicit Writer(std::ostream& out) : out_(out) {}
+
+    template <typename T>
+    void put(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        out_.write(reinterpret_cast<const char*>(&value), sizeof value);
+    }
+    void size(std::size_t n) { put(static_cast<std::uint64_t>(n)); }
+    void flag(bool b) { put(static_cast<std::uint8_t>(b)); }
+    void string(const std::string& s)
+    {
+        size(s.size());
+        out_.write(s.data(), static_cast<std::streamsize>(s.size()));
+    }
+    void records(const std::vector<GpsRecord>& recs)
+    {
+        size(recs.size());
+        out_.write(reinterpret_cast<const char*>(recs.data()),
+                   static_cast<std::streamsize>(recs.size() * sizeof(GpsRecord)));
+    }
+
+private:
+    std::ostream& out_;
+};
+
+/// Reads back what Writer wrote.  Every read is checked against the
+/// bytes left, so a truncated or corrupt file fails instead of
+/// allocating what a garbage count asks for.
+class Reader {
+public:
+    Reader(std::istream& in, std::uint64_t bytes) : in_(in), left_(bytes) {}
+
+    bool ok() const { return ok_; }
+
+    template <typename T>
+    bool get(T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return raw(&value, sizeof value);
+    }
+    bool size(std::size_t& n)
+    {
+        std::uint64_t v = 0;
+        n = get(v) ? static_cast<std::size_t>(v) : 0;
+        return ok_;
+    }
+    bool flag(bool& b)
+    {
+        std::uint8_t v = 0;
+        b = get(v) && v != 0;
+        return ok_;
+    }
+    bool string(std::string& s)
+    {
+        std::size_t n;
+        if (!size(n) || !fits(n, 1))
+            return false;
+        s.resize(n);
+        return raw(s.data(), n);
+    }
+    bool records(std::vector<GpsRecord>& recs)
+    {
+        std::size_t n;
+        if (!size(n) || !fits(n, sizeof(GpsRecord)))
+            return false;
+        recs.resize(n);
+        return raw(recs.data(), n * sizeof(GpsRecord));
+    }
+
+private:
+    bool fits(std::size_t n, std::size_t each)
+    {
+        if (n > left_ / each)
+            ok_ = false;
+        return ok_;
+    }
+    bool raw(void* out, std::size_t bytes)
+    {
+        if (!ok_ || bytes > left_ ||
+            !in_.read(static_cast<char*>(out), static_cast<std::streamsize>(bytes)))
+            ok_ = false;
+        else
+            left_ -= bytes;
+        return ok_;
+    }
+
+    std::istream& in_;
+    std::uint64_t left_;
+    bool          ok_ = true;
+};
+
+void write_state(Writer& w, PipelineState s)
+{
+    for (const std::size_t* n : pipeline_counter_fields(s.counters))
+        w.size(*n);
+    const StreamingDedupState& win = s.window;
+    w.records(win.pending);
+    w.put(win.newest_ms);
+    w.flag(win.has_emitted);
+    w.put(win.last_emitted_ms);
+    w.size(win.emitted);
+    w.size(win.late_dropped);
+    w.flag(win.has_ahead);
+    w.put(win.ahead);
+    w.size(win.future_dropped);
+    w.flag(s.has_latest);
+    w.put(s.latest_ms);
+    w.flag(s.has_ahead);
+    w.put(s.latest_ahead);
+    w.flag(s.has_last);
+    w.put(s.last);
+}
+
+bool read_state(Reader& r, PipelineState& s)
+{
+    for (std::size_t* n : pipeline_counter_fields(s.counters))
+        r.size(*n);
+    StreamingDedupState& win = s.window;
+    r.records(win.pending);
+    r.get(win.newest_ms);
+    r.flag(win.has_emitted);
+    r.get(win.last_emitted_ms);
+    r.size(win.emitted);
+    r.size(win.late_dropped);
+    r.flag(win.has_ahead);
+    r.get(win.ahead);
+    r.size(win.future_dropped);
+    r.flag(s.has_latest);
+    r.get(s.latest_ms);
+    r.flag(s.has_ahead);
+    r.get(s.latest_ahead);
+    r.flag(s.has_last);
+    r.get(s.last);
+    return r.ok();
+}
+
+} // namespace
+
+// ─── Public API ─────────────────────────────────────────────────────────────
+
+std::uint64_t checkpoint_fingerprint(const IngestOptions& ingest,
+                                     const RuntimePipelineConfig& route)
+{
+    const FusionOptions& fusion = ingest.fusion;
+    std::uint64_t h = fnv1a(kFnvOffset, kCheckpointVersion);
+    h = fnv1a(h, ingest.checksum);
+    h = fnv1a(h, fusion.enabled);
+    if (fusion.enabled) {
+        const QualityFilter& f = fusion.filter;
+        h = fnv1a(h, f.min_fix_quality);
+        h = fnv1a(h, f.min_satellites);
+        h = fnv1a(h, f.max_hdop);
+        h = fnv1a(h, f.max_pdop);
+        h = fnv1a(h, f.max_vdop);
+    }
+    h = fnv1a(h, ingest.track_by);
+    if (ingest.track_by == TrackBy::kFile)
+        for (std::uint32_t track : ingest.file_tracks)
+            h = fnv1a(h, track);
+
+    h = fnv1a(h, route.talkers);
+    h = fnv1a(h, route.verify_checksum);
+    h = fnv1a(h, route.temporal);
+    h = fnv1a(h, route.window_ms);
+    h = fnv1a(h, route.spatial_dedup);
+    h = fnv1a(h, route.spatial.metric);
+    h = fnv1a(h, route.spatial.epsilon_deg);
+    h = fnv1a(h, route.spatial.epsilon_m);
+    return h;
+}
+
+bool mark_input(const std::string& path, std::uint64_t offset, InputMark& mark)
+{
+    InputFile file;
+    if (!file.open(path))
+        return false;
+    mark.path   = path;
+    mark.size   = file.size();
+    mark.offset = offset;
+    probe_hashes(file.data(), mark.size, mark.head, mark.tail);
+    return true;
+}
+
+bool checkpoint_matches(const Checkpoint& cp, std::uint64_t fingerprint,
+                        const std::vector<std::string>& paths, std::string& why)
+{
+    if (cp.options != fingerprint) {
+        why = "it was taken with different options";
+        return false;
+    }
+    if (cp.inputs.size() != paths.size() ||
+        !std::equal(paths.begin(), paths.end(), cp.inputs.begin(),
+                    [](const std::string& p, const InputMark& m) { return p == m.path; })) {
+        why = "it was taken for different inputs";
+        return false;
+    }
+    for (const InputMark& mark : cp.inputs) {
+        if (mark.size > 0 && !input_unchanged(mark)) {
+            why = "'" + mark.path + "' is no longer the file it was taken for";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool load_checkpoint(const std::string& path, Checkpoint& out, std::string& error)
+{
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec))
+        return false;
+    const std::uintmax_t bytes = std::filesystem::file_size(path, ec);
+    std::ifstream in(path, std::ios::binary);
+    if (ec || !in) {
+        error = "cannot read it";
+        return false;
+    }
+
+    Reader r(in, bytes);
+    char          magic[4];
+    std::uint32_t version = 0, record_bytes = 0;
+    r.get(magic);
+    r.get(version);
+    r.get(record_bytes);
+    if (!r.ok() || std::memcmp(magic, kCheckpointMagic, sizeof magic) != 0 ||
+        version != kCheckpointVersion || record_bytes != sizeof(GpsRecord)) {
+        error = "not a checkpoint of this version";
+        return false;
+    }
+
+    Checkpoint  cp;
+    std::size_t n = 0;
+    r.get(cp.options);
+    r.size(n);
+    for (std::size_t i = 0; i < n && r.ok(); ++i) {
+        InputMark& m = cp.inputs.emplace_back();
+        r.string(m.path);
+        r.get(m.size);
+        r.get(m.head);
+        r.get(m.tail);
+        r.get(m.offset);
+    }
+    for (std::size_t* field : counter_fields(cp.counters))
+        r.size(*field);
+    r.size(n);
+    for (std::size_t i = 0; i < n && r.ok(); ++i) {
+        TrackCheckpoint& t = cp.tracks.emplace_back();
+        r.get(t.track);
+        r.size(t.records);
+        read_state(r, t.state);
+        r.records(t.route);
+    }
+    if (!r.ok()) {
+        error = "truncated or corrupt";
+        return false;
+    }
+    out = std::move(cp);
+    return true;
+}
+
+bool save_checkpoint(const Checkpoint& cp, const std::string& path, std::string& error)
+{
+    const std::string tmp = temp_name(path);
+    bool written;
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        Writer w(out);
+        w.put(kCheckpointMagic);
+        w.put(kCheckpointVersion);
+        w.put(static_cast<std::uint32_t>(sizeof(GpsRecord)));
+        w.put(cp.options);
+        w.size(cp.inputs.size());
+        for (const InputMark& m : cp.inputs) {
+            w.string(m.path);
+            w.put(m.size);
+            w.put(m.head);
+            w.put(m.tail);
+            w.put(m.offset);
+        }
+        IngestCounters counters = cp.counters;
+        for (const std::size_t* field : counter_fields(counters))
+            w.size(*field);
+        w.size(cp.tracks.size());
+        for (const TrackCheckpoint& t : cp.tracks) {
+            w.put(t.track);
+            w.size(t.records);
+            write_state(w, t.state);
+            w.records(t.route);
+        }
+        written = static_cast<bool>(out.flush());
+    }
+    // Replace the old checkpoint only once the new one is complete.
+    std::error_code ec;
+    if (written)
+        std::filesystem::rename(tmp, path, ec);
+    if (!written || ec) {
+        std::filesystem::remove(tmp, ec);
+        error = "cannot write checkpoint '" + path + "'";
+        return false;
+    }
+    return true;
+}
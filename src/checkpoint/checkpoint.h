@@ -0,0 +1,89 @@
+/*
+ * checkpoint.h — Resumable streaming runs over growing inputs (--checkpoint)
+ *
+ * A capture that keeps being appended to is re-processed on every run
+ * unless the run can pick up where the last one stopped.  A checkpoint
+ * file records, for each input, how far its text has been read, plus
+ * everything the streaming route builder holds at that point: the line
+ * counters, each track's route so far and its dedup state (the open
+ * last-write-wins window and the last point kept by the spatial filter).
+ * The next run restores that, reads only the bytes appended since and
+ * carries on, so a series of incremental runs builds the same route as
+ * one run over the whole input.
+ *
+ * A checkpoint only applies to the same inputs, in the same order, under
+ * the same parse and dedup options, and only while each input still
+ * starts with the bytes that were read; anything else starts over.
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "ingest.h"
+#include "nmea_parser.h"
+#include "pipeline.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Bump whenever the file layout or the meaning of its offsets changes;
+/// older checkpoints are then discarded.
+inline constexpr std::uint32_t kCheckpointVersion = 3;
+
+/// An input is recognised by its size and hashes of up to
+/// kCheckpointProbeBytes at its start and just before that size, so an
+/// input that was replaced or rewritten rather than appended to is not
+/// resumed.
+inline constexpr std::size_t kCheckpointProbeBytes = 4096;
+
+/// How far one input has been read.
+struct InputMark {
+    std::string   path;
+    std::uint64_t size   = 0;   // file size when the checkpoint was taken
+    std::uint64_t head   = 0;   // hash of the first probe bytes
+    std::uint64_t tail   = 0;   // hash of the probe bytes before `size`
+    std::uint64_t offset = 0;   // text consumed (decoded text, if compressed)
+};
+
+/// One track's streaming state.  `route` is the route so far, before
+/// --simplify, which always runs on the whole route.
+struct TrackCheckpoint {
+    std::uint32_t          track   = 0;
+    std::size_t            records = 0;   // records pushed into the track
+    PipelineState          state;
+    std::vector<GpsRecord> route;
+};
+
+/// Everything a streaming run needs to resume.  Sampled reject lines and
+/// stage timings are per run and are not kept.
+struct Checkpoint {
+    std::uint64_t                options = 0;   // checkpoint_fingerprint()
+    std::vector<InputMark>       inputs;        // in path-list order
+    IngestCounters               counters;
+    std::vector<TrackCheckpoint> tracks;        // tracks with records, in track order
+};
+
+/// Fingerprint of every option that changes what a streaming run keeps.
+std::uint64_t checkpoint_fingerprint(const IngestOptions& ingest,
+                                     const RuntimePipelineConfig& route);
+
+/// Mark `path` as read up to `offset`.  Returns false if it can't be opened.
+bool mark_input(const std::string& path, std::uint64_t offset, InputMark& mark);
+
+/// True if `cp` can be resumed for `paths` under options `fingerprint`;
+/// otherwise `why` says what changed.
+bool checkpoint_matches(const Checkpoint& cp, std::uint64_t fingerprint,
+                        const std::vector<std::string>& paths, std::string& why);
+
+/// Read `path` into `out`.  Returns false and sets `error` if it can't be
+/// read or isn't a checkpoint of this version; a file that does not
+/// exist yet leaves `error` empty.
+bool load_checkpoint(const std::string& path, Checkpoint& out, std::string& error);
+
+/// Write `cp` to `path`, replacing it atomically.  Returns false and sets
+/// `error` on failure; the previous checkpoint is then left in place.
+bool save_checkpoint(const Checkpoint& cp, const std::string& path, std::string& error);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,447 @@
+/*
+ * cli.cpp — Command-line option parsing for the nmea_parser tool
+ */
+
+#include "cli.h"
+#include "output.h"
+
+#include <charconv>
+#include <iostream>
+#include <string_view>
+#include <system_error>
+
+// ─── Internal helpers ───────────────────────────────────────────────────────
+
+/// Parse the whole of `text` as an unsigned integer.
+template <typename T>
+static bool parse_unsigned(std::string_view text, T& out)
+{
+    const char* last = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), last, out);
+    return ec == std::errc() && ptr == last && !text.empty();
+}
+
+/// Parse the whole of `text` as a non-negative decimal number.
+static bool parse_decimal(std::string_view text, double& out)
+{
+    const char* last = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), last, out);
+    return ec == std::errc() && ptr == last && !text.empty() && out >= 0.0;
+}
+
+/// Map a --dedup-engine name onto its enumerator.
+static bool parse_dedup_engine(std::string_view name, DedupEngine& out)
+{
+    if (name == "map")  { out = DedupEngine::kOrderedMap; return true; }
+    if (name == "sort") { out = DedupEngine::kSortUnique; return true; }
+    if (name == "hash") { out = DedupEngine::kHashTable;  return true; }
+    return false;
+}
+
+/// Map a --spatial metric name onto its enumerator.
+static bool parse_spatial_metric(std::string_view name, SpatialMetric& out)
+{
+    if (name == "degrees")   { out = SpatialMetric::kDegrees;         return true; }
+    if (name == "equirect")  { out = SpatialMetric::kEquirectangular; return true; }
+    if (name == "haversine") { out = SpatialMetric::kHaversine;       return true; }
+    return false;
+}
+
+/// Map a --track-by source name onto its enumerator.
+static bool parse_track_by(std::string_view name, TrackBy& out)
+{
+    if (name == "none")   { out = TrackBy::kNone;   return true; }
+    if (name == "file")   { out = TrackBy::kFile;   return true; }
+    if (name == "talker") { out = TrackBy::kTalker; return true; }
+    return false;
+}
+
+/// Map a --simplify algorithm name onto its enumerator.
+static bool parse_simplify(std::string_view name, SimplifyAlgorithm& out)
+{
+    if (name == "none") { out = SimplifyAlgorithm::kNone;           return true; }
+    if (name == "dp")   { out = SimplifyAlgorithm::kDouglasPeucker; return true; }
+    if (name == "vw")   { out = SimplifyAlgorithm::kVisvalingam;    return true; }
+    return false;
+}
+
+// ─── Public API ─────────────────────────────────────────────────────────────
+
+bool parse_cli(int argc, char* argv[], CliOptions& out, std::string& error)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+
+        // Fetch the value of an option that takes one.
+        auto value = [&](std::string_view& v) {
+            if (i + 1 >= argc) {
+                error = "option '" + std::string(arg) + "' requires a value";
+                return false;
+            }
+            v = argv[++i];
+            return true;
+        };
+
+        if (arg == "--jobs" || arg == "-j") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            if (!parse_unsigned(v, out.ingest.jobs)) {
+                error = "invalid job count '" + std::string(v) + "'";
+                return false;
+            }
+        } else if (arg == "--chunk-size") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            if (!parse_unsigned(v, out.ingest.chunk_bytes) ||
+                out.ingest.chunk_bytes == 0) {
+                error = "invalid chunk size '" + std::string(v) + "'";
+                return false;
+            }
+        } else if (arg == "--dedup-engine") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            if (!parse_dedup_engine(v, out.dedup_engine)) {
+                error = "unknown dedup engine '" + std::string(v) + "'";
+                return false;
+            }
+        } else if (arg == "--stream") {
+            out.stream = true;
+        } else if (arg == "--pipeline") {
+            out.stream   = true;
+            out.pipeline = true;
+        } else if (arg == "--window") {
+            std::string_view v;
+            std::uint32_t ms = 0;
+            if (!value(v))
+                return false;
+            if (!parse_unsigned(v, ms)) {
+                error = "invalid reorder window '" + std::string(v) + "'";
+                return false;
+            }
+            out.window_ms = ms;
+        } else if (arg == "--live") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            out.live = std::string(v);
+        } else if (arg == "--fast-reject" || arg == "--checksum-all") {
+            out.ingest.checksum = arg == "--fast-reject" ? ChecksumPolicy::kRelevant
+                                                         : ChecksumPolicy::kAll;
+            out.line_types = true;
+        } else if (arg == "--fuse") {
+            out.ingest.fusion.enabled = true;
+        } else if (arg == "--min-fix-quality" || arg == "--min-sats") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            unsigned& field = arg == "--min-sats" ? out.ingest.fusion.filter.min_satellites
+                                                  : out.ingest.fusion.filter.min_fix_quality;
+            if (!parse_unsigned(v, field)) {
+                error = "invalid value '" + std::string(v) + "' for " + std::string(arg);
+                return false;
+            }
+            out.ingest.fusion.enabled = true;
+        } else if (arg == "--max-hdop" || arg == "--max-pdop" || arg == "--max-vdop") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            QualityFilter& f = out.ingest.fusion.filter;
+            double& field = arg == "--max-hdop" ? f.max_hdop
+                          : arg == "--max-pdop" ? f.max_pdop : f.max_vdop;
+            if (!parse_decimal(v, field)) {
+                error = "invalid value '" + std::string(v) + "' for " + std::string(arg);
+                return false;
+            }
+            out.ingest.fusion.enabled = true;
+        } else if (arg == "--spatial") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            if (!parse_spatial_metric(v, out.spatial.metric)) {
+                error = "unknown spatial metric '" + std::string(v) + "'";
+                return false;
+            }
+        } else if (arg == "--spatial-eps-m") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            if (!parse_decimal(v, out.spatial.epsilon_m)) {
+                error = "invalid value '" + std::string(v) + "' for " + std::string(arg);
+                return false;
+            }
+            if (out.spatial.metric == SpatialMetric::kDegrees)
+                out.spatial.metric = SpatialMetric::kHaversine;
+        } else if (arg == "--simplify") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            if (!parse_simplify(v, out.spatial.simplify)) {
+                error = "unknown simplification '" + std::string(v) + "'";
+                return false;
+            }
+        } else if (arg == "--simplify-tolerance") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            if (!parse_decimal(v, out.spatial.tolerance)) {
+                error = "invalid value '" + std::string(v) + "' for " + std::string(arg);
+                return false;
+            }
+        } else if (arg == "--url-waypoints") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            if (!parse_unsigned(v, out.url_waypoints) || out.url_waypoints == 1) {
+                error = "invalid waypoint limit '" + std::string(v) + "' (0 or at least 2)";
+                return false;
+            }
+        } else if (arg == "--export-bin" || arg == "--export-geojson" || arg == "--export-csv") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            std::string& field = arg == "--export-bin"     ? out.export_bin
+                               : arg == "--export-geojson" ? out.export_geojson
+                                                           : out.export_csv;
+            field = std::string(v);
+        } else if (arg == "--export-index") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            if (v == "-") {
+                error = "--export-index writes a binary index and needs a file name";
+                return false;
+            }
+            out.export_index = std::string(v);
+        } else if (arg == "--from" || arg == "--to") {
+            std::string_view v;
+            std::int64_t ms = 0;
+            if (!value(v))
+                return false;
+            if (!parse_query_time(v, ms)) {
+                error = "invalid time '" + std::string(v) + "' for " + std::string(arg) +
+                        " (Unix ms or YYYY-MM-DD[THH:MM[:SS[.sss]]])";
+                return false;
+            }
+            (arg == "--from" ? out.query.from_ms : out.query.to_ms) = ms;
+        } else if (arg == "--bbox") {
+            std::string_view v;
+            GeoBox box;
+            if (!value(v))
+                return false;
+            if (!parse_geo_box(v, box)) {
+                error = "invalid bounding box '" + std::string(v) + "' (WEST,SOUTH,EAST,NORTH)";
+                return false;
+            }
+            out.query.bbox = box;
+        } else if (arg == "--delta") {
+            out.export_encoding = RouteEncoding::kDelta;
+        } else if (arg == "--track-by") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            if (!parse_track_by(v, out.ingest.track_by)) {
+                error = "unknown track source '" + std::string(v) + "'";
+                return false;
+            }
+        } else if (arg == "--track") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            const std::size_t eq = v.find('=');
+            if (eq == 0 || eq == std::string_view::npos || eq + 1 == v.size()) {
+                error = "invalid track mapping '" + std::string(v) + "' (NAME=FILE)";
+                return false;
+            }
+            out.track_map.emplace_back(std::string(v.substr(0, eq)), std::string(v.substr(eq + 1)));
+            out.inputs.emplace_back(v.substr(eq + 1));
+        } else if (arg == "--cache-dir") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            out.ingest.cache_dir = std::string(v);
+        } else if (arg == "--checkpoint") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            out.checkpoint = std::string(v);
+            out.stream     = true;
+        } else if (arg == "--stats") {
+            out.stats = true;
+        } else if (arg == "--stats-json") {
+            std::string_view v;
+            if (!value(v))
+                return false;
+            out.stats_json = std::string(v);
+        } else if (arg == "--") {
+            for (++i; i < argc; ++i)
+                out.inputs.emplace_back(argv[i]);
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            error = "unknown option '" + std::string(arg) + "'";
+            return false;
+        } else {
+            out.inputs.emplace_back(arg);
+        }
+    }
+
+    if (!out.track_map.empty()) {
+        if (out.ingest.track_by == TrackBy::kTalker) {
+            error = "--track maps input files and cannot be combined with --track-by talker";
+            return false;
+        }
+        out.ingest.track_by = TrackBy::kFile;
+    }
+    if (out.ingest.track_by == TrackBy::kTalker && !out.ingest.cache_dir.empty()) {
+        error = "--cache-dir does not store talker IDs and cannot be combined with --track-by talker";
+        return false;
+    }
+
+    // An export or --stats-json to "-" owns stdout: the summary and route
+    // table are not printed, and only one such target, for one route, is
+    // allowed.
+    const int stdout_exports = (out.export_bin == "-") + (out.export_geojson == "-") +
+                               (out.export_csv == "-");
+    if (stdout_exports + (out.stats_json == "-") > 1) {
+        error = "only one export or --stats-json can be written to stdout ('-')";
+        return false;
+    }
+    out.data_to_stdout = stdout_exports + (out.stats_json == "-") == 1;
+    if (stdout_exports == 1 && out.ingest.track_by != TrackBy::kNone) {
+        error = "an export to stdout ('-') holds one route; with --track-by or --track "
+                "give each export a file name";
+        return false;
+    }
+
+    if (out.query.from_ms && out.query.to_ms && *out.query.from_ms >= *out.query.to_ms) {
+        error = "--from must be before --to";
+        return false;
+    }
+
+    if (!out.checkpoint.empty()) {
+        if (out.pipeline) {
+            error = "--checkpoint resumes --stream runs and cannot be combined with --pipeline";
+            return false;
+        }
+        if (!out.live.empty()) {
+            error = "--checkpoint applies to input files and is not supported with --live";
+            return false;
+        }
+        if (!out.ingest.cache_dir.empty()) {
+            error = "--checkpoint already skips the bytes read before and cannot be "
+                    "combined with --cache-dir";
+            return false;
+        }
+    }
+
+    if (!out.live.empty()) {
+        if (!out.inputs.empty()) {
+            error = "--live cannot be combined with input files";
+            return false;
+        }
+        if (out.ingest.fusion.enabled) {
+            error = "--fuse and quality filters are not supported with --live";
+            return false;
+        }
+        if (out.spatial.simplify != SimplifyAlgorithm::kNone) {
+            error = "--simplify needs the whole route and is not supported with --live";
+            return false;
+        }
+        if (out.ingest.track_by != TrackBy::kNone) {
+            error = "--track-by and --track are not supported with --live";
+            return false;
+        }
+        if (!out.ingest.cache_dir.empty()) {
+            error = "--cache-dir caches input files and is not supported with --live";
+            return false;
+        }
+        if (!out.export_bin.empty() || !out.export_geojson.empty() || !out.export_csv.empty() ||
+            !out.export_index.empty()) {
+            error = "route exports are not supported with --live";
+            return false;
+        }
+        if (out.query.active()) {
+            error = "--from, --to and --bbox select from the final route and are not "
+                    "supported with --live";
+            return false;
+        }
+        if (out.pipeline) {
+            error = "--pipeline applies to input files; --live always reads on its own thread";
+            return false;
+        }
+        return true;
+    }
+    if (out.inputs.empty()) {
+        error = "no input files";
+        return false;
+    }
+    return true;
+}
+
+void print_usage(const char* prog)
+{
+    std::cerr << "Usage: " << prog << " [options] <file.nmea> [file2.nmea …]\n"
+              << "       " << prog << " [options] --live SOURCE\n"
+              << "\n"
+              << "Input files may be gzip or zstd compressed (recognised by content).\n"
+              << "\n"
+              << "Options:\n"
+              << "  -j, --jobs N         parse with N threads (0 = one per core, default 1)\n"
+              << "  --chunk-size BYTES   split files into chunks of ~BYTES for --jobs\n"
+              << "                       (default " << kDefaultChunkBytes << ")\n"
+              << "  --dedup-engine E     timestamp dedup engine: sort (default), hash, map\n"
+              << "  --stream             bounded-memory streaming dedup (ignores --jobs)\n"
+              << "  --pipeline           --stream on threads: reader, N parse workers (--jobs)\n"
+              << "                       and dedup overlap, joined by bounded rings\n"
+              << "  --window MS          streaming reorder window in ms (default "
+              << kDefaultReorderWindowMs << ", 0 with --live)\n"
+              << "  --live SOURCE        read a live stream instead of files:\n"
+              << "                         serial:/dev/ttyUSB0[@BAUD], tcp://HOST:PORT,\n"
+              << "                         gpsd://HOST[:PORT]\n"
+              << "  --fast-reject        classify lines first and skip the checksum of types\n"
+              << "                       that are discarded anyway; prints lines per type\n"
+              << "  --checksum-all       verify every checksum (the default; for audit runs,\n"
+              << "                       overrides an earlier --fast-reject); prints lines per type\n"
+              << "  --fuse               join GGA/GSA quality to each RMC (single pass)\n"
+              << "  --min-fix-quality N  drop fixes with GGA quality below N (implies --fuse)\n"
+              << "  --min-sats N         drop fixes using fewer than N satellites\n"
+              << "  --max-hdop X         drop fixes with HDOP above X\n"
+              << "  --max-pdop X         drop fixes with PDOP above X (needs GSA)\n"
+              << "  --max-vdop X         drop fixes with VDOP above X (needs GSA)\n"
+              << "  --spatial M          jitter test: degrees (default), equirect, haversine\n"
+              << "  --spatial-eps-m M    metre threshold for equirect/haversine (default "
+              << kDefaultSpatialEpsilonM << ";\n"
+              << "                       implies --spatial haversine if no metric given)\n"
+              << "  --simplify A         thin the route: dp (Douglas-Peucker), vw (Visvalingam)\n"
+              << "  --simplify-tolerance X\n"
+              << "                       dp: metres (default " << kDefaultDpToleranceM
+              << "), vw: m² (default " << kDefaultVwAreaM2 << ")\n"
+              << "  --url-waypoints N    split the Maps URL into legs of at most N points\n"
+              << "                       (0 = one URL, default; Maps accepts "
+              << kGoogleMapsMaxWaypoints << ")\n"
+              << "  --track-by S         separate routes by: none (default), file, talker\n"
+              << "  --track NAME=FILE    add input FILE on track NAME (implies --track-by\n"
+              << "                       file; files may share a track)\n"
+              << "  --cache-dir DIR      reuse parsed records of unchanged inputs from DIR\n"
+              << "                       (filled by batch runs; --stream only reads it)\n"
+              << "  --checkpoint FILE    resume from FILE: read only what was appended to the\n"
+              << "                       inputs since the last run, then update FILE\n"
+              << "                       (implies --stream)\n"
+              << "  --export-bin FILE    write the route as a binary columnar file (- = stdout,\n"
+              << "                       which then carries only the export)\n"
+              << "  --delta              delta + varint encode the --export-bin columns\n"
+              << "  --export-geojson FILE\n"
+              << "                       write the route as a GeoJSON FeatureCollection (- too)\n"
+              << "  --export-csv FILE    write the route as CSV (- too)\n"
+              << "  --export-index FILE  write a time + grid index of the route, for\n"
+              << "                       queries against the --export-bin file\n"
+              << "  --from TIME          keep points at or after TIME (Unix ms or UTC\n"
+              << "                       YYYY-MM-DD[THH:MM[:SS[.sss]]])\n"
+              << "  --to TIME            keep points before TIME\n"
+              << "  --bbox W,S,E,N       keep points inside the box (degrees; W > E crosses\n"
+              << "                       the antimeridian)\n"
+              << "  --stats              print per-stage timing, throughput and peak RSS\n"
+              << "  --stats-json FILE    write the same figures as JSON (- = stdout, which\n"
+              << "                       then carries only the JSON)\n";
+}
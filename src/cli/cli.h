@@ -0,0 +1,56 @@
+/*
+ * cli.h — Command-line option parsing for the nmea_parser tool
+ */
+
+#ifndef CLI_H
+#define CLI_H
+
+#include "dedup.h"
+#include "ingest.h"
+#include "query.h"
+#include "route_io.h"
+#include "spatial.h"
+#include "track.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/// Everything the command line can configure.  Defaults reproduce the
+/// original single-threaded behaviour.
+struct CliOptions {
+    std::vector<std::string> inputs;   // NMEA files, processed in order
+    IngestOptions            ingest;   // --jobs N, --chunk-size BYTES, --fuse + filters, --cache-dir,
+                                       // --fast-reject / --checksum-all
+    bool                     line_types = false;   // print lines per sentence type
+    DedupEngine              dedup_engine = kDefaultDedupEngine;  // --dedup-engine
+    bool                     stream = false;                      // --stream (also set by --pipeline)
+    bool                     pipeline = false;                    // --pipeline
+    std::optional<std::int64_t> window_ms;   // --window MS (mode-specific default)
+    std::string              live;           // --live SOURCE
+    SpatialOptions           spatial;        // --spatial, --spatial-eps-m, --simplify*
+    TrackMapping             track_map;      // --track NAME=FILE (also listed in inputs)
+    std::size_t              url_waypoints = 0;   // --url-waypoints N (0 = one URL)
+    std::string              checkpoint;      // --checkpoint FILE (implies --stream)
+    std::string              export_bin;      // --export-bin FILE
+    RouteEncoding            export_encoding = RouteEncoding::kRaw;   // --delta
+    std::string              export_geojson;  // --export-geojson FILE
+    std::string              export_csv;      // --export-csv FILE
+    std::string              export_index;    // --export-index FILE
+    bool                     data_to_stdout = false;   // an export or --stats-json is "-":
+                                                       // no text report on stdout
+    RouteQuery               query;           // --from, --to, --bbox
+    bool                     stats = false;  // --stats
+    std::string              stats_json;     // --stats-json FILE ("-" = stdout)
+};
+
+/// Parse `argv` into `out`.  Returns false and sets `error` on a malformed
+/// command line (unknown option, missing value, no input files).
+bool parse_cli(int argc, char* argv[], CliOptions& out, std::string& error);
+
+/// Print the usage synopsis for `prog` to stderr.
+void print_usage(const char* prog);
+
+#endif // CLI_H
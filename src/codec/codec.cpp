@@ -0,0 +1,314 @@
+/*
+ * codec.cpp — Transparent gzip / zstd input decoding
+ */
+
+#include "codec.h"
+#include "fusion.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <utility>
+
+#ifdef NMEA_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef NMEA_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// ─── Codec constants ───────────────────────────────────────────────────────
+
+static constexpr unsigned char kGzipMagic[] = {0x1f, 0x8b};
+static constexpr unsigned char kZstdMagic[] = {0x28, 0xb5, 0x2f, 0xfd};
+static constexpr int           kGzipWindowBits = 15 + 16;   // max window, gzip wrapper only
+
+namespace {
+
+bool starts_with(std::string_view data, const unsigned char* magic, std::size_t size)
+{
+    return data.size() >= size && std::memcmp(data.data(), magic, size) == 0;
+}
+
+/// Length of the lookback for text ending at `end` of `buf`: up to
+/// kFusionLookbackBytes before it, starting at a line boundary (as
+/// ingest's lookback_before on a mapped file).
+std::size_t lookback_length(const std::vector<char>& buf, std::size_t end)
+{
+    std::size_t start = end > kFusionLookbackBytes ? end - kFusionLookbackBytes : 0;
+    if (start > 0) {
+        const auto* nl = static_cast<const char*>(
+            std::memchr(buf.data() + start, '\n', end - start));
+        if (!nl)
+            return 0;
+        start = static_cast<std::size_t>(nl - buf.data()) + 1;
+    }
+    return end - start;
+}
+
+} // namespace
+
+// ─── Format detection ──────────────────────────────────────────────────────
+
+Compression detect_compression(std::string_view data)
+{
+    if (starts_with(data, kGzipMagic, sizeof kGzipMagic))
+        return Compression::kGzip;
+    if (starts_with(data, kZstdMagic, sizeof kZstdMagic))
+        return Compression::kZstd;
+    return Compression::kNone;
+}
+
+bool compression_available(Compression c)
+{
+    switch (c) {
+    case Compression::kNone: return true;
+#ifdef NMEA_HAVE_ZLIB
+    case Compression::kGzip: return true;
+#endif
+#ifdef NMEA_HAVE_ZSTD
+    case Compression::kZstd: return true;
+#endif
+    default:                 return false;
+    }
+}
+
+const char* compression_name(Compression c)
+{
+    switch (c) {
+    case Compression::kNone: return "plain";
+    case Compression::kGzip: return "gzip";
+    case Compression::kZstd: return "zstd";
+    }
+    return "?";
+}
+
+// ─── BlockDecoder ───────────────────────────────────────────────────────────
+
+/// Per-format stream state.  `pos` is how much of `in` has been passed
+/// to the library.
+struct BlockDecoder::State {
+    Compression      format;
+    std::string_view in;
+    std::size_t      pos      = 0;
+    bool             finished = false;   // end of stream or error
+#ifdef NMEA_HAVE_ZLIB
+    z_stream         z{};
+    bool             z_ready  = false;
+#endif
+#ifdef NMEA_HAVE_ZSTD
+    ZSTD_DStream*    zs       = nullptr;
+    ZSTD_inBuffer    zin{};
+#endif
+};
+
+BlockDecoder::BlockDecoder(std::string_view data, Compression c, std::size_t block_bytes)
+    : state_(std::make_unique<State>()), block_bytes_(std::max(block_bytes, kFusionLookbackBytes))
+{
+    State& s = *state_;
+    s.format = c;
+    s.in     = data;
+    switch (c) {
+#ifdef NMEA_HAVE_ZLIB
+    case Compression::kGzip:
+        s.z_ready = inflateInit2(&s.z, kGzipWindowBits) == Z_OK;
+        if (!s.z_ready)
+            error_ = "cannot initialise zlib";
+        break;
+#endif
+#ifdef NMEA_HAVE_ZSTD
+    case Compression::kZstd:
+        s.zs  = ZSTD_createDStream();
+        s.zin = {data.data(), data.size(), 0};
+        if (!s.zs)
+            error_ = "cannot initialise zstd";
+        break;
+#endif
+    default:
+        error_ = std::string(compression_name(c)) + " input is not supported by this build";
+        break;
+    }
+    s.finished = !error_.empty();
+}
+
+BlockDecoder::~BlockDecoder()
+{
+#ifdef NMEA_HAVE_ZLIB
+    if (state_->z_ready)
+        inflateEnd(&state_->z);
+#endif
+#ifdef NMEA_HAVE_ZSTD
+    if (state_->zs)
+        ZSTD_freeDStream(state_->zs);
+#endif
+}
+
+std::size_t BlockDecoder::decode_more(std::vector<char>& out, std::size_t room)
+{
+    State& s = *state_;
+    if (s.finished)
+        return 0;
+    const std::size_t old = out.size();
+    out.resize(old + room);
+    std::size_t produced = 0;
+
+    switch (s.format) {
+#ifdef NMEA_HAVE_ZLIB
+    case Compression::kGzip: {
+        z_stream& z = s.z;
+        z.next_out  = reinterpret_cast<Bytef*>(out.data() + old);
+        z.avail_out = static_cast<uInt>(room);
+        while (z.avail_out > 0) {
+            if (z.avail_in == 0) {
+                // avail_in is 32-bit: feed multi-gigabyte inputs in slices.
+                const std::size_t slice = std::min<std::size_t>(s.in.size() - s.pos, UINT_MAX);
+                if (slice == 0) {
+                    error_     = "truncated gzip stream";
+                    s.finished = true;
+                    break;
+                }
+                z.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(s.in.data() + s.pos));
+                z.avail_in = static_cast<uInt>(slice);
+                s.pos     += slice;
+            }
+            const int rc = ::inflate(&z, Z_NO_FLUSH);
+            if (rc == Z_STREAM_END) {
+                // Another member may follow (as from `cat a.gz b.gz`);
+                // anything else after a member is ignored, as by gzip(1).
+                const std::size_t at = s.pos - z.avail_in;
+                if (!starts_with(s.in.substr(at), kGzipMagic, sizeof kGzipMagic)) {
+                    s.finished = true;
+                    break;
+                }
+                inflateReset(&z);
+                continue;
+            }
+            if (rc != Z_OK && !(rc == Z_BUF_ERROR && z.avail_in == 0)) {
+                error_ = "corrupt gzip stream";
+                if (z.msg)
+                    error_ += std::string(": ") + z.msg;
+                s.finished = true;
+                break;
+            }
+        }
+        produced = room - z.avail_out;
+        break;
+    }
+#endif
+#ifdef NMEA_HAVE_ZSTD
+    case Compression::kZstd: {
+        ZSTD_outBuffer zout{out.data() + old, room, 0};
+        while (zout.pos < zout.size) {
+            const std::size_t rc = ZSTD_decompressStream(s.zs, &zout, &s.zin);
+            if (ZSTD_isError(rc)) {
+                error_     = std::string("corrupt zstd stream: ") + ZSTD_getErrorName(rc);
+                s.finished = true;
+                break;
+            }
+            // Output not full with the input used up: everything is out.
+            if (s.zin.pos == s.zin.size && zout.pos < zout.size) {
+                if (rc != 0)
+                    error_ = "truncated zstd stream";
+                s.finished = true;
+                break;
+            }
+        }
+        produced = zout.pos;
+        break;
+    }
+#endif
+    default:
+        s.finished = true;
+        break;
+    }
+    out.resize(old + produced);
+    return produced;
+}
+
+bool BlockDecoder::next(DecodedBlock& block)
+{
+    if (done_)
+        return false;
+    std::vector<char>& buf = block.buffer;
+    buf.assign(carry_.begin(), carry_.end());
+    block.lookback = carry_lookback_;
+    block.offset   = decoded_;
+
+    // Decode at least a block's worth of text, then cut after its last
+    // '\n' (the carried partial line has none).  A line longer than a
+    // block keeps decoding until it ends.
+    std::size_t scanned = buf.size();
+    std::size_t cut     = 0;
+    for (;;) {
+        const std::size_t text = buf.size() - block.lookback;
+        const std::size_t room = text < block_bytes_ ? block_bytes_ - text : block_bytes_;
+        if (decode_more(buf, room) == 0) {
+            done_ = true;
+            cut   = buf.size();
+            break;
+        }
+        if (buf.size() - block.lookback < block_bytes_)
+            continue;
+        const std::string_view fresh(buf.data() + scanned, buf.size() - scanned);
+        const std::size_t nl = fresh.rfind('\n');
+        if (nl != std::string_view::npos) {
+            cut = scanned + nl + 1;
+            break;
+        }
+        scanned = buf.size();
+    }
+    if (cut == block.lookback)
+        return false;   // nothing left after the last full line
+
+    carry_lookback_ = lookback_length(buf, cut);
+    carry_.assign(buf.begin() + static_cast<std::ptrdiff_t>(cut - carry_lookback_), buf.end());
+    buf.resize(cut);
+    decoded_ += cut - block.lookback;
+    return true;
+}
+
+// ─── DecodeStream ───────────────────────────────────────────────────────────
+
+DecodeStream::DecodeStream(std::string_view data, Compression c, std::size_t block_bytes)
+    : decoder_(data, c, block_bytes)
+{
+    thread_ = std::thread([this] { run(); });
+}
+
+DecodeStream::~DecodeStream()
+{
+    stop_.store(true, std::memory_order_relaxed);
+    thread_.join();
+}
+
+void DecodeStream::run()
+{
+    DecodedBlock block;
+    for (;;) {
+        spare_.try_pop(&block, 1);
+        bool more;
+        {
+            StageTimer timer(timing_);
+            more = decoder_.next(block);
+        }
+        if (!more)
+            break;
+        // ready_.push would wait forever for a consumer that has gone.
+        RingBackoff backoff;
+        while (ready_.try_push(&block, 1) == 0) {
+            if (stop_.load(std::memory_order_relaxed)) {
+                ready_.close();
+                return;
+            }
+            backoff.wait();
+        }
+    }
+    ready_.close();
+}
+
+bool DecodeStream::next(DecodedBlock& block)
+{
+    if (block.buffer.capacity())
+        spare_.try_push(&block, 1);
+    return ready_.pop(block);
+}
@@ -0,0 +1,147 @@
+/*
+ * codec.h — Transparent gzip / zstd input decoding
+ *
+ * Archived captures are usually stored compressed.  An input is
+ * recognised by its magic bytes, not its name, and decoded straight from
+ * its mapping into newline-aligned text blocks that feed line splitting
+ * directly: nothing is written to disk and only a few blocks are ever
+ * resident.  Each block starts with a copy of the tail of the text before
+ * it, so epoch fusion sees the same lookback as on a plain file.
+ *
+ * Support for each format is compiled in when the Makefile finds its
+ * library (NMEA_HAVE_ZLIB, NMEA_HAVE_ZSTD); an input in a format that is
+ * not built in is reported and skipped.
+ */
+
+#ifndef CODEC_H
+#define CODEC_H
+
+#include "ring.h"
+#include "stats.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/// Decoded text handed out per block.  A block ends just after a '\n'
+/// (or at end of stream), so it may run past this by one line.
+inline constexpr std::size_t kDecodeBlockBytes = 256u << 10;   // 256 KiB
+
+/// Blocks a DecodeStream's thread may decode ahead of its consumer.
+inline constexpr std::size_t kDecodeRingBlocks = 4;
+
+/// Container format of an input, by magic bytes.
+enum class Compression : std::uint8_t {
+    kNone,   // plain text
+    kGzip,   // 1f 8b (RFC 1952; concatenated members are one stream)
+    kZstd,   // 28 b5 2f fd (concatenated frames are one stream)
+};
+
+/// Format of `data`, judged by its first bytes.
+Compression detect_compression(std::string_view data);
+
+/// True if inputs in `c` can be decoded by this build.
+bool compression_available(Compression c);
+
+/// "plain", "gzip" or "zstd".
+const char* compression_name(Compression c);
+
+/// One newline-aligned piece of decoded text.  `buffer` holds the
+/// lookback (up to kFusionLookbackBytes of the preceding text, from a
+/// line start) followed by the block's own text.  Views are derived on
+/// demand, so a block may be moved freely.
+struct DecodedBlock {
+    std::vector<char> buffer;
+    std::size_t       lookback = 0;   // leading bytes of `buffer` that are lookback
+    std::size_t       offset   = 0;   // where text() starts in the decoded stream
+
+    std::string_view lookback_text() const { return {buffer.data(), lookback}; }
+    std::string_view text() const
+    {
+        return {buffer.data() + lookback, buffer.size() - lookback};
+    }
+};
+
+/// Incremental decoder over one compressed input, run on the calling
+/// thread.  The input must stay mapped while the decoder is in use.
+class BlockDecoder {
+public:
+    /// Decode `data`, which is in format `c` (compression_available(c)),
+    /// in blocks of `block_bytes` (at least kFusionLookbackBytes, so a
+    /// block's lookback always comes from the block before it).
+    BlockDecoder(std::string_view data, Compression c,
+                 std::size_t block_bytes = kDecodeBlockBytes);
+    ~BlockDecoder();
+
+    BlockDecoder(const BlockDecoder&)            = delete;
+    BlockDecoder& operator=(const BlockDecoder&) = delete;
+
+    /// Decode the next block into `block`, reusing its buffer.  Returns
+    /// false at end of stream or on a decode error; the text decoded
+    /// before a corrupt or truncated point is still handed out.
+    bool next(DecodedBlock& block);
+
+    /// Why decoding stopped early; empty after a clean end of stream.
+    const std::string& error() const { return error_; }
+
+    /// Decoded bytes handed out so far.
+    std::uint64_t decoded_bytes() const { return decoded_; }
+
+private:
+    struct State;
+
+    /// Append up to `room` decoded bytes to `out`.  Returns how many were
+    /// added; 0 means end of stream (or an error, in `error_`).
+    std::size_t decode_more(std::vector<char>& out, std::size_t room);
+
+    std::unique_ptr<State> state_;
+    std::size_t            block_bytes_;
+    std::vector<char>      carry_;      // lookback + partial line for the next block
+    std::size_t            carry_lookback_ = 0;
+    std::uint64_t          decoded_ = 0;
+    bool                   done_    = false;
+    std::string            error_;
+};
+
+/// A BlockDecoder running on its own thread, kDecodeRingBlocks ahead of
+/// the consumer, so decompression overlaps parsing.  Blocks come back
+/// through next() for their buffers to be reused.  Destroying the stream
+/// early stops the decoder thread.
+class DecodeStream {
+public:
+    DecodeStream(std::string_view data, Compression c,
+                 std::size_t block_bytes = kDecodeBlockBytes);
+    ~DecodeStream();
+
+    DecodeStream(const DecodeStream&)            = delete;
+    DecodeStream& operator=(const DecodeStream&) = delete;
+
+    /// Replace `block` with the next one; its old buffer goes back to the
+    /// decoder.  Returns false at end of stream.
+    bool next(DecodedBlock& block);
+
+    /// As BlockDecoder::error(); meaningful once next() returned false.
+    const std::string& error() const { return decoder_.error(); }
+
+    /// Time the decoder thread spent decoding; the decoded bytes are
+    /// counted where the text is split into lines.  Meaningful once
+    /// next() returned false.
+    const StageSample& timing() const { return timing_; }
+
+private:
+    void run();
+
+    BlockDecoder             decoder_;
+    SpscRing<DecodedBlock>   ready_{kDecodeRingBlocks};
+    SpscRing<DecodedBlock>   spare_{kDecodeRingBlocks};
+    StageSample              timing_;
+    std::atomic<bool>        stop_{false};
+    std::thread              thread_;
+};
+
+#endif // CODEC_H
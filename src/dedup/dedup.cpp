@@ -4,42 +4,381 @@
 
 #include "dedup.h"
 
-#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
 #include <map>
-#include <string>
+#include <utility>
 
-std::vector<GpsRecord>
-dedup_last_write_wins(const std::vector<GpsRecord>& records)
+// ─── Internal helpers ───────────────────────────────────────────────────────
+
+namespace {
+
+/// Integer dedup key paired with the record's position in the input.
+struct KeyIndex {
+    std::int64_t  key;
+    std::uint32_t index;
+};
+
+/// Hash-table load factor is at most 1/kHashSlack.
+constexpr std::size_t   kHashSlack = 2;
+constexpr std::uint32_t kEmptySlot = std::numeric_limits<std::uint32_t>::max();
+
+/// 64-bit finaliser (splitmix64) — spreads sequential timestamps evenly.
+inline std::uint64_t mix_key(std::int64_t key)
+{
+    auto x = static_cast<std::uint64_t>(key);
+    x ^= x >> 30;  x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;  x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+std::vector<GpsRecord> dedup_ordered_map(const std::vector<GpsRecord>& records)
 {
-    // Ordered map keeps timestamps sorted chronologically (lexicographic on
-    // HHMMSS.sss strings works because the format is fixed-width).
-    std::map<std::string, GpsRecord> seen;
+    // Ordered map keeps timestamps sorted chronologically.
+    std::map<std::int64_t, GpsRecord> seen;
     for (const auto& r : records)
-        seen[r.timestamp] = r;  // last write wins
+        seen[r.timestamp_ms] = r;  // last write wins
 
     std::vector<GpsRecord> result;
     result.reserve(seen.size());
     for (auto& [key, rec] : seen)
-        result.push_back(std::move(rec));
+        result.push_back(rec);
     return result;
 }
 
+Span<std::uint32_t> indices_ordered_map(Span<const GpsRecord> records, Arena& arena)
+{
+    using Node = std::pair<const std::int64_t, std::uint32_t>;
+    std::map<std::int64_t, std::uint32_t, std::less<std::int64_t>, ArenaAllocator<Node>>
+        seen{ArenaAllocator<Node>(arena)};
+    for (std::size_t i = 0; i < records.size(); ++i)
+        seen[records[i].timestamp_ms] = static_cast<std::uint32_t>(i);   // last write wins
+
+    auto* out = arena.allocate_array<std::uint32_t>(seen.size());
+    std::size_t n = 0;
+    for (const auto& [key, index] : seen)
+        out[n++] = index;
+    return {out, n};
+}
+
+Span<std::uint32_t> indices_sort_unique(Span<const GpsRecord> records, Arena& arena)
+{
+    const std::size_t n = records.size();
+    KeyIndex* order = arena.allocate_array<KeyIndex>(n);
+    for (std::size_t i = 0; i < n; ++i)
+        order[i] = {records[i].timestamp_ms, static_cast<std::uint32_t>(i)};
+
+    // Ordering by (key, index) makes the latest duplicate the last element
+    // of its run — equivalent to a stable sort, but cheaper.
+    std::sort(order, order + n, [](const KeyIndex& a, const KeyIndex& b) {
+        return a.key != b.key ? a.key < b.key : a.index < b.index;
+    });
+
+    std::size_t unique = 0;
+    for (std::size_t i = 0; i < n; ++i)
+        unique += i + 1 == n || order[i + 1].key != order[i].key;
+
+    auto* out = arena.allocate_array<std::uint32_t>(unique);
+    std::size_t m = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (i + 1 == n || order[i + 1].key != order[i].key)
+            out[m++] = order[i].index;   // last write wins
+    }
+    return {out, m};
+}
+
+Span<std::uint32_t> indices_hash_table(Span<const GpsRecord> records, Arena& arena)
+{
+    std::size_t capacity = 1;
+    while (capacity < records.size() * kHashSlack)
+        capacity <<= 1;
+    const std::size_t mask = capacity - 1;
+
+    KeyIndex* table = arena.allocate_array<KeyIndex>(capacity);
+    std::fill(table, table + capacity, KeyIndex{0, kEmptySlot});
+    std::size_t unique = 0;
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        const std::int64_t key = records[i].timestamp_ms;
+        std::size_t slot = mix_key(key) & mask;
+        while (table[slot].index != kEmptySlot && table[slot].key != key)
+            slot = (slot + 1) & mask;
+        if (table[slot].index == kEmptySlot)
+            ++unique;
+        table[slot] = {key, static_cast<std::uint32_t>(i)};   // last write wins
+    }
+
+    KeyIndex* survivors = arena.allocate_array<KeyIndex>(unique);
+    std::size_t m = 0;
+    for (std::size_t s = 0; s < capacity; ++s) {
+        if (table[s].index != kEmptySlot)
+            survivors[m++] = table[s];
+    }
+    std::sort(survivors, survivors + m,
+              [](const KeyIndex& a, const KeyIndex& b) { return a.key < b.key; });
+
+    auto* out = arena.allocate_array<std::uint32_t>(m);
+    for (std::size_t i = 0; i < m; ++i)
+        out[i] = survivors[i].index;
+    return {out, m};
+}
+
+} // namespace
+
+// ─── Public API ─────────────────────────────────────────────────────────────
+
+Span<std::uint32_t>
+dedup_last_write_wins_indices(Span<const GpsRecord> records, Arena& arena, DedupEngine engine)
+{
+    switch (engine) {
+    case DedupEngine::kSortUnique: return indices_sort_unique(records, arena);
+    case DedupEngine::kHashTable:  return indices_hash_table(records, arena);
+    case DedupEngine::kOrderedMap: break;
+    }
+    return indices_ordered_map(records, arena);
+}
+
+std::vector<std::uint32_t>
+dedup_last_write_wins_indices(const std::vector<GpsRecord>& records, DedupEngine engine)
+{
+    Arena scratch;
+    const Span<std::uint32_t> keep = dedup_last_write_wins_indices(records, scratch, engine);
+    return {keep.begin(), keep.end()};
+}
+
+std::size_t dedup_last_write_wins_in_place(Span<GpsRecord> records, DedupEngine engine)
+{
+    if (records.size() > kMaxIndexedRecords) {
+        const std::vector<GpsRecord> result =
+            dedup_ordered_map(std::vector<GpsRecord>(records.begin(), records.end()));
+        std::copy(result.begin(), result.end(), records.begin());
+        return result.size();
+    }
+
+    Arena scratch;
+    Span<std::uint32_t> keep = dedup_last_write_wins_indices(records, scratch, engine);
+
+    // Visit the survivors in input order: each one's position is then at
+    // or after its destination, so a forward compaction never overwrites
+    // a record that is still to be read.
+    if (!std::is_sorted(keep.begin(), keep.end()))
+        std::sort(keep.begin(), keep.end());
+    const std::size_t n = keep.size();
+    for (std::size_t k = 0; k < n; ++k)
+        records[k] = records[keep[k]];
+
+    // Timestamps are unique now, so an unstable sort restores the
+    // chronological order exactly.  Chronological input skips it.
+    auto by_time = [](const GpsRecord& a, const GpsRecord& b) {
+        return a.timestamp_ms < b.timestamp_ms;
+    };
+    if (!std::is_sorted(records.begin(), records.begin() + n, by_time))
+        std::sort(records.begin(), records.begin() + n, by_time);
+    return n;
+}
+
+void dedup_last_write_wins_in_place(std::vector<GpsRecord>& records, DedupEngine engine)
+{
+    records.resize(dedup_last_write_wins_in_place(Span<GpsRecord>(records), engine));
+}
+
 std::vector<GpsRecord>
-dedup_spatial(const std::vector<GpsRecord>& records, double epsilon)
+dedup_last_write_wins(const std::vector<GpsRecord>& records, DedupEngine engine)
 {
-    if (records.empty()) return {};
+    // The index-based engines address records with 32-bit indices.
+    if (records.size() > kMaxIndexedRecords)
+        return dedup_ordered_map(records);
+
+    Arena scratch;
+    return gather_records(records, dedup_last_write_wins_indices(records, scratch, engine));
+}
 
+std::vector<GpsRecord>
+dedup_spatial(const std::vector<GpsRecord>& records, double epsilon)
+{
     std::vector<GpsRecord> result;
     result.reserve(records.size());
-    result.push_back(records.front());
-
-    for (std::size_t i = 1; i < records.size(); ++i) {
-        const auto& prev = result.back();
-        const auto& cur  = records[i];
-        if (std::fabs(cur.stream.latitude  - prev.stream.latitude)  > epsilon ||
-            std::fabs(cur.stream.longitude - prev.stream.longitude) > epsilon) {
-            result.push_back(cur);
-        }
+
+    SpatialFilter filter(epsilon);
+    for (const auto& r : records) {
+        if (filter.accept(r))
+            result.push_back(r);
+    }
+    return result;
+}
+
+Span<std::uint32_t>
+dedup_spatial_indices(Span<const GpsRecord> records, Span<const std::uint32_t> order,
+                      double epsilon, Arena& arena)
+{
+    auto* out = arena.allocate_array<std::uint32_t>(order.size());
+    std::size_t n = 0;
+
+    SpatialFilter filter(epsilon);
+    for (std::uint32_t i : order) {
+        if (filter.accept(records[i]))
+            out[n++] = i;
+    }
+    return {out, n};
+}
+
+std::vector<std::uint32_t>
+dedup_spatial_indices(const std::vector<GpsRecord>& records,
+                      const std::vector<std::uint32_t>& order, double epsilon)
+{
+    Arena scratch;
+    const Span<std::uint32_t> keep = dedup_spatial_indices(records, order, epsilon, scratch);
+    return {keep.begin(), keep.end()};
+}
+
+std::size_t dedup_spatial_in_place(Span<GpsRecord> records, double epsilon)
+{
+    std::size_t n = 0;
+    SpatialFilter filter(epsilon);
+    for (const auto& r : records) {
+        if (filter.accept(r))
+            records[n++] = r;   // n never passes the read position
     }
+    return n;
+}
+
+void dedup_spatial_in_place(std::vector<GpsRecord>& records, double epsilon)
+{
+    records.resize(dedup_spatial_in_place(Span<GpsRecord>(records), epsilon));
+}
+
+std::vector<GpsRecord>
+gather_records(Span<const GpsRecord> records, Span<const std::uint32_t> order)
+{
+    std::vector<GpsRecord> result;
+    result.reserve(order.size());
+    for (std::uint32_t i : order)
+        result.push_back(records[i]);
     return result;
 }
+
+// ─── SpatialFilter ──────────────────────────────────────────────────────────
+
+bool SpatialFilter::accept(const GpsRecord& rec)
+{
+    if (has_last_ && within_units(rec, last_, epsilon_))
+        return false;
+
+    last_     = rec;
+    has_last_ = true;
+    return true;
+}
+
+// ─── StreamingDedup ─────────────────────────────────────────────────────────
+
+StreamingDedup::StreamingDedup(std::int64_t window_ms, Sink sink)
+    : window_ms_(window_ms),
+      lead_ms_(max_lead_ms(window_ms)),
+      sink_(std::move(sink))
+{
+}
+
+void StreamingDedup::push(const GpsRecord& rec)
+{
+    const std::int64_t key = rec.timestamp_ms;
+    if (has_emitted_ && key <= last_emitted_ms_) {
+        ++late_dropped_;
+        return;
+    }
+
+    // A far jump waits for a second record to confirm it.
+    const bool seen = !pending_.empty() || has_emitted_;
+    if (seen && far_ahead(key, newest_ms_)) {
+        if (has_ahead_ && !far_ahead(key, ahead_.timestamp_ms) &&
+            !far_ahead(ahead_.timestamp_ms, key)) {
+            has_ahead_ = false;
+            if (key < ahead_.timestamp_ms) {   // in time order, so neither is late
+                insert(rec);
+                insert(ahead_);
+            } else if (key > ahead_.timestamp_ms) {
+                insert(ahead_);
+                insert(rec);
+            } else {
+                insert(rec);   // last write wins
+            }
+        } else {
+            future_dropped_ += has_ahead_;
+            ahead_     = rec;
+            has_ahead_ = true;
+        }
+        return;
+    }
+    if (has_ahead_) {   // the record after it fell back: an outlier
+        ++future_dropped_;
+        has_ahead_ = false;
+    }
+    insert(rec);
+}
+
+void StreamingDedup::insert(const GpsRecord& rec)
+{
+    const std::int64_t key = rec.timestamp_ms;
+
+    // Input is mostly monotonic, so search for the slot from the back.
+    auto it = pending_.end();
+    while (it != pending_.begin() && std::prev(it)->timestamp_ms >= key)
+        --it;
+    if (it != pending_.end() && it->timestamp_ms == key)
+        *it = rec;   // last write wins
+    else
+        pending_.insert(it, rec);
+
+    newest_ms_ = std::max(newest_ms_, key);
+    while (!pending_.empty() &&
+           pending_.front().timestamp_ms + window_ms_ <= newest_ms_)
+        emit_front();
+}
+
+void StreamingDedup::flush()
+{
+    if (has_ahead_) {   // nothing contradicted it
+        has_ahead_ = false;
+        insert(ahead_);
+    }
+    while (!pending_.empty())
+        emit_front();
+}
+
+StreamingDedupState StreamingDedup::state() const
+{
+    StreamingDedupState s;
+    s.pending.assign(pending_.begin(), pending_.end());
+    s.newest_ms       = newest_ms_;
+    s.has_emitted     = has_emitted_;
+    s.last_emitted_ms = last_emitted_ms_;
+    s.emitted         = emitted_;
+    s.late_dropped    = late_dropped_;
+    s.has_ahead       = has_ahead_;
+    s.ahead           = ahead_;
+    s.future_dropped  = future_dropped_;
+    return s;
+}
+
+void StreamingDedup::restore(const StreamingDedupState& s)
+{
+    pending_.assign(s.pending.begin(), s.pending.end());
+    newest_ms_       = s.newest_ms;
+    has_emitted_     = s.has_emitted;
+    last_emitted_ms_ = s.last_emitted_ms;
+    emitted_         = s.emitted;
+    late_dropped_    = s.late_dropped;
+    has_ahead_       = s.has_ahead;
+    ahead_           = s.ahead;
+    future_dropped_  = s.future_dropped;
+}
+
+void StreamingDedup::emit_front()
+{
+    last_emitted_ms_ = pending_.front().timestamp_ms;
+    has_emitted_     = true;
+    ++emitted_;
+    sink_(pending_.front());
+    pending_.pop_front();
+}
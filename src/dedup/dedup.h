@@ -5,22 +5,219 @@
 #ifndef DEDUP_H
 #define DEDUP_H
 
+#include "arena.h"
 #include "nmea_parser.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
 #include <vector>
 
 /// Spatial deduplication epsilon in decimal degrees.
-/// ~1e-5 deg ≈ 1.1 m at the equator.
+/// ~1e-5 deg ≈ 1.1 m at the equator; compared as 100 coordinate units.
 inline constexpr double kSpatialEpsilon = 1e-5;
 
+/// Default reorder window for `StreamingDedup`, in milliseconds.  Receivers
+/// re-emit corrected epochs within a second or two, so this is generous.
+inline constexpr std::int64_t kDefaultReorderWindowMs = 5000;
+
+/// How far past the newest timestamp a `StreamingDedup` record may jump
+/// unconfirmed: `kMaxLeadWindows` windows, but never less than
+/// `kMinLeadMs`.  A farther record is held until the next one lands near
+/// it, so a single corrupt far-future date cannot flush the window.
+inline constexpr std::int64_t kMaxLeadWindows = 16;
+inline constexpr std::int64_t kMinLeadMs      = 60'000;
+
+/// The lead limit of a reorder window of `window_ms`.
+constexpr std::int64_t max_lead_ms(std::int64_t window_ms)
+{
+    return window_ms * kMaxLeadWindows > kMinLeadMs ? window_ms * kMaxLeadWindows : kMinLeadMs;
+}
+
+/// Implementation strategy for `dedup_last_write_wins`.  All engines
+/// produce identical output; they differ only in speed and memory.
+enum class DedupEngine {
+    kOrderedMap,   // std::map<timestamp, record> — the original reference
+    kSortUnique,   // sort (timestamp, index) pairs, keep the last of each run
+    kHashTable     // open-addressing timestamp → last index, then sort keys
+};
+
+inline constexpr DedupEngine kDefaultDedupEngine = DedupEngine::kSortUnique;
+
 /// Last-write-wins: keep only the final record for each unique timestamp.
 /// Returns records sorted chronologically by timestamp.
 std::vector<GpsRecord>
-dedup_last_write_wins(const std::vector<GpsRecord>& records);
+dedup_last_write_wins(const std::vector<GpsRecord>& records,
+                      DedupEngine engine = kDefaultDedupEngine);
+
+/// Largest input the index-based dedup functions accept: indices are
+/// 32-bit and one value is reserved.
+inline constexpr std::size_t kMaxIndexedRecords = UINT32_MAX - 1;
+
+/// Index form of `dedup_last_write_wins`: the positions in `records` of
+/// the surviving record for each timestamp, in chronological order.  The
+/// result and every scratch array (sort keys, hash table, map nodes) are
+/// allocated from `arena`; no record is copied.  `records.size()` must
+/// not exceed kMaxIndexedRecords.
+Span<std::uint32_t>
+dedup_last_write_wins_indices(Span<const GpsRecord> records, Arena& arena,
+                              DedupEngine engine = kDefaultDedupEngine);
+
+/// As above, returning the indices in a vector.
+std::vector<std::uint32_t>
+dedup_last_write_wins_indices(const std::vector<GpsRecord>& records,
+                              DedupEngine engine = kDefaultDedupEngine);
+
+/// In-place last-write-wins: the surviving records are moved to the front
+/// of `records` in chronological order and their count is returned.  No
+/// second copy of the records is made; scratch is 16 bytes per record
+/// and freed before returning.
+std::size_t dedup_last_write_wins_in_place(Span<GpsRecord> records,
+                                           DedupEngine engine = kDefaultDedupEngine);
+
+/// As above on a vector, erasing the tail (erase-remove style).
+void dedup_last_write_wins_in_place(std::vector<GpsRecord>& records,
+                                    DedupEngine engine = kDefaultDedupEngine);
 
 /// Spatial deduplication: suppress GPS jitter by dropping points closer than
 /// `epsilon` degrees (in either axis) from the previously kept point.
 std::vector<GpsRecord>
 dedup_spatial(const std::vector<GpsRecord>& records, double epsilon);
 
+/// Index form of `dedup_spatial` over the records `order` selects (e.g.
+/// the output of `dedup_last_write_wins_indices`).  Returns the kept
+/// subset of `order`, allocated from `arena`.
+Span<std::uint32_t>
+dedup_spatial_indices(Span<const GpsRecord> records, Span<const std::uint32_t> order,
+                      double epsilon, Arena& arena);
+
+/// As above with the index list in vectors.
+std::vector<std::uint32_t>
+dedup_spatial_indices(const std::vector<GpsRecord>& records,
+                      const std::vector<std::uint32_t>& order, double epsilon);
+
+/// In-place `dedup_spatial`: kept records are compacted to the front of
+/// `records` (order preserved) and their count is returned.
+std::size_t dedup_spatial_in_place(Span<GpsRecord> records, double epsilon);
+
+/// As above on a vector, erasing the tail.
+void dedup_spatial_in_place(std::vector<GpsRecord>& records, double epsilon);
+
+/// Copy the records `order` selects into a vector, in order.
+std::vector<GpsRecord>
+gather_records(Span<const GpsRecord> records, Span<const std::uint32_t> order);
+
+/// True if `a` and `b` are at most `epsilon` coordinate units apart in
+/// both axes — the degree jitter test, in integers.
+inline bool within_units(const GpsRecord& a, const GpsRecord& b, std::int64_t epsilon)
+{
+    const std::int64_t dlat = std::int64_t{a.lat_e7} - b.lat_e7;
+    const std::int64_t dlon = std::int64_t{a.lon_e7} - b.lon_e7;
+    return (dlat < 0 ? -dlat : dlat) <= epsilon && (dlon < 0 ? -dlon : dlon) <= epsilon;
+}
+
+/// Incremental form of `dedup_spatial`: feed records in chronological
+/// order; `accept` returns true for the ones that belong on the route.
+/// State is a single record, so memory is constant.
+class SpatialFilter {
+public:
+    explicit SpatialFilter(double epsilon = kSpatialEpsilon) : epsilon_(coord_units(epsilon)) {}
+
+    /// Return true (and remember `rec`) if it moved more than epsilon
+    /// from the last kept point in either axis.  The first point is kept.
+    bool accept(const GpsRecord& rec);
+
+    bool             has_last() const { return has_last_; }
+    const GpsRecord& last() const     { return last_; }
+
+    /// Carry on from a saved last kept point (--checkpoint).
+    void resume(const GpsRecord& last)
+    {
+        last_     = last;
+        has_last_ = true;
+    }
+
+private:
+    std::int64_t epsilon_;   // coordinate units
+    bool         has_last_ = false;
+    GpsRecord    last_{};
+};
+
+/// A StreamingDedup's progress — the open window and what it has
+/// emitted — saved by --checkpoint so a later run carries on from it.
+struct StreamingDedupState {
+    std::vector<GpsRecord> pending;   // sorted by timestamp, unique keys
+    std::int64_t           newest_ms       = std::numeric_limits<std::int64_t>::min();
+    bool                   has_emitted     = false;
+    std::int64_t           last_emitted_ms = 0;
+    std::size_t            emitted         = 0;
+    std::size_t            late_dropped    = 0;
+    bool                   has_ahead       = false;   // unconfirmed far-ahead record
+    GpsRecord              ahead{};
+    std::size_t            future_dropped  = 0;
+};
+
+/// Streaming last-write-wins with a bounded reorder window.
+///
+/// Records may arrive out of order by less than `window_ms`.  A record is
+/// held until the newest timestamp seen is at least `window_ms` past it —
+/// no later duplicate can supersede it after that — and is then passed to
+/// the sink in chronological order.  A window of 0 emits every record as
+/// soon as it arrives (lowest latency; later duplicates count as late).
+/// Memory is bounded by the number of epochs in one window, regardless of
+/// input size.  Records older than something already emitted arrive too
+/// late to be ordered or to win, so they are dropped and counted.  Within
+/// the window the result is identical to `dedup_last_write_wins`.
+///
+/// A record more than the lead limit (see `kMaxLeadWindows`) past the
+/// newest timestamp is held aside.  If the next record lands within the
+/// limit of it, the jump is real (a gap in the capture) and both enter the
+/// window.  Otherwise the held record was an outlier: it is dropped and
+/// counted in `future_dropped()`, and the window carries on.
+class StreamingDedup {
+public:
+    using Sink = std::function<void(const GpsRecord&)>;
+
+    StreamingDedup(std::int64_t window_ms, Sink sink);
+
+    /// Offer one record (in arrival order).
+    void push(const GpsRecord& rec);
+
+    /// Emit everything still pending (end of input).
+    void flush();
+
+    std::size_t emitted()      const { return emitted_; }
+    std::size_t late_dropped() const { return late_dropped_; }
+    std::size_t future_dropped() const { return future_dropped_; }
+    std::size_t pending()      const { return pending_.size(); }
+
+    /// The far-ahead record held for confirmation, or null if none is.
+    const GpsRecord* held_ahead() const { return has_ahead_ ? &ahead_ : nullptr; }
+
+    /// Snapshot of the window, or replace it with a snapshot taken by a
+    /// dedup with the same window.  Nothing is emitted either way.
+    StreamingDedupState state() const;
+    void                restore(const StreamingDedupState& s);
+
+private:
+    bool far_ahead(std::int64_t a, std::int64_t b) const { return a - b > lead_ms_; }
+    void insert(const GpsRecord& rec);
+    void emit_front();
+
+    std::int64_t          window_ms_;
+    std::int64_t          lead_ms_;
+    Sink                  sink_;
+    std::deque<GpsRecord> pending_;          // sorted by timestamp, unique keys
+    std::int64_t          newest_ms_   = std::numeric_limits<std::int64_t>::min();
+    bool                  has_emitted_ = false;
+    std::int64_t          last_emitted_ms_ = 0;
+    std::size_t           emitted_      = 0;
+    std::size_t           late_dropped_ = 0;
+    bool                  has_ahead_      = false;   // unconfirmed far-ahead record
+    GpsRecord             ahead_{};
+    std::size_t           future_dropped_ = 0;
+};
+
 #endif // DEDUP_H
@@ -0,0 +1,94 @@
+/*
+ * fusion.cpp — Single-pass GGA/GSA → RMC epoch fusion and quality filtering
+ */
+
+#include "fusion.h"
+
+#include <cmath>
+
+// ─── Internal helpers ───────────────────────────────────────────────────────
+
+/// `value <= limit`, treating an unknown (NaN) value as failing unless
+/// the limit is unset.
+static bool within(float value, double limit)
+{
+    if (std::isinf(limit))
+        return true;
+    return !std::isnan(value) && value <= limit;
+}
+
+// ─── QualityFilter ──────────────────────────────────────────────────────────
+
+bool QualityFilter::active() const
+{
+    return min_fix_quality > 0 || min_satellites > 0 ||
+           !std::isinf(max_hdop) || !std::isinf(max_pdop) || !std::isinf(max_vdop);
+}
+
+bool QualityFilter::accepts(const EpochQuality& q) const
+{
+    if (min_fix_quality > 0 && (!q.has_gga || q.fix_quality < min_fix_quality))
+        return false;
+    if (min_satellites > 0 && (!q.has_gga || q.satellites < min_satellites))
+        return false;
+    return within(q.hdop, max_hdop) && within(q.pdop, max_pdop) &&
+           within(q.vdop, max_vdop);
+}
+
+// ─── EpochFuser ─────────────────────────────────────────────────────────────
+
+void EpochFuser::add_gga(const GgaData& gga)
+{
+    // A repeated GGA for the newest epoch refreshes it; a new time opens
+    // the next ring slot, evicting the oldest.
+    if (count_ == 0 || slots_[newest_].timestamp_ms != gga.timestamp_ms) {
+        newest_ = (newest_ + 1) % kFusionEpochSlots;
+        if (count_ < kFusionEpochSlots)
+            ++count_;
+        slots_[newest_] = Slot{};
+        slots_[newest_].timestamp_ms = gga.timestamp_ms;
+    }
+
+    EpochQuality& q = slots_[newest_].quality;
+    q.has_gga     = true;
+    q.fix_quality = gga.fix_quality;
+    q.satellites  = gga.satellites;
+    q.altitude_m  = gga.altitude_m;
+    q.hdop        = gga.hdop;
+}
+
+void EpochFuser::add_gsa(const GsaData& gsa)
+{
+    if (count_ == 0)
+        return;   // no epoch to attach to yet
+
+    EpochQuality& q = slots_[newest_].quality;
+    q.has_gsa  = true;
+    q.fix_type = gsa.fix_type;
+    q.pdop     = gsa.pdop;
+    q.vdop     = gsa.vdop;
+    if (std::isnan(q.hdop))
+        q.hdop = gsa.hdop;
+}
+
+bool EpochFuser::accept_rmc(const GpsRecord& rec)
+{
+    static const EpochQuality kUnfused{};
+
+    // GGA carries only the time of day; the RMC key includes the date.
+    const std::int64_t time_of_day = rec.timestamp_ms % kMsPerDay;
+    const EpochQuality* q = &kUnfused;
+    for (std::size_t i = 0; i < count_; ++i) {
+        const Slot& slot = slots_[(newest_ + kFusionEpochSlots - i) % kFusionEpochSlots];
+        if (slot.timestamp_ms == time_of_day) {
+            q = &slot.quality;
+            ++fused_;
+            break;
+        }
+    }
+
+    if (filter_.accepts(*q))
+        return true;
+    ++rejected_;
+    return false;
+}
@@ -0,0 +1,96 @@
+/*
+ * fusion.h — Single-pass GGA/GSA → RMC epoch fusion and quality filtering
+ *
+ * GGA and GSA sentences are decoded into a handful of recent "epoch"
+ * slots keyed by GGA time.  Each RMC joins the slot with its timestamp —
+ * almost always the newest one, so the join is one integer compare — and
+ * is kept or dropped by the quality filter before it reaches dedup.
+ */
+
+#ifndef FUSION_H
+#define FUSION_H
+
+#include "nmea_parser.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+/// Recent epochs remembered for late RMC re-emissions.
+inline constexpr std::size_t kFusionEpochSlots = 4;
+
+/// Bytes before a parallel chunk that are replayed (GGA/GSA only) to
+/// rebuild the epoch slots a serial pass would have at that point.
+inline constexpr std::size_t kFusionLookbackBytes = 4096;
+
+/// Quality joined to one RMC.  Fields from a sentence that was not seen
+/// for the epoch stay at their "unknown" value (NaN / 0).
+struct EpochQuality {
+    bool         has_gga     = false;
+    bool         has_gsa     = false;
+    std::uint8_t fix_quality = 0;
+    std::uint8_t satellites  = 0;
+    std::uint8_t fix_type    = 0;
+    float        altitude_m  = std::numeric_limits<float>::quiet_NaN();
+    float        hdop        = std::numeric_limits<float>::quiet_NaN();  // GGA, else GSA
+    float        pdop        = std::numeric_limits<float>::quiet_NaN();
+    float        vdop        = std::numeric_limits<float>::quiet_NaN();
+};
+
+/// Thresholds applied to each fused RMC.  A threshold that is set requires
+/// the field to be known: an RMC whose epoch had no GGA fails
+/// --min-fix-quality / --min-sats / --max-hdop, and one without GSA
+/// fails --max-pdop / --max-vdop.
+struct QualityFilter {
+    unsigned min_fix_quality = 0;
+    unsigned min_satellites  = 0;
+    double   max_hdop        = std::numeric_limits<double>::infinity();
+    double   max_pdop        = std::numeric_limits<double>::infinity();
+    double   max_vdop        = std::numeric_limits<double>::infinity();
+
+    /// True if any threshold is set.
+    bool active() const;
+
+    /// True if `q` meets every threshold that is set.
+    bool accepts(const EpochQuality& q) const;
+};
+
+/// --fuse configuration.
+struct FusionOptions {
+    bool          enabled = false;
+    QualityFilter filter;
+};
+
+/// Streaming joiner.  GGA opens (or refreshes) an epoch slot, GSA attaches
+/// to the newest slot, and RMC looks its timestamp up in the slots, newest
+/// first.  GGA/GSA must precede the RMC of their epoch, as in the
+/// fake_ampm captures; an RMC with no matching slot is passed on unfused.
+class EpochFuser {
+public:
+    explicit EpochFuser(const QualityFilter& filter) : filter_(filter) {}
+
+    void add_gga(const GgaData& gga);
+    void add_gsa(const GsaData& gsa);
+
+    /// Join `rec` with its epoch.  Returns true if it passes the filter.
+    bool accept_rmc(const GpsRecord& rec);
+
+    std::size_t fused() const    { return fused_; }      // RMCs joined to an epoch
+    std::size_t rejected() const { return rejected_; }   // RMCs dropped by the filter
+
+private:
+    struct Slot {
+        std::int64_t timestamp_ms = 0;
+        EpochQuality quality;
+    };
+
+    QualityFilter                         filter_;
+    std::array<Slot, kFusionEpochSlots>   slots_{};
+    std::size_t                           count_   = 0;   // slots in use
+    std::size_t                           newest_  = 0;   // ring index
+    std::size_t                           fused_    = 0;
+    std::size_t                           rejected_ = 0;
+};
+
+#endif // FUSION_H
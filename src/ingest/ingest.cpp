@@ -0,0 +1,1016 @@
+/*
+ * ingest.cpp — Line-level validation pipeline and (parallel) file ingest
+ */
+
+#include "ingest.h"
+#include "cache.h"
+#include "codec.h"
+#include "parallel.h"
+#include "reader.h"
+#include "ring.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+// ─── Ingest constants ──────────────────────────────────────────────────────
+
+// Arena record buffers are reserved at one record per this many input
+// bytes — more than any real capture yields — so they almost never grow.
+// The reservation is only address space until records are written.
+static constexpr std::size_t kBytesPerRecordBound = 32;
+
+// A compressed input's record buffer is reserved as if it decoded to
+// this many times its size — well past NMEA's usual 5–10× under gzip or
+// zstd.  Past it the buffer simply grows.
+static constexpr std::size_t kDecodedBytesPerInputByte = 16;
+
+// --pipeline: the reader hands out blocks of this size, and each worker
+// has this many blocks in flight in each direction — enough to keep it
+// busy while the consumer catches up, little enough that the window of
+// prefaulted input stays a few megabytes.
+static constexpr std::size_t kPipelineBlockBytes = 256u << 10;   // 256 KiB
+static constexpr std::size_t kPipelineRingBlocks = 4;
+static constexpr std::size_t kPrefaultStride     = 4096;         // one touch per page
+
+// ─── Internal helpers ───────────────────────────────────────────────────────
+
+namespace {
+
+/// A newline-aligned slice of one mapped file.  Its records are written
+/// into the chunk's own arena, so workers never share an allocator.
+struct Chunk {
+    std::string_view data;
+    std::string_view lookback;   // preceding text, for epoch fusion
+    Arena            arena;
+    Span<GpsRecord>  records;
+    IngestCounters   counters;
+    std::size_t      file = 0;   // index of the buffer it was cut from
+    LineOrigin       origin;     // input index and offset of `data`
+};
+
+/// Up to kFusionLookbackBytes of `file` before `pos`, starting at a line
+/// boundary.
+std::string_view lookback_before(std::string_view file, std::size_t pos)
+{
+    if (pos == 0)
+        return {};
+    std::size_t start = pos > kFusionLookbackBytes ? pos - kFusionLookbackBytes : 0;
+    if (start > 0) {
+        const auto* nl = static_cast<const char*>(
+            std::memchr(file.data() + start, '\n', pos - start));
+        if (!nl)
+            return {};
+        start = static_cast<std::size_t>(nl - file.data()) + 1;
+    }
+    return file.substr(start, pos - start);
+}
+
+/// Length of the part of `text` that ends in a '\n' (all of it when it
+/// does), leaving out a last line that may still be being written.
+std::size_t complete_prefix(std::string_view text)
+{
+    const std::size_t nl = text.rfind('\n');
+    return nl == std::string_view::npos ? 0 : nl + 1;
+}
+
+/// End of the piece of `file` that starts at `pos`: just after the first
+/// '\n' at least `chunk_bytes` in (or end of file).  0 = no limit.
+std::size_t chunk_end(std::string_view file, std::size_t pos, std::size_t chunk_bytes)
+{
+    if (chunk_bytes == 0 || file.size() - pos <= chunk_bytes)
+        return file.size();
+    const char* guess = file.data() + pos + chunk_bytes;
+    const auto* nl = static_cast<const char*>(
+        std::memchr(guess, '\n', file.size() - (pos + chunk_bytes)));
+    return nl ? static_cast<std::size_t>(nl - file.data()) + 1 : file.size();
+}
+
+/// Append `file` (buffer number `index`, input `input`) to `chunks` in
+/// pieces of roughly `chunk_bytes`, each ending just after a '\n' (or at
+/// end of file).
+void split_into_chunks(std::string_view file, std::size_t index, std::size_t input,
+                       std::size_t chunk_bytes, std::vector<Chunk>& chunks)
+{
+    for (std::size_t pos = 0, end; pos < file.size(); pos = end) {
+        end = chunk_end(file, pos, chunk_bytes);
+        chunks.push_back({file.substr(pos, end - pos), lookback_before(file, pos),
+                          Arena(), {}, {}, index, {input, pos}});
+    }
+}
+
+/// check_line, bumping the matching counter; a checksum failure's reason
+/// goes to `why`.  Returns true if the line should go on to
+/// dispatch_sentence.
+bool is_parse_candidate(SentenceHandler handler, ChecksumResult cs_result,
+                        ChecksumPolicy policy, IngestCounters& counters,
+                        RejectReason& why)
+{
+    why = RejectReason::kNone;
+    switch (check_line(handler, cs_result, policy)) {
+    case LineCheck::kParse:
+        return true;
+    case LineCheck::kNotRelevant:
+        ++counters.not_relevant;
+        return false;
+    case LineCheck::kIncomplete:
+        ++counters.parse_fail;
+        why = RejectReason::kIncomplete;
+        return false;
+    case LineCheck::kChecksumMismatch:
+        ++counters.checksum_fail;
+        why = RejectReason::kChecksumMismatch;
+        return false;
+    }
+    return false;
+}
+
+/// Classify `line`: one packed-ID table lookup picks its handler.
+SentenceHandler classify_line(std::string_view line, bool fuse, SentenceId& id,
+                              IngestCounters& counters)
+{
+    id = classify_sentence(line);
+    ++counters.by_type[static_cast<std::size_t>(id.type)];
+    return sentence_handler(id, fuse);
+}
+
+/// Replay the GGA/GSA lines of `text` into `fuser` without counting
+/// anything — rebuilds the epoch slots at a chunk boundary.
+void prime_fuser(std::string_view text, EpochFuser& fuser)
+{
+    LineCursor cursor(text);
+    std::string_view line;
+    GgaData gga{};
+    GsaData gsa{};
+    while (cursor.next(line)) {
+        if (line.empty() || verify_checksum(line) != ChecksumResult::kOk)
+            continue;
+        switch (sentence_handler(classify_sentence(line), true)) {
+        case SentenceHandler::kGga:
+            if (parse_gga(line, gga))
+                fuser.add_gga(gga);
+            break;
+        case SentenceHandler::kGsa:
+            if (parse_gsa(line, gsa))
+                fuser.add_gsa(gsa);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/// Validate every line in `buf`, handing records to `emit` in order.
+/// Lines are gathered into small batches and each stage runs over the
+/// whole batch before the next starts: the checksum kernel runs
+/// back-to-back over many sentences, and each stage is timed once per
+/// batch instead of once per line.  `emit` runs outside every timer.
+/// Lines are classified from their prefix before the checksum pass, so
+/// under ChecksumPolicy::kRelevant only the lines that will be parsed
+/// reach the checksum kernel.  With fusion enabled, GGA/GSA are decoded
+/// in the parse stage and the join + quality filter run in order just
+/// before `emit`.  Rejected lines are recorded with their position:
+/// `origin` is where `buf` starts in its input.
+template <typename Emit>
+void ingest_lines(std::string_view buf, const IngestOptions& opts,
+                  std::string_view lookback, LineOrigin origin,
+                  IngestCounters& counters, Emit&& emit)
+{
+    std::array<std::string_view, kDefaultChecksumBatch> lines;
+    std::array<ChecksumResult, kDefaultChecksumBatch>   verdicts;
+    std::array<bool, kDefaultChecksumBatch>             candidate;
+    std::array<SentenceId, kDefaultChecksumBatch>       ids;
+    std::array<SentenceHandler, kDefaultChecksumBatch>  handlers;
+    std::array<std::string_view, kDefaultChecksumBatch> checked;    // kRelevant: lines to verify
+    std::array<std::size_t, kDefaultChecksumBatch>      checked_at;
+    std::array<ChecksumResult, kDefaultChecksumBatch>   checked_verdicts;
+    std::array<SentenceHandler, kDefaultChecksumBatch>  produced;   // per line, fusion only
+    std::array<GpsRecord, kDefaultChecksumBatch>        parsed;
+    std::array<GgaData, kDefaultChecksumBatch>          gga;
+    std::array<GsaData, kDefaultChecksumBatch>          gsa;
+    StageTimes& t = counters.timing;
+    RejectReason why;
+    const FusionOptions& fusion     = opts.fusion;
+    const bool           fuse       = fusion.enabled;
+    const bool           fast       = opts.checksum == ChecksumPolicy::kRelevant;
+    const bool           tag_talker = opts.track_by == TrackBy::kTalker;
+
+    const auto reject = [&](std::size_t i) {
+        const auto at = static_cast<std::uint64_t>(lines[i].data() - buf.data());
+        counters.rejects.add(why, ids[i].type, lines[i], {origin.file, origin.offset + at});
+    };
+
+    EpochFuser fuser(fusion.filter);
+    if (fuse && !lookback.empty())
+        prime_fuser(lookback, fuser);
+
+    t[Stage::kRead].bytes += buf.size();
+
+    LineCursor cursor(buf);
+    bool more = true;
+    while (more) {
+        std::size_t n = 0;
+        std::size_t line_bytes = 0;
+        {
+            StageTimer timer(t[Stage::kRead]);
+            std::string_view line;
+            while (n < kDefaultChecksumBatch && (more = cursor.next(line))) {
+                if (!line.empty()) {
+                    lines[n++] = line;
+                    line_bytes += line.size();
+                }
+            }
+        }
+        counters.lines_total += n;
+
+        {
+            StageTimer timer(t[Stage::kClassify]);
+            for (std::size_t i = 0; i < n; ++i)
+                handlers[i] = classify_line(lines[i], fuse, ids[i], counters);
+        }
+
+        std::size_t verified = n;
+        std::size_t verified_bytes = line_bytes;
+        {
+            StageTimer timer(t[Stage::kChecksum]);
+            if (!fast) {
+                verify_checksum_batch(lines.data(), n, verdicts.data());
+            } else {
+                verified = verified_bytes = 0;
+                for (std::size_t i = 0; i < n; ++i) {
+                    verdicts[i] = ChecksumResult::kOk;   // not read for a discarded type
+                    if (handlers[i] != SentenceHandler::kNotRelevant) {
+                        checked[verified]      = lines[i];
+                        checked_at[verified++] = i;
+                        verified_bytes += lines[i].size();
+                    }
+                }
+                verify_checksum_batch(checked.data(), verified, checked_verdicts.data());
+                for (std::size_t k = 0; k < verified; ++k)
+                    verdicts[checked_at[k]] = checked_verdicts[k];
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                candidate[i] = is_parse_candidate(handlers[i], verdicts[i], opts.checksum,
+                                                  counters, why);
+                if (why != RejectReason::kNone)
+                    reject(i);
+            }
+        }
+
+        std::size_t m = 0;
+        std::size_t parse_items = 0;
+        std::size_t parse_bytes = 0;
+        {
+            StageTimer timer(t[Stage::kParse]);
+            for (std::size_t i = 0; i < n; ++i) {
+                produced[i] = SentenceHandler::kUnsupported;
+                if (!candidate[i])
+                    continue;
+                ++parse_items;
+                parse_bytes += lines[i].size();
+
+                bool ok;
+                switch (handlers[i]) {
+                case SentenceHandler::kGga: ok = parse_gga(lines[i], gga[i], why); break;
+                case SentenceHandler::kGsa: ok = parse_gsa(lines[i], gsa[i], why); break;
+                default:
+                    ok = dispatch_sentence(lines[i], handlers[i], parsed[fuse ? i : m], why);
+                    if (ok && tag_talker)
+                        parsed[fuse ? i : m].track = static_cast<std::uint32_t>(ids[i].talker);
+                    break;
+                }
+                if (!ok) {
+                    ++counters.parse_fail;
+                    reject(i);
+                    continue;
+                }
+                produced[i] = handlers[i];
+                ++m;
+            }
+        }
+
+        if constexpr (kStatsEnabled) {
+            t[Stage::kRead].items     += n;
+            t[Stage::kChecksum].items += verified;
+            t[Stage::kChecksum].bytes += verified_bytes;
+            t[Stage::kClassify].items += n;
+            t[Stage::kClassify].bytes += line_bytes;
+            t[Stage::kParse].items    += parse_items;
+            t[Stage::kParse].bytes    += parse_bytes;
+        }
+
+        if (!fuse) {
+            for (std::size_t i = 0; i < m; ++i)
+                emit(parsed[i]);
+            continue;
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            switch (produced[i]) {
+            case SentenceHandler::kGga:
+                fuser.add_gga(gga[i]);
+                ++counters.epoch_lines;
+                break;
+            case SentenceHandler::kGsa:
+                fuser.add_gsa(gsa[i]);
+                ++counters.epoch_lines;
+                break;
+            case SentenceHandler::kRmc:
+                if (fuser.accept_rmc(parsed[i]))
+                    emit(parsed[i]);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    counters.fused            += fuser.fused();
+    counters.quality_rejected += fuser.rejected();
+}
+
+/// Map `path` into `file`.  Warns about (and fails on) an input that
+/// can't be mapped or is compressed in a format this build can't decode.
+bool open_input(const std::string& path, InputFile& file)
+{
+    if (!file.open(path)) {
+        std::cerr << "Warning: cannot open '" << path << "', skipping.\n";
+        return false;
+    }
+    const Compression format = detect_compression(file.data());
+    if (!compression_available(format)) {
+        std::cerr << "Warning: '" << path << "' is " << compression_name(format)
+                  << "-compressed, which this build cannot decode; skipping.\n";
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+bool is_compressed(const InputFile& file)
+{
+    return detect_compression(file.data()) != Compression::kNone;
+}
+
+/// Open every path in argument order, warning about (and skipping) the
+/// ones that can't be mapped or decoded.  The index in `paths` of each
+/// file that did open is appended to `opened`.
+std::vector<InputFile> open_inputs(const std::vector<std::string>& paths,
+                                   IngestCounters& counters,
+                                   std::vector<std::size_t>& opened)
+{
+    std::vector<InputFile> files;
+    files.reserve(paths.size());
+    StageTimer timer(counters.timing[Stage::kRead]);
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        InputFile file;
+        if (!open_input(paths[i], file))
+            continue;
+        files.push_back(std::move(file));
+        opened.push_back(i);
+    }
+    return files;
+}
+
+/// Run the compressed input `data` (input `input`, at `path`) through
+/// ingest_lines block by block while a DecodeStream decodes ahead on its
+/// own thread.  Line offsets are positions in the decoded text, and the
+/// decoding time goes to Stage::kRead.  A corrupt or truncated stream is
+/// reported; the records before the damage are kept.  Text before
+/// decoded offset `begin` is decoded but not parsed; with
+/// `complete_lines` an unterminated last line is left unparsed too.
+/// Returns the decoded offset parsing stopped at.
+template <typename Emit>
+std::uint64_t ingest_compressed(std::string_view data, const std::string& path,
+                                const IngestOptions& opts, std::size_t input,
+                                IngestCounters& counters, Emit&& emit,
+                                std::uint64_t begin = 0, bool complete_lines = false)
+{
+    DecodeStream  stream(data, detect_compression(data));
+    DecodedBlock  block;
+    std::uint64_t end = begin;
+    while (stream.next(block)) {
+        std::string_view text   = block.text();
+        std::uint64_t    offset = block.offset;
+        if (offset + text.size() <= begin)
+            continue;
+        std::string_view lookback = block.lookback_text();
+        if (offset < begin) {
+            // Resuming inside this block: the lookback comes from the
+            // text before the resume point, which the buffer still holds.
+            const auto skip = static_cast<std::size_t>(begin - offset);
+            const std::string_view all(block.buffer.data(), block.buffer.size());
+            lookback = lookback_before(all, block.lookback + skip);
+            text     = text.substr(skip);
+            offset   = begin;
+        }
+        if (complete_lines)
+            text = text.substr(0, complete_prefix(text));
+        ingest_lines(text, opts, lookback, {input, offset}, counters, emit);
+        end = offset + text.size();
+    }
+    counters.timing[Stage::kRead].ns += stream.timing().ns;
+    if (!stream.error().empty())
+        std::cerr << "Warning: '" << path << "': " << stream.error()
+                  << "; keeping the records before it.\n";
+    return end;
+}
+
+/// Track of the input at `index` in the path list under TrackBy::kFile.
+std::uint32_t file_track(const IngestOptions& opts, std::size_t index)
+{
+    return index < opts.file_tracks.size() ? opts.file_tracks[index]
+                                           : static_cast<std::uint32_t>(index);
+}
+
+/// Tag `records` with the track of input `index`, if tracks are per file.
+void tag_file_track(Span<GpsRecord> records, const IngestOptions& opts, std::size_t index)
+{
+    if (opts.track_by != TrackBy::kFile)
+        return;
+    const std::uint32_t track = file_track(opts, index);
+    for (GpsRecord& rec : records)
+        rec.track = track;
+}
+
+std::vector<std::string_view> buffers_of(const std::vector<InputFile>& files)
+{
+    std::vector<std::string_view> buffers;
+    buffers.reserve(files.size());
+    for (const auto& file : files)
+        buffers.push_back(file.data());
+    return buffers;
+}
+
+/// Parse `buf` into a fresh record buffer in `arena`.
+Span<GpsRecord> ingest_into_arena(std::string_view buf, const IngestOptions& opts,
+                                  std::string_view lookback, LineOrigin origin,
+                                  Arena& arena, IngestCounters& counters)
+{
+    ArenaVector<GpsRecord> records(arena);
+    records.reserve(buf.size() / kBytesPerRecordBound + 1);
+    ingest_lines(buf, opts, lookback, origin, counters,
+                 [&](const GpsRecord& rec) { records.push_back(rec); });
+    return {records.data(), records.size()};   // storage outlives the vector
+}
+
+/// Decode and parse the compressed input `data` into a fresh record
+/// buffer in `arena`.
+Span<GpsRecord> ingest_compressed_into_arena(std::string_view data, const std::string& path,
+                                             const IngestOptions& opts, std::size_t input,
+                                             Arena& arena, IngestCounters& counters)
+{
+    ArenaVector<GpsRecord> records(arena);
+    records.reserve(data.size() * kDecodedBytesPerInputByte / kBytesPerRecordBound + 1);
+    ingest_compressed(data, path, opts, input, counters,
+                      [&](const GpsRecord& rec) { records.push_back(rec); });
+    return {records.data(), records.size()};
+}
+
+/// Split `buffers` into chunks and parse them on `jobs` threads.  Each
+/// buffer's chunks are consecutive, in order.  `inputs[i]` is the index
+/// in the path list of buffer i.
+std::vector<Chunk> ingest_chunks(const std::vector<std::string_view>& buffers,
+                                 const std::vector<std::size_t>& inputs,
+                                 const IngestOptions& opts, unsigned jobs)
+{
+    std::vector<Chunk> chunks;
+    for (std::size_t i = 0; i < buffers.size(); ++i)
+        split_into_chunks(buffers[i], i, inputs[i], opts.chunk_bytes, chunks);
+
+    parallel_for(chunks.size(), jobs, [&](std::size_t i) {
+        Chunk& c = chunks[i];
+        c.records = ingest_into_arena(c.data, opts, c.lookback, c.origin, c.arena, c.counters);
+    });
+    return chunks;
+}
+
+/// Unit of work in a --pipeline run: one newline-aligned block of input
+/// on its way to a worker, then the same block's records on their way to
+/// the sink.  Blocks loaded from the parse cache arrive already parsed;
+/// blocks of a compressed input carry their decoded text.
+struct PipelineBlock {
+    std::string_view       data;
+    std::string_view       lookback;   // preceding text, for epoch fusion
+    std::size_t            file   = 0;       // index in the path list
+    std::size_t            offset = 0;       // where `data` starts in the file
+    bool                   parsed = false;   // `records` came from the cache
+    std::vector<GpsRecord> records;
+    DecodedBlock           decoded;          // owns `data` for a compressed input
+};
+
+/// One parse worker's rings and counters.  `spare` carries drained
+/// blocks back from the consumer so their record buffers are reused.
+struct PipelineWorker {
+    SpscRing<PipelineBlock> in{kPipelineRingBlocks};
+    SpscRing<PipelineBlock> out{kPipelineRingBlocks};
+    SpscRing<PipelineBlock> spare{kPipelineRingBlocks};
+    IngestCounters          counters;
+    std::thread             thread;
+};
+
+/// Touch every page of `data`, so a worker parsing it later finds the
+/// mapping already faulted in.
+void prefault(std::string_view data)
+{
+    unsigned char acc = 0;
+    for (std::size_t i = 0; i < data.size(); i += kPrefaultStride)
+        acc ^= static_cast<unsigned char>(data[i]);
+    static std::atomic<unsigned char> sink;   // keeps the loads alive
+    sink.store(acc, std::memory_order_relaxed);
+}
+
+/// ingest_files one input at a time, for runs with a parse cache or a
+/// compressed input: key every input, load the cache hits, parse the
+/// misses — plain ones chunked across all of them, as without the cache,
+/// compressed ones decoded block by block, up to `jobs` inputs at once —
+/// store them, then concatenate in argument order.  `opened[i]` is the
+/// index in `paths` of `files[i]`.
+Span<GpsRecord> ingest_by_input(const std::vector<std::string>& paths,
+                                const std::vector<InputFile>& files,
+                                const std::vector<std::size_t>& opened,
+                                const IngestOptions& opts,
+                                Arena& arena,
+                                IngestCounters& counters)
+{
+    const bool       use_cache = !opts.cache_dir.empty();
+    const ParseCache cache(opts);
+
+    struct Input {
+        CacheKey        key;
+        Span<GpsRecord> records;
+        IngestCounters  counters;
+        Arena           arena;   // a compressed input decoded alongside others
+    };
+    std::vector<Input>            inputs(files.size());
+    std::vector<std::string_view> miss_data;
+    std::vector<std::size_t>      miss_index;
+    std::vector<std::size_t>      miss_input;   // index in `paths`
+    std::vector<std::size_t>      packed_index; // compressed misses
+    {
+        StageTimer timer(counters.timing[Stage::kRead]);
+        for (std::size_t i = 0; i < files.size(); ++i) {
+            Input& in = inputs[i];
+            if (use_cache) {
+                in.key = cache.key(paths[opened[i]], files[i].data());
+                if (cache.load(in.key, arena, in.records, in.counters)) {
+                    counters.timing[Stage::kRead].bytes += files[i].size();
+                    ++counters.cache_hits;
+                    continue;
+                }
+            }
+            if (is_compressed(files[i])) {
+                packed_index.push_back(i);
+                continue;
+            }
+            miss_data.push_back(files[i].data());
+            miss_index.push_back(i);
+            miss_input.push_back(opened[i]);
+        }
+    }
+    if (use_cache)
+        counters.cache_misses += miss_index.size() + packed_index.size();
+
+    const unsigned jobs = resolve_jobs(opts.jobs);
+    if (jobs <= 1) {
+        for (std::size_t m = 0; m < miss_index.size(); ++m) {
+            Input& in = inputs[miss_index[m]];
+            in.records = ingest_into_arena(miss_data[m], opts, {}, {miss_input[m], 0}, arena,
+                                           in.counters);
+        }
+    } else {
+        // Chunks arrive grouped by buffer; gather each miss's into one array.
+        std::vector<Chunk> chunks = ingest_chunks(miss_data, miss_input, opts, jobs);
+        std::size_t c = 0;
+        for (std::size_t m = 0; m < miss_index.size(); ++m) {
+            std::size_t end = c, total = 0;
+            for (; end < chunks.size() && chunks[end].file == m; ++end)
+                total += chunks[end].records.size();
+            Input& in = inputs[miss_index[m]];
+            GpsRecord* out = arena.allocate_array<GpsRecord>(total);
+            in.records = {out, total};
+            for (; c < end; ++c) {
+                out = std::copy(chunks[c].records.begin(), chunks[c].records.end(), out);
+                in.counters += chunks[c].counters;
+                chunks[c].arena = Arena();   // release as we go
+            }
+        }
+    }
+
+    // A compressed input is a serial stream, so the parallelism is across
+    // inputs; each one's decoder adds a thread of its own.  A lone task
+    // can use the shared arena.
+    const bool shared = jobs <= 1 || packed_index.size() == 1;
+    parallel_for(packed_index.size(), jobs, [&](std::size_t k) {
+        const std::size_t i  = packed_index[k];
+        Input&            in = inputs[i];
+        in.records = ingest_compressed_into_arena(files[i].data(), paths[opened[i]], opts,
+                                                  opened[i], shared ? arena : in.arena,
+                                                  in.counters);
+    });
+
+    if (use_cache) {
+        for (std::size_t i : miss_index)
+            cache.store(inputs[i].key, inputs[i].records, inputs[i].counters);
+        for (std::size_t i : packed_index)
+            cache.store(inputs[i].key, inputs[i].records, inputs[i].counters);
+    }
+    for (std::size_t i = 0; i < inputs.size(); ++i)
+        tag_file_track(inputs[i].records, opts, opened[i]);   // tracks are not cached
+
+    if (inputs.size() == 1) {
+        counters += inputs[0].counters;
+        return inputs[0].records;
+    }
+    std::size_t total = 0;
+    for (const Input& in : inputs)
+        total += in.records.size();
+    GpsRecord*  out = arena.allocate_array<GpsRecord>(total);
+    std::size_t n   = 0;
+    for (const Input& in : inputs) {
+        std::copy(in.records.begin(), in.records.end(), out + n);
+        n += in.records.size();
+        counters += in.counters;
+    }
+    return {out, n};
+}
+
+} // namespace
+
+// ─── Public API ─────────────────────────────────────────────────────────────
+
+LineCheck check_line(SentenceHandler handler, ChecksumResult cs_result, ChecksumPolicy policy)
+{
+    if (policy == ChecksumPolicy::kRelevant && handler == SentenceHandler::kNotRelevant)
+        return LineCheck::kNotRelevant;
+
+    // Pass 1 — checksum.
+    if (cs_result == ChecksumResult::kIncomplete)
+        return LineCheck::kIncomplete;
+    if (cs_result == ChecksumResult::kMismatch)
+        return LineCheck::kChecksumMismatch;
+
+    // Known but unsupported types are skipped; unrecognised ones fall
+    // through to a parse failure.
+    return handler == SentenceHandler::kNotRelevant ? LineCheck::kNotRelevant : LineCheck::kParse;
+}
+
+IngestCounters& IngestCounters::operator+=(const IngestCounters& other)
+{
+    lines_total   += other.lines_total;
+    checksum_fail += other.checksum_fail;
+    not_relevant  += other.not_relevant;
+    parse_fail    += other.parse_fail;
+    epoch_lines      += other.epoch_lines;
+    fused            += other.fused;
+    quality_rejected += other.quality_rejected;
+    cache_hits       += other.cache_hits;
+    cache_misses     += other.cache_misses;
+    for (std::size_t i = 0; i < by_type.size(); ++i)
+        by_type[i] += other.by_type[i];
+    rejects       += other.rejects;
+    timing        += other.timing;
+    return *this;
+}
+
+bool ingest_line(std::string_view line, GpsRecord& rec, IngestCounters& counters,
+                 ChecksumPolicy checksum, LineOrigin at)
+{
+    if (line.empty())
+        return false;
+
+    ++counters.lines_total;
+    SentenceId id;
+    const SentenceHandler handler = classify_line(line, false, id, counters);
+    const ChecksumResult  verdict =
+        checksum == ChecksumPolicy::kRelevant && handler == SentenceHandler::kNotRelevant
+            ? ChecksumResult::kOk   // not verified; rejected as not relevant
+            : verify_checksum(line);
+    RejectReason why;
+    if (!is_parse_candidate(handler, verdict, checksum, counters, why)) {
+        if (why != RejectReason::kNone)
+            counters.rejects.add(why, id.type, line, at);
+        return false;
+    }
+
+    // Pass 2 — field validation & extraction.
+    if (!dispatch_sentence(line, handler, rec, why)) {
+        ++counters.parse_fail;
+        counters.rejects.add(why, id.type, line, at);
+        return false;
+    }
+    return true;
+}
+
+void ingest_buffer(std::string_view buf, std::vector<GpsRecord>& out,
+                   IngestCounters& counters)
+{
+    ingest_buffer(buf, FusionOptions{}, {}, out, counters);
+}
+
+void ingest_buffer(std::string_view buf, const FusionOptions& fusion,
+                   std::string_view lookback, std::vector<GpsRecord>& out,
+                   IngestCounters& counters)
+{
+    IngestOptions opts;
+    opts.fusion = fusion;
+    ingest_buffer(buf, opts, lookback, out, counters);
+}
+
+void ingest_buffer(std::string_view buf, const IngestOptions& opts,
+                   std::string_view lookback, std::vector<GpsRecord>& out,
+                   IngestCounters& counters)
+{
+    ingest_lines(buf, opts, lookback, {}, counters,
+                 [&](const GpsRecord& rec) { out.push_back(rec); });
+}
+
+void ingest_files(const std::vector<std::string>& paths,
+                  const IngestOptions& opts,
+                  std::vector<GpsRecord>& out,
+                  IngestCounters& counters)
+{
+    // Map everything up front (in argument order, so warnings come out in
+    // the same order as the serial path), then carve the mappings into
+    // newline-aligned chunks.  Chunks are parsed independently into their
+    // own buffers and concatenated in order, which keeps last-write-wins
+    // semantics identical to a single sequential pass.
+    std::vector<std::size_t> opened;
+    const std::vector<InputFile> files = open_inputs(paths, counters, opened);
+    if (!opts.cache_dir.empty() ||
+        std::any_of(files.begin(), files.end(), is_compressed)) {
+        Arena arena;
+        const Span<GpsRecord> records = ingest_by_input(paths, files, opened, opts, arena,
+                                                        counters);
+        out.insert(out.end(), records.begin(), records.end());
+        return;
+    }
+
+    const unsigned jobs = resolve_jobs(opts.jobs);
+    if (jobs <= 1) {
+        for (std::size_t i = 0; i < files.size(); ++i) {
+            const std::size_t first = out.size();
+            ingest_lines(files[i].data(), opts, {}, {opened[i], 0}, counters,
+                         [&](const GpsRecord& rec) { out.push_back(rec); });
+            tag_file_track({out.data() + first, out.size() - first}, opts, opened[i]);
+        }
+        return;
+    }
+
+    std::vector<Chunk> chunks = ingest_chunks(buffers_of(files), opened, opts, jobs);
+    std::size_t total = out.size();
+    for (const auto& c : chunks)
+        total += c.records.size();
+    out.reserve(total);
+    for (auto& c : chunks) {
+        tag_file_track(c.records, opts, opened[c.file]);
+        out.insert(out.end(), c.records.begin(), c.records.end());
+        counters += c.counters;
+        c.arena = Arena();   // release as we go
+    }
+}
+
+Span<GpsRecord> ingest_files(const std::vector<std::string>& paths,
+                             const IngestOptions& opts,
+                             Arena& arena,
+                             IngestCounters& counters)
+{
+    std::vector<std::size_t> opened;
+    const std::vector<InputFile> files = open_inputs(paths, counters, opened);
+    if (!opts.cache_dir.empty() ||
+        std::any_of(files.begin(), files.end(), is_compressed))
+        return ingest_by_input(paths, files, opened, opts, arena, counters);
+
+    const unsigned jobs = resolve_jobs(opts.jobs);
+    if (jobs <= 1) {
+        std::size_t bytes = 0;
+        for (const auto& file : files)
+            bytes += file.size();
+        ArenaVector<GpsRecord> records(arena);
+        records.reserve(bytes / kBytesPerRecordBound + 1);
+        for (std::size_t i = 0; i < files.size(); ++i) {
+            const std::size_t first = records.size();
+            ingest_lines(files[i].data(), opts, {}, {opened[i], 0}, counters,
+                         [&](const GpsRecord& rec) { records.push_back(rec); });
+            tag_file_track({records.data() + first, records.size() - first}, opts, opened[i]);
+        }
+        return {records.data(), records.size()};
+    }
+
+    std::vector<Chunk> chunks = ingest_chunks(buffers_of(files), opened, opts, jobs);
+    std::size_t total = 0;
+    for (const auto& c : chunks)
+        total += c.records.size();
+    GpsRecord*  out = arena.allocate_array<GpsRecord>(total);
+    std::size_t n   = 0;
+    for (auto& c : chunks) {
+        tag_file_track(c.records, opts, opened[c.file]);
+        std::copy(c.records.begin(), c.records.end(), out + n);
+        n += c.records.size();
+        counters += c.counters;
+        c.arena = Arena();   // release as we go
+    }
+    return {out, n};
+}
+
+void stream_files(const std::vector<std::string>& paths,
+                  const IngestOptions& opts,
+                  const RecordSink& sink,
+                  IngestCounters& counters,
+                  std::vector<std::uint64_t>* offsets)
+{
+    if (offsets)
+        offsets->resize(paths.size(), 0);
+    const ParseCache cache(opts);
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        const std::string& path = paths[i];
+        InputFile file;
+        bool opened;
+        {
+            StageTimer timer(counters.timing[Stage::kRead]);
+            opened = open_input(path, file);
+        }
+        if (!opened)
+            continue;
+        // Per-file tracks are stamped on the way to the sink.
+        const bool          by_file = opts.track_by == TrackBy::kFile;
+        const std::uint32_t track   = file_track(opts, i);
+        const RecordSink    tagged  = [&](const GpsRecord& rec) {
+            GpsRecord r = rec;
+            r.track = track;
+            sink(r);
+        };
+        const RecordSink& emit = by_file ? tagged : sink;
+        if (!opts.cache_dir.empty()) {
+            // Only keying is timed: a hit's replay runs the sink, whose
+            // time belongs to the caller's stages.
+            CacheKey key;
+            {
+                StageTimer timer(counters.timing[Stage::kRead]);
+                key = cache.key(path, file.data());
+            }
+            if (cache.load(key, emit, counters)) {
+                counters.timing[Stage::kRead].bytes += file.size();
+                ++counters.cache_hits;
+                continue;
+            }
+            ++counters.cache_misses;
+        }
+        if (offsets) {
+            // Resuming: only the complete lines past the offset are read.
+            std::uint64_t& at = (*offsets)[i];
+            if (is_compressed(file)) {
+                at = ingest_compressed(file.data(), path, opts, i, counters, emit, at, true);
+                continue;
+            }
+            const std::string_view data = file.data();
+            const auto begin = static_cast<std::size_t>(std::min<std::uint64_t>(at, data.size()));
+            const std::string_view text = data.substr(begin, complete_prefix(data.substr(begin)));
+            ingest_lines(text, opts, lookback_before(data, begin), {i, begin}, counters, emit);
+            at = begin + text.size();
+        } else if (is_compressed(file)) {
+            ingest_compressed(file.data(), path, opts, i, counters, emit);
+        } else {
+            ingest_lines(file.data(), opts, {}, {i, 0}, counters, emit);
+        }
+    }
+}
+
+void pipeline_files(const std::vector<std::string>& paths,
+                    const IngestOptions& opts,
+                    const RecordSink& sink,
+                    IngestCounters& counters)
+{
+    const unsigned jobs = resolve_jobs(opts.jobs);
+    std::vector<std::unique_ptr<PipelineWorker>> workers;
+    for (unsigned w = 0; w < jobs; ++w)
+        workers.push_back(std::make_unique<PipelineWorker>());
+
+    // ── Reader: open each input in turn, cut it into blocks, fault the
+    //    pages in and deal the blocks out to the workers round-robin.
+    //    The files are opened in place and never move while workers
+    //    hold views into them.
+    std::vector<InputFile> files(paths.size());
+    IngestCounters read_counters;
+    std::thread reader([&] {
+        const ParseCache cache(opts);
+        StageSample& read = read_counters.timing[Stage::kRead];
+        std::size_t  next = 0;
+        const auto send = [&](PipelineBlock&& block) {
+            workers[next++ % jobs]->in.push(std::move(block));
+        };
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            bool opened;
+            {
+                StageTimer timer(read);
+                opened = open_input(paths[i], files[i]);
+            }
+            if (!opened)
+                continue;
+            const std::string_view data = files[i].data();
+            if (!opts.cache_dir.empty()) {
+                PipelineBlock hit;
+                hit.file   = i;
+                hit.parsed = true;
+                bool loaded;
+                {
+                    StageTimer timer(read);
+                    loaded = cache.load(cache.key(paths[i], data),
+                                        [&](const GpsRecord& rec) { hit.records.push_back(rec); },
+                                        read_counters);
+                }
+                if (loaded) {
+                    read.bytes += data.size();
+                    ++read_counters.cache_hits;
+                    send(std::move(hit));
+                    continue;
+                }
+                ++read_counters.cache_misses;
+            }
+            if (is_compressed(files[i])) {
+                // The reader decodes: blocks own their text, which stays
+                // put when the block moves between rings.
+                BlockDecoder decoder(data, detect_compression(data), kPipelineBlockBytes);
+                for (;;) {
+                    PipelineBlock block;
+                    bool more;
+                    {
+                        StageTimer timer(read);
+                        more = decoder.next(block.decoded);
+                    }
+                    if (!more)
+                        break;
+                    block.data     = block.decoded.text();
+                    block.lookback = block.decoded.lookback_text();
+                    block.file     = i;
+                    block.offset   = block.decoded.offset;
+                    send(std::move(block));
+                }
+                if (!decoder.error().empty())
+                    std::cerr << "Warning: '" << paths[i] << "': " << decoder.error()
+                              << "; keeping the records before it.\n";
+                continue;
+            }
+            for (std::size_t pos = 0, end; pos < data.size(); pos = end) {
+                end = chunk_end(data, pos, kPipelineBlockBytes);
+                PipelineBlock block;
+                block.data     = data.substr(pos, end - pos);
+                block.lookback = lookback_before(data, pos);
+                block.file     = i;
+                block.offset   = pos;
+                {
+                    StageTimer timer(read);
+                    prefault(block.data);
+                }
+                send(std::move(block));
+            }
+        }
+        for (auto& w : workers)
+            w->in.close();
+    });
+
+    // ── Workers: parse blocks in the order they were dealt.
+    for (auto& wp : workers) {
+        PipelineWorker& w = *wp;
+        w.thread = std::thread([&opts, &w] {
+            PipelineBlock block;
+            while (w.in.pop(block)) {
+                if (!block.parsed) {
+                    PipelineBlock recycled;
+                    if (w.spare.try_pop(&recycled, 1)) {
+                        block.records = std::move(recycled.records);
+                        block.records.clear();
+                    }
+                    const LineOrigin origin{block.file, block.offset};
+                    ingest_lines(block.data, opts, block.lookback, origin, w.counters,
+                                 [&](const GpsRecord& rec) { block.records.push_back(rec); });
+                }
+                tag_file_track({block.records.data(), block.records.size()}, opts, block.file);
+                w.out.push(std::move(block));
+            }
+            w.out.close();
+        });
+    }
+
+    // ── Consumer: collect blocks in dealing order, so the sink sees the
+    //    records exactly as stream_files would hand them over.
+    PipelineBlock block;
+    for (std::size_t k = 0; workers[k % jobs]->out.pop(block); ++k) {
+        {
+            StageTimer timer(counters.timing[Stage::kTemporalDedup]);
+            for (const GpsRecord& rec : block.records)
+                sink(rec);
+        }
+        workers[k % jobs]->spare.try_push(&block, 1);
+    }
+
+    reader.join();
+    counters += read_counters;
+    for (auto& w : workers) {
+        w->thread.join();
+        counters += w->counters;
+    }
+}
@@ -0,0 +1,172 @@
+/*
+ * ingest.h — Line-level validation pipeline and (parallel) file ingest
+ */
+
+#ifndef INGEST_H
+#define INGEST_H
+
+#include "arena.h"
+#include "fusion.h"
+#include "nmea_parser.h"
+#include "reject.h"
+#include "sentence.h"
+#include "stats.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Files larger than this are split at newline boundaries into chunks
+/// that are parsed independently.
+inline constexpr std::size_t kDefaultChunkBytes = 4u << 20;   // 4 MiB
+
+/// Line outcome counters.  Kept per thread / per chunk and summed at the
+/// end, so workers never share a cache line.
+struct IngestCounters {
+    std::size_t lines_total   = 0;
+    std::size_t checksum_fail = 0;
+    std::size_t not_relevant  = 0;
+    std::size_t parse_fail    = 0;
+    std::size_t epoch_lines      = 0;   // --fuse: GGA/GSA decoded into epochs
+    std::size_t fused            = 0;   // --fuse: RMCs joined to an epoch
+    std::size_t quality_rejected = 0;   // --fuse: RMCs dropped by the filter
+    std::size_t cache_hits       = 0;   // --cache-dir: inputs loaded from the cache
+    std::size_t cache_misses     = 0;   // --cache-dir: inputs parsed (and stored)
+    std::array<std::size_t, kSentenceTypeCount> by_type{};   // lines per SentenceType
+    RejectStats rejects;         // checksum and parse failures by reason and type
+    StageTimes  timing;          // read / checksum / classify / parse cost
+
+    IngestCounters& operator+=(const IngestCounters& other);
+};
+
+/// Which lines have their checksum verified.
+enum class ChecksumPolicy : std::uint8_t {
+    kAll,        // every line, before it is classified (audit; the default)
+    kRelevant,   // --fast-reject: classify first and skip the checksum of
+                 // lines that are discarded anyway, which then count as not
+                 // relevant whatever their checksum
+};
+
+/// Lines gathered for one verify_checksum_batch pass.
+inline constexpr std::size_t kDefaultChecksumBatch = 64;
+
+/// Pass-1 outcome of a classified line (check_line).
+enum class LineCheck : std::uint8_t {
+    kParse,              // goes on to dispatch_sentence
+    kNotRelevant,        // a type that is discarded
+    kIncomplete,         // malformed frame: a parse failure
+    kChecksumMismatch,   // a checksum failure
+};
+
+/// How records are assigned to tracks (GpsRecord::track).
+enum class TrackBy : std::uint8_t {
+    kNone,     // a single route: every record is track 0
+    kFile,     // one track per input (IngestOptions::file_tracks)
+    kTalker,   // one track per talker ID: the Talker enumerator's value
+};
+
+/// Ingest configuration.
+struct IngestOptions {
+    unsigned    jobs        = 1;                   // worker threads (0 = all cores)
+    std::size_t chunk_bytes = kDefaultChunkBytes;  // intra-file split size
+    FusionOptions fusion;                          // --fuse and quality filters
+    ChecksumPolicy checksum = ChecksumPolicy::kAll;  // --fast-reject / --checksum-all
+    std::string cache_dir;                         // --cache-dir (empty = no cache)
+    TrackBy     track_by = TrackBy::kNone;         // --track-by
+    std::vector<std::uint32_t> file_tracks;        // kFile: track of each path (default: its index)
+};
+
+/// Judge a line classified to `handler` with checksum verdict `cs_result`
+/// under `policy`.  Under kAll the checksum is judged first, so a corrupt
+/// line of any type is a checksum or parse failure; under kRelevant a
+/// discarded type is rejected before its (unverified) checksum is looked
+/// at.  kUnsupported lines fall through to dispatch_sentence, which fails
+/// them.  Every ingest path and Pipeline decide through this.
+LineCheck check_line(SentenceHandler handler, ChecksumResult cs_result, ChecksumPolicy policy);
+
+/// Run one line through both validation passes.  Returns true and fills
+/// `rec` when the line yields a record; otherwise bumps the matching
+/// counter and, for a checksum or parse failure, records it in
+/// `counters.rejects` as found at `at`.  Empty lines are ignored entirely.
+bool ingest_line(std::string_view line, GpsRecord& rec, IngestCounters& counters,
+                 ChecksumPolicy checksum = ChecksumPolicy::kAll, LineOrigin at = {});
+
+/// Validate every line in `buf`, appending records to `out` in order.
+void ingest_buffer(std::string_view buf, std::vector<GpsRecord>& out,
+                   IngestCounters& counters);
+
+/// As above with epoch fusion per `fusion`.  `lookback` is text before
+/// `buf` (from a line start) whose GGA/GSA lines seed the epoch slots;
+/// it is not counted.
+void ingest_buffer(std::string_view buf, const FusionOptions& fusion,
+                   std::string_view lookback, std::vector<GpsRecord>& out,
+                   IngestCounters& counters);
+
+/// As above with every per-line option of `opts`: fusion, checksum policy
+/// and talker tracks (`opts.jobs`, `chunk_bytes` and `cache_dir` do not apply).
+void ingest_buffer(std::string_view buf, const IngestOptions& opts,
+                   std::string_view lookback, std::vector<GpsRecord>& out,
+                   IngestCounters& counters);
+
+/// Ingest every file in `paths`, appending records to `out` in argument
+/// and line order — the result is identical for any `opts.jobs`.
+/// Gzip and zstd inputs (codec.h) are decoded on the fly; not being
+/// splittable, they are spread across `opts.jobs` whole.  Unopenable or
+/// undecodable files are reported on stderr and skipped.  With
+/// `opts.cache_dir` set, each input is looked up in the parse cache
+/// (cache.h) first and stored there after parsing.
+void ingest_files(const std::vector<std::string>& paths,
+                  const IngestOptions& opts,
+                  std::vector<GpsRecord>& out,
+                  IngestCounters& counters);
+
+/// As above, but the records live in `arena` (one region for the whole
+/// run, including the per-chunk buffers of a parallel ingest) and the
+/// returned span views them.
+Span<GpsRecord> ingest_files(const std::vector<std::string>& paths,
+                             const IngestOptions& opts,
+                             Arena& arena,
+                             IngestCounters& counters);
+
+/// Callback receiving each validated record as soon as it is parsed.
+using RecordSink = std::function<void(const GpsRecord&)>;
+
+/// Streaming ingest: map `paths` one at a time and hand every record to
+/// `sink` in argument and line order without buffering them.
+/// `opts.jobs` is ignored; `opts.fusion` applies.  Memory use
+/// is independent of input size; a compressed input is decoded on a
+/// thread of its own while this one parses.  Cached inputs are replayed from
+/// `opts.cache_dir`, but misses are not stored, since that would mean
+/// buffering the file's records.  Unopenable files are reported on
+/// stderr and skipped.
+///
+/// With `offsets` (--checkpoint), reading resumes: `(*offsets)[i]` is how
+/// much of input i's text (decoded text, for a compressed input) earlier
+/// runs consumed, and on return it is where this call stopped.  Only
+/// whole lines are read, so a last line still missing its '\n' is left
+/// for the next run.  Missing entries count as 0.
+void stream_files(const std::vector<std::string>& paths,
+                  const IngestOptions& opts,
+                  const RecordSink& sink,
+                  IngestCounters& counters,
+                  std::vector<std::uint64_t>* offsets = nullptr);
+
+/// Threaded form of stream_files (--pipeline): the same records reach
+/// `sink` in the same order, but reading, parsing and the sink overlap.
+/// A reader thread maps each input, faults its pages in and deals it out
+/// in newline-aligned blocks to `opts.jobs` parse workers (decoding a
+/// compressed input into the blocks itself); `sink` runs on the calling
+/// thread.  The stages are joined by bounded rings (ring.h),
+/// so a slow stage holds the others back instead of buffering the
+/// input, and memory stays bounded.  Time spent in `sink` is recorded as
+/// Stage::kTemporalDedup.  Cache hits are replayed, misses are not stored.
+void pipeline_files(const std::vector<std::string>& paths,
+                    const IngestOptions& opts,
+                    const RecordSink& sink,
+                    IngestCounters& counters);
+
+#endif // INGEST_H
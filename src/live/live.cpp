@@ -0,0 +1,427 @@
+/*
+ * live.cpp — Live NMEA stream input (serial tty, TCP, gpsd socket)
+ */
+
+#include "live.h"
+#include "reader.h"
+#include "ring.h"
+#include "gpsd_config.h"
+#include "gpsd.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+// ─── Live input constants ──────────────────────────────────────────────────
+
+static constexpr std::string_view kSchemeSerial = "serial:";
+static constexpr std::string_view kSchemeTcp    = "tcp://";
+static constexpr std::string_view kSchemeGpsd   = "gpsd://";
+static constexpr std::string_view kDevPrefix    = "/dev/";
+static constexpr char             kBaudSep      = '@';
+static constexpr char             kPortSep      = ':';
+static constexpr char             kJsonStart    = '{';   // gpsd JSON reports
+static constexpr std::size_t      kReadBufBytes = 4 * 1024;
+
+// Reads queued between the reader and the processing thread: 1 MiB, a
+// good half hour of a 4800-baud receiver, before a stalled output sink
+// holds the reader back.
+static constexpr std::size_t kLiveRingChunks = 256;
+
+/// Switch gpsd into raw NMEA passthrough.
+static constexpr std::string_view kGpsdWatchNmea =
+    "?WATCH={\"enable\":true,\"nmea\":true};\n";
+
+static std::atomic<bool> g_stop_requested{false};
+
+using Clock = std::chrono::steady_clock;
+
+// ─── Internal helpers ───────────────────────────────────────────────────────
+
+/// Split "HOST:PORT" (PORT optional when `default_port` is non-empty).
+static bool split_host_port(std::string_view hp, std::string_view default_port,
+                            LiveSource& out, std::string& error)
+{
+    auto colon = hp.rfind(kPortSep);
+    if (colon == std::string_view::npos) {
+        if (default_port.empty()) {
+            error = "missing port in '" + std::string(hp) + "'";
+            return false;
+        }
+        out.host = std::string(hp);
+        out.port = std::string(default_port);
+    } else {
+        out.host = std::string(hp.substr(0, colon));
+        out.port = std::string(hp.substr(colon + 1));
+    }
+    if (out.host.empty() || out.port.empty()) {
+        error = "malformed address '" + std::string(hp) + "'";
+        return false;
+    }
+    return true;
+}
+
+#if !defined(_WIN32)
+
+/// Map a numeric baud rate onto its termios constant.
+static bool baud_constant(unsigned baud, speed_t& out)
+{
+    switch (baud) {
+    case 4800:   out = B4800;   return true;
+    case 9600:   out = B9600;   return true;
+    case 19200:  out = B19200;  return true;
+    case 38400:  out = B38400;  return true;
+    case 57600:  out = B57600;  return true;
+    case 115200: out = B115200; return true;
+    case 230400: out = B230400; return true;
+    default:     return false;
+    }
+}
+
+static int open_serial(const LiveSource& src, std::string& error)
+{
+    speed_t speed{};
+    if (!baud_constant(src.baud, speed)) {
+        error = "unsupported baud rate " + std::to_string(src.baud);
+        return -1;
+    }
+
+    int fd = ::open(src.path.c_str(), O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        error = "cannot open '" + src.path + "': " + std::strerror(errno);
+        return -1;
+    }
+
+    // Raw 8N1; block until at least one byte is available.
+    struct termios tio {};
+    if (::tcgetattr(fd, &tio) == 0) {
+        ::cfmakeraw(&tio);
+        ::cfsetispeed(&tio, speed);
+        ::cfsetospeed(&tio, speed);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cc[VMIN]  = 1;
+        tio.c_cc[VTIME] = 0;
+        ::tcsetattr(fd, TCSANOW, &tio);
+    }
+    return fd;
+}
+
+static int open_socket(const LiveSource& src, std::string& error)
+{
+    struct addrinfo hints {};
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* res = nullptr;
+    int rc = ::getaddrinfo(src.host.c_str(), src.port.c_str(), &hints, &res);
+    if (rc != 0) {
+        error = "cannot resolve '" + src.host + "': " + ::gai_strerror(rc);
+        return -1;
+    }
+
+    int fd = -1;
+    for (auto* ai = res; ai && fd < 0; ai = ai->ai_next) {
+        fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd >= 0 && ::connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    ::freeaddrinfo(res);
+    if (fd < 0) {
+        error = "cannot connect to " + src.host + ":" + src.port;
+        return -1;
+    }
+
+    if (src.kind == LiveSourceKind::kGpsd &&
+        ::write(fd, kGpsdWatchNmea.data(), kGpsdWatchNmea.size()) !=
+            static_cast<ssize_t>(kGpsdWatchNmea.size())) {
+        error = "cannot send WATCH request to gpsd";
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+extern "C" void on_stop_signal(int)
+{
+    request_live_stop();
+}
+
+/// Route SIGINT/SIGTERM to `request_live_stop` for the session.  No
+/// SA_RESTART, so a blocked read() returns EINTR and the loop notices.
+class StopSignalScope {
+public:
+    StopSignalScope()
+    {
+        struct sigaction sa {};
+        sa.sa_handler = on_stop_signal;
+        sigemptyset(&sa.sa_mask);
+        ::sigaction(SIGINT,  &sa, &old_int_);
+        ::sigaction(SIGTERM, &sa, &old_term_);
+    }
+    ~StopSignalScope()
+    {
+        ::sigaction(SIGINT,  &old_int_,  nullptr);
+        ::sigaction(SIGTERM, &old_term_, nullptr);
+    }
+    StopSignalScope(const StopSignalScope&)            = delete;
+    StopSignalScope& operator=(const StopSignalScope&) = delete;
+
+private:
+    struct sigaction old_int_ {};
+    struct sigaction old_term_ {};
+};
+
+/// Keep SIGINT/SIGTERM away from the calling thread, so they interrupt
+/// the reader's blocking read() instead.
+void block_stop_signals()
+{
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    ::pthread_sigmask(SIG_BLOCK, &set, nullptr);
+}
+
+/// One read() worth of bytes and the moment it came off the wire.
+struct LiveChunk {
+    Clock::time_point               arrived;
+    std::size_t                     size = 0;
+    std::array<char, kReadBufBytes> data;
+};
+
+#endif // !_WIN32
+
+// ─── Public API ─────────────────────────────────────────────────────────────
+
+bool parse_live_source(std::string_view spec, LiveSource& out,
+                       std::string& error)
+{
+    out = LiveSource{};
+    if (spec.substr(0, kSchemeTcp.size()) == kSchemeTcp) {
+        out.kind = LiveSourceKind::kTcp;
+        return split_host_port(spec.substr(kSchemeTcp.size()), {}, out, error);
+    }
+    if (spec.substr(0, kSchemeGpsd.size()) == kSchemeGpsd) {
+        out.kind = LiveSourceKind::kGpsd;
+        return split_host_port(spec.substr(kSchemeGpsd.size()),
+                               DEFAULT_GPSD_PORT, out, error);
+    }
+
+    std::string_view path = spec;
+    if (path.substr(0, kSchemeSerial.size()) == kSchemeSerial)
+        path.remove_prefix(kSchemeSerial.size());
+    else if (path.substr(0, kDevPrefix.size()) != kDevPrefix) {
+        error = "unrecognised live source '" + std::string(spec) + "'";
+        return false;
+    }
+
+    out.kind = LiveSourceKind::kSerial;
+    auto at = path.rfind(kBaudSep);
+    if (at != std::string_view::npos) {
+        const std::string baud(path.substr(at + 1));
+        char* end = nullptr;
+        unsigned long v = std::strtoul(baud.c_str(), &end, 10);
+        if (baud.empty() || *end != '\0') {
+            error = "invalid baud rate '" + baud + "'";
+            return false;
+        }
+        out.baud = static_cast<unsigned>(v);
+        path = path.substr(0, at);
+    }
+    if (path.empty()) {
+        error = "missing serial device in '" + std::string(spec) + "'";
+        return false;
+    }
+    out.path = std::string(path);
+    return true;
+}
+
+void request_live_stop()
+{
+    g_stop_requested.store(true, std::memory_order_relaxed);
+}
+
+#if defined(_WIN32)
+
+bool run_live(const LiveSource&, const LiveOptions&, const PointSink&,
+              LiveStats&, std::string& error)
+{
+    error = "live input is not supported on this platform";
+    return false;
+}
+
+#else
+
+bool run_live(const LiveSource& src, const LiveOptions& opts,
+              const PointSink& on_point, LiveStats& stats, std::string& error)
+{
+    stats = LiveStats{};
+    g_stop_requested.store(false, std::memory_order_relaxed);
+
+    int fd = (src.kind == LiveSourceKind::kSerial) ? open_serial(src, error)
+                                                   : open_socket(src, error);
+    if (fd < 0)
+        return false;
+    StopSignalScope stop_signals;
+
+    // This thread only reads; parsing, dedup and the point sink run on
+    // `worker`, fed through `ring`, so a sink that blocks (a stalled
+    // terminal or pipe) delays output but never the reads.
+    SpscRing<LiveChunk> ring(kLiveRingChunks);
+    std::thread worker([&] {
+        block_stop_signals();
+
+        // Arrival time of the sentence behind each still-pending timestamp,
+        // so latency can be charged to the record that actually wins.
+        std::unordered_map<std::int64_t, Clock::time_point> arrival;
+
+        RouteFilter    spatial(opts.spatial);
+        StreamingDedup lww(opts.window_ms, [&](const GpsRecord& rec) {
+            auto it = arrival.find(rec.timestamp_ms);
+            const Clock::time_point t0 = (it != arrival.end()) ? it->second : Clock::now();
+            if (it != arrival.end())
+                arrival.erase(it);
+            if (!spatial.accept(rec))
+                return;
+
+            on_point(rec);
+            const auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                Clock::now() - t0).count();
+            stats.latency_min_us = stats.route_points ? std::min(stats.latency_min_us, us) : us;
+            stats.latency_max_us = std::max(stats.latency_max_us, us);
+            stats.latency_sum_us += us;
+            ++stats.route_points;
+        });
+
+        auto on_line = [&](std::string_view line, Clock::time_point t, std::uint64_t at) {
+            // gpsd interleaves JSON reports with the NMEA passthrough.
+            if (src.kind == LiveSourceKind::kGpsd && !line.empty() && line[0] == kJsonStart)
+                return;
+            GpsRecord rec{};
+            if (!ingest_line(line, rec, stats.counters, opts.checksum, {0, at}))
+                return;
+            ++stats.records_parsed;
+            const GpsRecord*   held          = lww.held_ahead();
+            const std::int64_t held_ms       = held ? held->timestamp_ms : 0;
+            const std::size_t  late_before   = lww.late_dropped();
+            const std::size_t  future_before = lww.future_dropped();
+            arrival[rec.timestamp_ms] = t;
+            lww.push(rec);
+            if (lww.late_dropped() != late_before)
+                arrival.erase(rec.timestamp_ms);   // its slot was already emitted
+            if (lww.future_dropped() != future_before)
+                arrival.erase(held_ms);            // the held outlier never will be
+        };
+
+        std::string   buf;               // bytes of the current, incomplete line
+        std::uint64_t buf_at   = 0;      // stream offset of buf[0]
+        std::uint64_t received = 0;      // stream bytes before the current chunk
+        bool          skipping = false;  // inside a line that outgrew the cap
+        const auto buf_offset = [&](std::string_view line) {
+            return buf_at + static_cast<std::uint64_t>(line.data() - buf.data());
+        };
+        const auto carry = [&](std::string_view part) {
+            if (buf.size() + part.size() > kMaxLiveLineBytes) {
+                ++stats.overlong_lines;
+                buf.clear();
+                skipping = true;
+            } else {
+                buf.append(part);
+            }
+        };
+        LiveChunk chunk;
+        while (ring.pop(chunk)) {
+            const Clock::time_point t = chunk.arrived;
+            const std::uint64_t chunk_at = received;
+            received += chunk.size;
+            const auto offset_of = [&](std::string_view line) {
+                return chunk_at + static_cast<std::uint64_t>(line.data() - chunk.data.data());
+            };
+
+            // Complete lines inside this chunk are handled in place; only a
+            // trailing partial line is carried over into `buf`, and dropped
+            // once it outgrows kMaxLiveLineBytes.
+            std::string_view data(chunk.data.data(), chunk.size);
+            if (skipping || !buf.empty()) {
+                auto nl = data.find('\n');
+                const std::string_view head =
+                    data.substr(0, nl == std::string_view::npos ? data.size() : nl + 1);
+                data.remove_prefix(head.size());
+                if (!skipping)
+                    carry(head);
+                if (nl == std::string_view::npos)
+                    continue;
+                skipping = false;   // the dropped line, if any, ends here
+                LineCursor carried(buf);
+                std::string_view line;
+                while (carried.next(line))
+                    on_line(line, t, buf_offset(line));
+                buf.clear();
+            }
+
+            auto last_nl = data.rfind('\n');
+            std::string_view complete = (last_nl == std::string_view::npos)
+                                            ? std::string_view{}
+                                            : data.substr(0, last_nl + 1);
+            LineCursor cursor(complete);
+            std::string_view line;
+            while (cursor.next(line))
+                on_line(line, t, offset_of(line));
+            buf_at = offset_of(data.substr(complete.size()));
+            carry(data.substr(complete.size()));
+        }
+
+        LineCursor tail(buf);       // final line without a newline, if any
+        std::string_view line;
+        while (tail.next(line))
+            on_line(line, Clock::now(), buf_offset(line));
+        lww.flush();
+
+        stats.after_lww    = lww.emitted();
+        stats.late_dropped   = lww.late_dropped();
+        stats.future_dropped = lww.future_dropped();
+    });
+
+    LiveChunk chunk;
+    bool ok = true;
+    while (!g_stop_requested.load(std::memory_order_relaxed)) {
+        ssize_t n = ::read(fd, chunk.data.data(), chunk.data.size());
+        if (n == 0)
+            break;              // peer closed / device gone
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            error = std::string("read failed: ") + std::strerror(errno);
+            ok = false;
+            break;
+        }
+        chunk.arrived = Clock::now();
+        chunk.size    = static_cast<std::size_t>(n);
+        stats.bytes_read += chunk.size;
+        ring.push(std::move(chunk));
+    }
+    ::close(fd);
+    ring.close();
+    worker.join();
+    return ok;
+}
+
+#endif // _WIN32
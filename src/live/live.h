@@ -0,0 +1,86 @@
+/*
+ * live.h — Live NMEA stream input (serial tty, TCP, gpsd socket)
+ */
+
+#ifndef LIVE_H
+#define LIVE_H
+
+#include "dedup.h"
+#include "ingest.h"
+#include "nmea_parser.h"
+#include "spatial.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+/// Where a live NMEA stream comes from.
+enum class LiveSourceKind {
+    kSerial,   // serial tty, raw 8N1 at `baud`
+    kTcp,      // plain TCP socket carrying NMEA lines
+    kGpsd      // gpsd daemon; NMEA mode is requested with ?WATCH
+};
+
+/// Parsed `--live` source specification.
+///   serial:/dev/ttyUSB0[@BAUD]   (or a bare /dev/… path)
+///   tcp://HOST:PORT
+///   gpsd://HOST[:PORT]           (PORT defaults to gpsd's 2947)
+struct LiveSource {
+    LiveSourceKind kind = LiveSourceKind::kTcp;
+    std::string    path;          // serial device
+    unsigned       baud = 4800;   // NMEA 0183 default rate
+    std::string    host;          // tcp / gpsd
+    std::string    port;
+};
+
+/// Parse a source spec.  Returns false and sets `error` if malformed.
+bool parse_live_source(std::string_view spec, LiveSource& out,
+                       std::string& error);
+
+/// Latency and throughput of a live session.  Latency is measured per
+/// emitted route point, from the moment the bytes of its sentence were
+/// read off the wire to the moment the point sink returned.
+struct LiveStats {
+    IngestCounters counters;
+    std::size_t    bytes_read      = 0;
+    std::size_t    records_parsed  = 0;
+    std::size_t    after_lww       = 0;
+    std::size_t    late_dropped    = 0;
+    std::size_t    future_dropped  = 0;
+    std::size_t    overlong_lines  = 0;   // no '\n' within kMaxLiveLineBytes
+    std::size_t    route_points    = 0;
+    std::int64_t   latency_min_us  = 0;
+    std::int64_t   latency_max_us  = 0;
+    std::int64_t   latency_sum_us  = 0;
+};
+
+/// Longest line `run_live` carries across reads.  A source that sends more
+/// than this without a newline has the line dropped up to its next '\n'.
+inline constexpr std::size_t kMaxLiveLineBytes = 64 * 1024;
+
+/// Streaming stage parameters for the live pipeline.
+struct LiveOptions {
+    std::int64_t   window_ms = 0;   // 0 = emit at once
+    SpatialOptions spatial;         // metric and threshold (no simplification)
+    ChecksumPolicy checksum = ChecksumPolicy::kAll;   // --fast-reject
+};
+
+/// Called for every surviving route point, in order, as soon as it clears
+/// temporal and spatial dedup.
+using PointSink = std::function<void(const GpsRecord&)>;
+
+/// Connect to `src` and run it through ingest_line → StreamingDedup →
+/// RouteFilter until the stream ends, `request_live_stop` is called, or
+/// SIGINT/SIGTERM arrives (handlers are installed for the session).
+/// Returns false and sets `error` if the source can't be opened or the
+/// read fails; `stats` is filled in either case.
+bool run_live(const LiveSource& src, const LiveOptions& opts,
+              const PointSink& on_point, LiveStats& stats, std::string& error);
+
+/// Ask a running `run_live` to finish (flush pending points and return).
+/// Async-signal-safe, so it can be called from a SIGINT handler.
+void request_live_stop();
+
+#endif // LIVE_H
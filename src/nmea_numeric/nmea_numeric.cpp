@@ -0,0 +1,151 @@
+/*
+ * nmea_numeric.cpp — Locale-free, non-throwing NMEA numeric field decoders
+ *
+ * Everything is parsed digit by digit into 64-bit integers; doubles appear
+ * only in the final scale step.  No allocation, no locale, no exceptions.
+ */
+
+#include "nmea_numeric.h"
+
+// ─── Numeric constants ─────────────────────────────────────────────────────
+
+static constexpr char        kDecimalPoint      = '.';
+static constexpr char        kMinusSign         = '-';
+static constexpr char        kPlusSign          = '+';
+static constexpr char        kHemSouth          = 'S';
+static constexpr char        kHemWest           = 'W';
+static constexpr std::size_t kMinuteDigitWidth  = 2;   // "MM" before the '.'
+static constexpr std::size_t kMaxDegreeDigits   = 3;   // longitude "DDD"
+static constexpr unsigned    kMicroMinuteDigits = 6;
+static constexpr unsigned    kSpeedFracDigits   = 3;   // milli-knots
+static constexpr std::size_t kMaxIntegerDigits  = 12;  // keeps values far from overflow
+static constexpr std::int64_t kMicroMinutesPerUnit =
+    kMicroMinutesPerDegree / kCoordUnitsPerDegree;     // 6
+
+// ─── Internal helpers ───────────────────────────────────────────────────────
+
+static inline bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/// Accumulate the digits of `s` onto `acc`.  False on any non-digit.
+static bool accumulate_digits(std::string_view s, std::int64_t& acc)
+{
+    for (char c : s) {
+        if (!is_digit(c))
+            return false;
+        acc = acc * 10 + (c - '0');
+    }
+    return true;
+}
+
+// ─── Public API ─────────────────────────────────────────────────────────────
+
+bool decode_fixed(std::string_view raw, unsigned frac_digits, std::int64_t& out)
+{
+    auto dot = raw.find(kDecimalPoint);
+    std::string_view int_part  = raw.substr(0, dot);
+    std::string_view frac_part = (dot == std::string_view::npos)
+                                     ? std::string_view{}
+                                     : raw.substr(dot + 1);
+    if ((int_part.empty() && frac_part.empty()) ||
+        int_part.size() > kMaxIntegerDigits)
+        return false;
+
+    std::int64_t value = 0;
+    if (!accumulate_digits(int_part, value))
+        return false;
+
+    // Kept fraction digits, zero padding, then round on the next digit.
+    for (unsigned i = 0; i < frac_digits; ++i) {
+        const char c = i < frac_part.size() ? frac_part[i] : '0';
+        if (!is_digit(c))
+            return false;
+        value = value * 10 + (c - '0');
+    }
+    for (std::size_t i = frac_digits; i < frac_part.size(); ++i) {
+        if (!is_digit(frac_part[i]))
+            return false;
+    }
+    if (frac_part.size() > frac_digits && frac_part[frac_digits] >= '5')
+        ++value;
+
+    out = value;
+    return true;
+}
+
+bool decode_signed_fixed(std::string_view raw, unsigned frac_digits, std::int64_t& out)
+{
+    const bool negative = !raw.empty() && raw[0] == kMinusSign;
+    if (negative || (!raw.empty() && raw[0] == kPlusSign))
+        raw.remove_prefix(1);
+
+    std::int64_t value = 0;
+    if (!decode_fixed(raw, frac_digits, value))
+        return false;
+    out = negative ? -value : value;
+    return true;
+}
+
+bool decode_coord_micro_minutes(std::string_view raw, std::int64_t& out)
+{
+    auto dot = raw.find(kDecimalPoint);
+    if (dot == std::string_view::npos || dot <= kMinuteDigitWidth ||
+        dot - kMinuteDigitWidth > kMaxDegreeDigits)
+        return false;
+
+    std::int64_t degrees = 0;
+    if (!accumulate_digits(raw.substr(0, dot - kMinuteDigitWidth), degrees))
+        return false;
+
+    std::int64_t micro_minutes = 0;
+    if (!decode_fixed(raw.substr(dot - kMinuteDigitWidth), kMicroMinuteDigits,
+                      micro_minutes))
+        return false;
+
+    out = degrees * kMicroMinutesPerDegree + micro_minutes;
+    return true;
+}
+
+bool decode_coord_degrees(std::string_view raw, char hem, double& out)
+{
+    std::int64_t micro_minutes = 0;
+    if (!decode_coord_micro_minutes(raw, micro_minutes))
+        return false;
+
+    double dd = static_cast<double>(micro_minutes) /
+                static_cast<double>(kMicroMinutesPerDegree);
+    if (hem == kHemSouth || hem == kHemWest)
+        dd = -dd;
+    out = dd;
+    return true;
+}
+
+bool decode_coord_units(std::string_view raw, char hem, std::int32_t& out)
+{
+    std::int64_t micro_minutes = 0;
+    if (!decode_coord_micro_minutes(raw, micro_minutes))
+        return false;
+
+    const std::int64_t units =
+        (micro_minutes + kMicroMinutesPerUnit / 2) / kMicroMinutesPerUnit;
+    if (units > kMaxCoordUnits)
+        return false;
+    out = static_cast<std::int32_t>(hem == kHemSouth || hem == kHemWest ? -units : units);
+    return true;
+}
+
+bool decode_speed_mps(std::string_view raw, double& out)
+{
+    if (raw.empty()) {
+        out = 0.0;
+        return true;
+    }
+
+    std::int64_t milli_knots = 0;
+    if (!decode_fixed(raw, kSpeedFracDigits, milli_knots))
+        return false;
+    out = static_cast<double>(milli_knots) / 1000.0 * kKnotsToMps;
+    return true;
+}
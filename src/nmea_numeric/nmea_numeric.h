@@ -0,0 +1,50 @@
+/*
+ * nmea_numeric.h — Locale-free, non-throwing NMEA numeric field decoders
+ */
+
+#ifndef NMEA_NUMERIC_H
+#define NMEA_NUMERIC_H
+
+#include <cstdint>
+#include <string_view>
+
+/// Fixed-point resolution of decoded coordinates: 1e-6 arc-minute
+/// (≈ 1.9 mm of latitude), well past any receiver's precision.
+inline constexpr std::int64_t kMicroMinutesPerMinute = 1'000'000;
+inline constexpr std::int64_t kMicroMinutesPerDegree = 60 * kMicroMinutesPerMinute;
+
+/// Resolution of stored coordinates: 1e-7 degree (≈ 1.1 cm of latitude),
+/// so ±180° fits an int32.
+inline constexpr std::int32_t kCoordUnitsPerDegree = 10'000'000;
+inline constexpr std::int32_t kMaxCoordUnits       = 180 * kCoordUnitsPerDegree;
+
+/// Knots → metres/second conversion factor.
+inline constexpr double kKnotsToMps = 0.514444;
+
+/// Decode an unsigned decimal (`DDD[.fff…]`) into an integer scaled by
+/// 10^`frac_digits`, rounding half-up on the first dropped digit.
+/// Returns false unless the whole field is digits with at most one '.'.
+bool decode_fixed(std::string_view raw, unsigned frac_digits, std::int64_t& out);
+
+/// `decode_fixed` with an optional leading '-' or '+' (altitudes).
+bool decode_signed_fixed(std::string_view raw, unsigned frac_digits, std::int64_t& out);
+
+/// Decode an NMEA coordinate (`DDMM.mmmm` / `DDDMM.mmmm`) into unsigned
+/// micro-minutes.  The last two integer digits are the minutes; the rest
+/// (1–3 digits) are degrees.
+bool decode_coord_micro_minutes(std::string_view raw, std::int64_t& out);
+
+/// Decode a coordinate plus hemisphere (`S`/`W` negate) into decimal
+/// degrees via integer micro-minutes.
+bool decode_coord_degrees(std::string_view raw, char hem, double& out);
+
+/// Decode a coordinate plus hemisphere into 1e-7 degree units, rounding
+/// the micro-minutes half-up — integer arithmetic only, so every build
+/// gets the same bits.  Fails beyond ±180°.
+bool decode_coord_units(std::string_view raw, char hem, std::int32_t& out);
+
+/// Decode a speed-over-ground field in knots into metres per second.
+/// An empty field decodes as 0.
+bool decode_speed_mps(std::string_view raw, double& out);
+
+#endif // NMEA_NUMERIC_H
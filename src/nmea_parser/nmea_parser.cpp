@@ -3,12 +3,15 @@
  */
 
 #include "nmea_parser.h"
+#include "nmea_numeric.h"
+#include "scan.h"
+#include "sentence.h"
 
-#include <cmath>
+#include <array>
 #include <cstdint>
 #include <cstdio>
+#include <limits>
 #include <string>
-#include <vector>
 
 // ─── NMEA protocol constants ────────────────────────────────────────────────
 
@@ -27,26 +30,47 @@ static constexpr std::size_t kFieldNS         = 4;
 static constexpr std::size_t kFieldLon        = 5;
 static constexpr std::size_t kFieldEW         = 6;
 static constexpr std::size_t kFieldSpeed      = 7;
+static constexpr std::size_t kFieldDate       = 9;
 static constexpr std::size_t kGprmcMinFields  = kFieldSpeed + 1;  // need at least 8
 
-// ─── Sentence identifiers ──────────────────────────────────────────────────
+// ─── GGA / GSA field indices ────────────────────────────────────────────────
 
-static constexpr const char* kIdGPRMC = "$GPRMC";
-static constexpr const char* kIdGNRMC = "$GNRMC";
-static constexpr const char* kIdGPGSA = "$GPGSA";
-static constexpr const char* kIdGPGGA = "$GPGGA";
-static constexpr const char* kIdGNGSA = "$GNGSA";
-static constexpr const char* kIdGNGGA = "$GNGGA";
+static constexpr std::size_t kGgaFieldTime     = 1;
+static constexpr std::size_t kGgaFieldQuality  = 6;
+static constexpr std::size_t kGgaFieldSats     = 7;
+static constexpr std::size_t kGgaFieldHdop     = 8;
+static constexpr std::size_t kGgaFieldAltitude = 9;
+static constexpr std::size_t kGgaMinFields     = kGgaFieldAltitude + 1;
+
+static constexpr std::size_t kGsaFieldFixType  = 2;
+static constexpr std::size_t kGsaFieldPdop     = 15;
+static constexpr std::size_t kGsaFieldHdop     = 16;
+static constexpr std::size_t kGsaFieldVdop     = 17;
+static constexpr std::size_t kGsaMinFields     = kGsaFieldVdop + 1;
 
 // ─── Parsing constants ─────────────────────────────────────────────────────
 
-static constexpr char   kStatusActive     = 'A';   // RMC status: Active (valid fix)
-static constexpr char   kHemSouth         = 'S';
-static constexpr char   kHemWest          = 'W';
-static constexpr double kKnotsToMps       = 0.514444;
-static constexpr double kMinutesPerDegree = 60.0;
-static constexpr std::size_t kMinuteDigitWidth = 2;  // "MM" portion before decimal
-static constexpr std::size_t kHemFieldLen = 1;        // single-char hemisphere field
+static constexpr char        kStatusActive = 'A';  // RMC status: Active (valid fix)
+static constexpr std::size_t kHemFieldLen  = 1;    // single-char hemisphere field
+static constexpr unsigned    kMilliDigits  = 3;    // DOP / altitude resolution
+static constexpr std::int64_t kMaxSmallInt = 255;  // fix quality, satellite count
+
+// ─── Time-of-day constants (HHMMSS.sss) ────────────────────────────────────
+
+static constexpr std::size_t  kTimeDigits     = 6;     // "HHMMSS" before the '.'
+static constexpr std::size_t  kTimeFracDigits = 3;     // millisecond resolution
+static constexpr int          kMaxHour        = 23;
+static constexpr int          kMaxMinute      = 59;
+static constexpr int          kMaxSecond      = 60;    // allow a leap second
+static constexpr std::int64_t kMsPerSecond    = 1000;
+static constexpr std::int64_t kMsPerMinute    = 60 * kMsPerSecond;
+static constexpr std::int64_t kMsPerHour      = 60 * kMsPerMinute;
+
+// ─── Date constants (DDMMYY) ────────────────────────────────────────────────
+
+static constexpr std::size_t  kDateDigits     = 6;
+static constexpr int          kCenturyPivot   = 80;    // YY < 80 → 20YY, else 19YY
+static constexpr int          kDaysInMonth[]  = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
 
 // ─── Internal limits ────────────────────────────────────────────────────────
 
@@ -54,124 +78,394 @@ static constexpr std::size_t kMaxFields  = 20;
 
 // ─── Internal helpers ───────────────────────────────────────────────────────
 
-/// Split a string by a single-character delimiter.
-static std::vector<std::string> split(const std::string& s, char delim)
+/// Fixed-capacity field table: views into the caller's sentence, so
+/// splitting never touches the heap.  Fields past `kMaxFields` are dropped.
+struct NmeaFields {
+    std::array<std::string_view, kMaxFields> field;
+    std::size_t                              count = 0;
+};
+
+/// Split a sentence body on `delim` into `out` without allocating.
+static void split_fields(std::string_view s, char delim, NmeaFields& out)
 {
-    std::vector<std::string> tokens;
-    tokens.reserve(kMaxFields);
-    std::string::size_type start = 0;
-    std::string::size_type end   = 0;
-    while ((end = s.find(delim, start)) != std::string::npos) {
-        tokens.emplace_back(s, start, end - start);
+    out.count = 0;
+    std::size_t start = 0;
+    while (out.count < kMaxFields) {
+        auto end = s.find(delim, start);
+        if (end == std::string_view::npos) {
+            out.field[out.count++] = s.substr(start);
+            return;
+        }
+        out.field[out.count++] = s.substr(start, end - start);
         start = end + 1;
     }
-    tokens.emplace_back(s, start);
-    return tokens;
 }
 
-/// Convert NMEA coordinate format DDMM.MMMM(…) to decimal degrees.
-static double nmea_to_decimal(const std::string& raw, char hem)
+/// Split a sentence body using the comma bitmask from `scan_sentence`
+/// (bits at or past `body.size()` are ignored).  Falls back to
+/// `split_fields` when the line was too long for the mask.
+static void split_fields(std::string_view body, const SentenceScan& scan,
+                         NmeaFields& out)
 {
-    if (raw.empty()) return std::nan("");
+    if (!scan.mask_complete) {
+        split_fields(body, kNmeaFieldDelim, out);
+        return;
+    }
+
+    // Same contract as the scalar split: at most kMaxFields fields, and
+    // anything past the last stored field is dropped.
+    out.count = 0;
+    std::size_t start = 0;
+    for (std::size_t w = 0; w < kScanMaskWords; ++w) {
+        for (std::uint64_t bits = scan.comma_mask[w]; bits; bits &= bits - 1) {
+            const std::size_t pos = w * 64 + static_cast<std::size_t>(__builtin_ctzll(bits));
+            if (pos >= body.size())
+                break;
+            if (out.count == kMaxFields)
+                return;
+            out.field[out.count++] = body.substr(start, pos - start);
+            start = pos + 1;
+        }
+    }
+    if (out.count < kMaxFields)
+        out.field[out.count++] = body.substr(start);
+}
+
+/// Decode one hex digit; returns -1 for anything that isn't [0-9A-Fa-f].
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+/// Checksum field that is not two hex digits: read it as the original
+/// sscanf("%02X") reader did, which skips leading whitespace and accepts
+/// a sign, a "0x" prefix or a lone digit ("*7\r").  Rare, so the copy
+/// that NUL-terminates the field does not matter.
+static bool scan_checksum_field(std::string_view field, unsigned& value)
+{
+    const std::string text(field);
+    return std::sscanf(text.c_str(), "%02X", &value) == 1;
+}
+
+/// Convert an NMEA UTC time field (HHMMSS[.s…]) to milliseconds since
+/// midnight.  Fractional digits beyond millisecond resolution are ignored.
+static bool nmea_time_to_ms(std::string_view raw, std::int64_t& out)
+{
+    if (raw.size() < kTimeDigits)
+        return false;
+
+    int digits[kTimeDigits];
+    for (std::size_t i = 0; i < kTimeDigits; ++i) {
+        if (raw[i] < '0' || raw[i] > '9')
+            return false;
+        digits[i] = raw[i] - '0';
+    }
 
-    auto dot = raw.find('.');
-    if (dot == std::string::npos || dot < kMinuteDigitWidth)
-        return std::nan("");
+    const int hh = digits[0] * 10 + digits[1];
+    const int mm = digits[2] * 10 + digits[3];
+    const int ss = digits[4] * 10 + digits[5];
+    if (hh > kMaxHour || mm > kMaxMinute || ss > kMaxSecond)
+        return false;
+
+    std::int64_t frac_ms = 0;
+    if (raw.size() > kTimeDigits) {
+        if (raw[kTimeDigits] != '.')
+            return false;
+        std::int64_t scale = kMsPerSecond;
+        for (std::size_t i = kTimeDigits + 1; i < raw.size(); ++i) {
+            if (raw[i] < '0' || raw[i] > '9')
+                return false;
+            if (i - kTimeDigits <= kTimeFracDigits) {
+                scale /= 10;
+                frac_ms += (raw[i] - '0') * scale;
+            }
+        }
+    }
+
+    out = hh * kMsPerHour + mm * kMsPerMinute + ss * kMsPerSecond + frac_ms;
+    return true;
+}
+
+/// Convert an NMEA date field (DDMMYY) to days since the Unix epoch.
+static bool nmea_date_to_days(std::string_view raw, std::int64_t& out)
+{
+    if (raw.size() != kDateDigits)
+        return false;
 
-    double degrees = 0.0;
-    double minutes = 0.0;
-    try {
-        degrees = std::stod(raw.substr(0, dot - kMinuteDigitWidth));
-        minutes = std::stod(raw.substr(dot - kMinuteDigitWidth));
-    } catch (...) {
-        return std::nan("");
+    int digits[kDateDigits];
+    for (std::size_t i = 0; i < kDateDigits; ++i) {
+        if (raw[i] < '0' || raw[i] > '9')
+            return false;
+        digits[i] = raw[i] - '0';
     }
 
-    double dd = degrees + minutes / kMinutesPerDegree;
-    if (hem == kHemSouth || hem == kHemWest)
-        dd = -dd;
-    return dd;
+    const int dd = digits[0] * 10 + digits[1];
+    const int mm = digits[2] * 10 + digits[3];
+    const int yy = digits[4] * 10 + digits[5];
+    const int year = yy < kCenturyPivot ? 2000 + yy : 1900 + yy;
+    if (mm < 1 || mm > 12 || dd < 1)
+        return false;
+
+    const bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    const int  mdays = kDaysInMonth[mm - 1] + (mm == 2 && leap);
+    if (dd > mdays)
+        return false;
+
+    out = days_from_civil(year, mm, dd);
+    return true;
+}
+
+/// Strip the `*HH` tail and split the body into `fields`.
+static void split_sentence(std::string_view sentence, NmeaFields& fields)
+{
+    SentenceScan scan;
+    scan_sentence(sentence, scan);
+    std::string_view body = (scan.star != std::string_view::npos)
+                                ? sentence.substr(0, scan.star)
+                                : sentence;
+    split_fields(body, scan, fields);
+}
+
+/// Optional decimal field (DOP, altitude) → float; NaN when empty or
+/// malformed, since these only feed quality filters.
+static float decode_optional_milli(std::string_view raw)
+{
+    std::int64_t milli = 0;
+    if (raw.empty() || !decode_signed_fixed(raw, kMilliDigits, milli))
+        return std::numeric_limits<float>::quiet_NaN();
+    return static_cast<float>(static_cast<double>(milli) / 1000.0);
+}
+
+/// Optional small unsigned integer field → 0..255; 0 when empty or malformed.
+static std::uint8_t decode_optional_count(std::string_view raw)
+{
+    std::int64_t v = 0;
+    if (raw.empty() || !decode_fixed(raw, 0, v) || v > kMaxSmallInt)
+        return 0;
+    return static_cast<std::uint8_t>(v);
+}
+
+/// $xxRMC field decode.  The caller has already established (via the
+/// sentence classifier) that this is an RMC sentence from a handled talker.
+/// Returns kNone on success, else the first check that failed.
+static RejectReason parse_rmc_fields(std::string_view sentence, GpsRecord& out)
+{
+    NmeaFields fields;
+    split_sentence(sentence, fields);
+    const auto& f = fields.field;
+
+    if (fields.count < kGprmcMinFields)
+        return RejectReason::kFieldCount;
+
+    if (f[kFieldStatus].empty() ||
+        f[kFieldStatus][0] != kStatusActive)
+        return RejectReason::kVoidStatus;
+
+    std::int64_t time_ms = 0;
+    if (f[kFieldTime].empty())
+        return RejectReason::kEmptyTime;
+    if (!nmea_time_to_ms(f[kFieldTime], time_ms))
+        return RejectReason::kBadTime;
+
+    std::int64_t days = 0;
+    if (fields.count > kFieldDate && !f[kFieldDate].empty() &&
+        !nmea_date_to_days(f[kFieldDate], days))
+        return RejectReason::kBadDate;
+
+    if (f[kFieldNS].size() != kHemFieldLen ||
+        f[kFieldEW].size() != kHemFieldLen)
+        return RejectReason::kBadHemisphere;
+
+    std::int32_t lat = 0;
+    std::int32_t lon = 0;
+    if (!decode_coord_units(f[kFieldLat], f[kFieldNS][0], lat) ||
+        !decode_coord_units(f[kFieldLon], f[kFieldEW][0], lon))
+        return RejectReason::kBadCoordinate;
+
+    // An unreadable speed is not fatal — the position is still good.
+    double speed_mps = 0.0;
+    if (!decode_speed_mps(f[kFieldSpeed], speed_mps))
+        speed_mps = 0.0;
+
+    out.timestamp_ms = days * kMsPerDay + time_ms;
+    out.lat_e7       = lat;
+    out.lon_e7       = lon;
+    out.speed        = static_cast<float>(speed_mps);
+    return RejectReason::kNone;
 }
 
 // ─── Public API ─────────────────────────────────────────────────────────────
 
-ChecksumResult verify_checksum(const std::string& sentence)
+std::int64_t days_from_civil(int y, int m, int d)
+{
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const int yoe = y - era * 400;                                  // [0, 399]
+    const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1; // [0, 365]
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;          // [0, 146096]
+    return static_cast<std::int64_t>(era) * 146097 + doe - 719468;
+}
+
+/// Checksum verdict from a completed scan.
+static ChecksumResult checksum_from_scan(std::string_view sentence,
+                                         const SentenceScan& scan)
 {
     if (sentence.empty() || sentence[0] != kNmeaStart)
         return ChecksumResult::kIncomplete;
 
-    auto star = sentence.rfind(kNmeaChecksumSep);
-    if (star == std::string::npos ||
+    const auto star = scan.star;
+    if (star == std::string_view::npos ||
         star + 1 + kChecksumHexLen > sentence.size())
         return ChecksumResult::kIncomplete;
 
-    uint8_t computed = 0;
-    for (std::size_t i = 1; i < star; ++i)
-        computed ^= static_cast<uint8_t>(sentence[i]);
-
+    const int hi = hex_value(sentence[star + 1]);
+    const int lo = hex_value(sentence[star + 2]);
     unsigned expected = 0;
-    if (std::sscanf(sentence.c_str() + star + 1, "%02X", &expected) != 1)
+    if (hi >= 0 && lo >= 0)
+        expected = static_cast<unsigned>((hi << 4) | lo);
+    else if (!scan_checksum_field(sentence.substr(star + 1), expected))
         return ChecksumResult::kIncomplete;
 
-    return (computed == static_cast<uint8_t>(expected))
+    return (scan.xor_sum == static_cast<uint8_t>(expected))
                ? ChecksumResult::kOk
                : ChecksumResult::kMismatch;
 }
 
-bool is_not_relevant(const std::string& sentence)
+ChecksumResult verify_checksum(std::string_view sentence)
 {
-    auto comma = sentence.find(kNmeaFieldDelim);
-    if (comma == std::string::npos)
-        return false;
+    if (sentence.empty() || sentence[0] != kNmeaStart)
+        return ChecksumResult::kIncomplete;
 
-    auto id = sentence.substr(0, comma);
-    return id == kIdGPGSA || id == kIdGPGGA ||
-           id == kIdGNGSA || id == kIdGNGGA;
+    SentenceScan scan;
+    scan_sentence(sentence, scan);
+    return checksum_from_scan(sentence, scan);
 }
 
-bool parse_gprmc(const std::string& sentence, GpsRecord& out)
+void verify_checksum_batch(const std::string_view* sentences, std::size_t count,
+                           ChecksumResult* results)
 {
-    auto star = sentence.rfind(kNmeaChecksumSep);
-    std::string body = (star != std::string::npos) ? sentence.substr(0, star)
-                                                   : sentence;
+    SentenceScan scan;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (i + 1 < count)
+            __builtin_prefetch(sentences[i + 1].data());
+        scan_sentence(sentences[i], scan);
+        results[i] = checksum_from_scan(sentences[i], scan);
+    }
+}
 
-    auto fields = split(body, kNmeaFieldDelim);
+bool is_not_relevant(std::string_view sentence)
+{
+    return sentence_handler(classify_sentence(sentence)) == SentenceHandler::kNotRelevant;
+}
 
-    if (fields.size() < kGprmcMinFields)
+bool parse_gprmc(std::string_view sentence, GpsRecord& out)
+{
+    if (sentence_handler(classify_sentence(sentence)) != SentenceHandler::kRmc)
         return false;
+    return parse_rmc_fields(sentence, out) == RejectReason::kNone;
+}
 
-    if (fields[kFieldSentenceId] != kIdGPRMC &&
-        fields[kFieldSentenceId] != kIdGNRMC)
-        return false;
+bool parse_gga(std::string_view sentence, GgaData& out)
+{
+    RejectReason why;
+    return parse_gga(sentence, out, why);
+}
 
-    if (fields[kFieldStatus].empty() ||
-        fields[kFieldStatus][0] != kStatusActive)
+bool parse_gga(std::string_view sentence, GgaData& out, RejectReason& why)
+{
+    if (sentence_handler(classify_sentence(sentence), true) != SentenceHandler::kGga) {
+        why = RejectReason::kUnknownType;
         return false;
+    }
 
-    if (fields[kFieldTime].empty())
+    NmeaFields fields;
+    split_sentence(sentence, fields);
+    const auto& f = fields.field;
+    if (fields.count < kGgaMinFields) {
+        why = RejectReason::kFieldCount;
         return false;
+    }
 
-    if (fields[kFieldNS].size() != kHemFieldLen ||
-        fields[kFieldEW].size() != kHemFieldLen)
+    std::int64_t time_ms = 0;
+    if (f[kGgaFieldTime].empty()) {
+        why = RejectReason::kEmptyTime;
         return false;
+    }
+    if (!nmea_time_to_ms(f[kGgaFieldTime], time_ms)) {
+        why = RejectReason::kBadTime;
+        return false;
+    }
+
+    out.timestamp_ms = time_ms;
+    out.fix_quality  = decode_optional_count(f[kGgaFieldQuality]);
+    out.satellites   = decode_optional_count(f[kGgaFieldSats]);
+    out.hdop         = decode_optional_milli(f[kGgaFieldHdop]);
+    out.altitude_m   = decode_optional_milli(f[kGgaFieldAltitude]);
+    return true;
+}
 
-    double lat = nmea_to_decimal(fields[kFieldLat], fields[kFieldNS][0]);
-    double lon = nmea_to_decimal(fields[kFieldLon], fields[kFieldEW][0]);
-    if (std::isnan(lat) || std::isnan(lon))
+bool parse_gsa(std::string_view sentence, GsaData& out)
+{
+    RejectReason why;
+    return parse_gsa(sentence, out, why);
+}
+
+bool parse_gsa(std::string_view sentence, GsaData& out, RejectReason& why)
+{
+    if (sentence_handler(classify_sentence(sentence), true) != SentenceHandler::kGsa) {
+        why = RejectReason::kUnknownType;
         return false;
+    }
 
-    double speed_knots = 0.0;
-    if (!fields[kFieldSpeed].empty()) {
-        try {
-            speed_knots = std::stod(fields[kFieldSpeed]);
-        } catch (...) {
-            speed_knots = 0.0;
-        }
+    NmeaFields fields;
+    split_sentence(sentence, fields);
+    const auto& f = fields.field;
+    if (fields.count < kGsaMinFields) {
+        why = RejectReason::kFieldCount;
+        return false;
     }
 
-    out.timestamp          = fields[kFieldTime];
-    out.stream.latitude    = lat;
-    out.stream.longitude   = lon;
-    out.gpsdata.fix.speed  = speed_knots * kKnotsToMps;
+    out.fix_type = decode_optional_count(f[kGsaFieldFixType]);
+    out.pdop     = decode_optional_milli(f[kGsaFieldPdop]);
+    out.hdop     = decode_optional_milli(f[kGsaFieldHdop]);
+    out.vdop     = decode_optional_milli(f[kGsaFieldVdop]);
     return true;
 }
+
+bool dispatch_sentence(std::string_view sentence, SentenceHandler handler,
+                       GpsRecord& out)
+{
+    RejectReason why;
+    return dispatch_sentence(sentence, handler, out, why);
+}
+
+bool dispatch_sentence(std::string_view sentence, SentenceHandler handler,
+                       GpsRecord& out, RejectReason& why)
+{
+    switch (handler) {
+    case SentenceHandler::kRmc:
+        why = parse_rmc_fields(sentence, out);
+        return why == RejectReason::kNone;
+    case SentenceHandler::kGga:
+    case SentenceHandler::kGsa:
+    case SentenceHandler::kNotRelevant:
+    case SentenceHandler::kUnsupported:
+        break;
+    }
+    why = RejectReason::kUnknownType;
+    return false;
+}
+
+const char* reject_reason_name(RejectReason r)
+{
+    static constexpr const char* kNames[kRejectReasonCount] = {
+        "none", "incomplete", "checksum_mismatch", "unknown_type", "field_count",
+        "void_status", "empty_time", "bad_time", "bad_date", "bad_hemisphere",
+        "bad_coordinate",
+    };
+    const auto i = static_cast<std::size_t>(r);
+    return i < kRejectReasonCount ? kNames[i] : kNames[0];
+}
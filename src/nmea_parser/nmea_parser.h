@@ -5,20 +5,65 @@
 #ifndef NMEA_PARSER_H
 #define NMEA_PARSER_H
 
-#include "gpsd_config.h"
-#include "gpsd.h"
+#include "nmea_numeric.h"
+#include "sentence.h"
 
-#include <string>
-#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
 
-/// GPS record using gpsd types for coordinate/speed storage.
-///   - ntrip_stream_t holds latitude and longitude
-///   - gps_data_t     holds speed (via .fix.speed)
-///   - timestamp       is the HHMMSS.sss dedup key
+/// Compact GPS record produced by the parser and carried through dedup.
+/// Plain-old-data on purpose: records are copied in bulk by the dedup
+/// stages, so they hold only what the pipeline needs.  Conversion into the
+/// gpsd presentation structs happens in the output module (`to_gpsd`).
+/// Coordinates are fixed-point integers (kCoordUnitsPerDegree), so the
+/// degree jitter test and printing never round through a double and the
+/// record is 24 bytes.  Doubles are derived only for the metre metrics
+/// and the gpsd structs.
 struct GpsRecord {
-    std::string    timestamp;  // HHMMSS.sss — the unique dedup key
-    ntrip_stream_t stream;     // .latitude, .longitude (decimal degrees)
-    gps_data_t     gpsdata;    // .fix.speed (metres per second)
+    std::int64_t  timestamp_ms;  // UTC ms since the Unix epoch (RMC date + time) — the dedup key
+    std::int32_t  lat_e7;        // latitude, 1e-7 degree, +N / −S
+    std::int32_t  lon_e7;        // longitude, 1e-7 degree, +E / −W
+    float         speed;         // speed over ground, metres per second
+    std::uint32_t track = 0;     // --track-by: route the record belongs to (fills the padding)
+
+    double latitude() const  { return static_cast<double>(lat_e7) / kCoordUnitsPerDegree; }
+    double longitude() const { return static_cast<double>(lon_e7) / kCoordUnitsPerDegree; }
+};
+
+/// Nearest whole number of coordinate units to `degrees` — for degree
+/// thresholds such as kSpatialEpsilon.
+constexpr std::int64_t coord_units(double degrees)
+{
+    const double scaled = degrees * kCoordUnitsPerDegree;
+    return static_cast<std::int64_t>(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+/// Milliseconds per UTC day.  `timestamp_ms % kMsPerDay` is the NMEA time
+/// of day, which is all GGA carries.
+inline constexpr std::int64_t kMsPerDay = 86'400'000;
+
+/// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's
+/// days_from_civil).  The date is not validated.
+std::int64_t days_from_civil(int y, int m, int d);
+
+/// Fix-quality fields of a $GPGGA / $GNGGA sentence.  Empty numeric
+/// fields decode as NaN (altitude, HDOP) or 0 (quality, satellites).
+struct GgaData {
+    std::int64_t  timestamp_ms;  // UTC time of day — joins the epoch's RMC
+    float         altitude_m;    // antenna altitude above mean sea level
+    float         hdop;          // horizontal dilution of precision
+    std::uint8_t  fix_quality;   // 0 = invalid, 1 = GPS, 2 = DGPS, 4/5 = RTK …
+    std::uint8_t  satellites;    // satellites used in the fix
+};
+
+/// Dilution-of-precision fields of a $GPGSA / $GNGSA sentence.  GSA
+/// carries no time; it belongs to the epoch of the preceding GGA.
+struct GsaData {
+    float         pdop;          // NaN when empty
+    float         hdop;
+    float         vdop;
+    std::uint8_t  fix_type;      // 1 = none, 2 = 2D, 3 = 3D (0 if empty)
 };
 
 /// Tri-state result for checksum verification.
@@ -28,16 +73,74 @@ enum class ChecksumResult {
     kMismatch       // well-formed but the checksum value doesn't match
 };
 
+/// Why a line was rejected.  kChecksumMismatch is what the summary
+/// reports as a checksum failure; every other reason is part of its
+/// parse/validation failures.
+enum class RejectReason : std::uint8_t {
+    kNone,              // not rejected
+    kIncomplete,        // missing '$', '*' or checksum digits
+    kChecksumMismatch,  // well-formed, wrong checksum
+    kUnknownType,       // unrecognised talker or sentence type
+    kFieldCount,        // too few fields for the type
+    kVoidStatus,        // RMC status not 'A' (no fix)
+    kEmptyTime,         // time field empty
+    kBadTime,           // time field malformed or out of range
+    kBadDate,           // date field present but malformed
+    kBadHemisphere,     // N/S or E/W field not a single character
+    kBadCoordinate,     // latitude or longitude unreadable
+};
+
+inline constexpr std::size_t kRejectReasonCount = 11;   // including kNone
+
+/// "incomplete", "void_status", … ("none" for kNone).
+const char* reject_reason_name(RejectReason r);
+
 /// Pass 1 — verify NMEA checksum ($…*HH).
 /// Distinguishes structurally incomplete lines from genuine checksum mismatches.
-ChecksumResult verify_checksum(const std::string& sentence);
+/// Takes a view so callers can pass lines straight from a read buffer;
+/// none of the functions below allocate.
+ChecksumResult verify_checksum(std::string_view sentence);
+
+/// Batch form of `verify_checksum`: results[i] = verify_checksum(sentences[i])
+/// for i in [0, count).  Amortises kernel dispatch and prefetches ahead.
+void verify_checksum_batch(const std::string_view* sentences, std::size_t count,
+                           ChecksumResult* results);
 
 /// Return true if the sentence ID is a known-but-unsupported type
 /// ($GPGGA, $GPGSA and their $GN multi-constellation variants).
-bool is_not_relevant(const std::string& sentence);
+/// Shorthand for sentence_handler(classify_sentence(s)) == kNotRelevant.
+bool is_not_relevant(std::string_view sentence);
 
 /// Pass 2 — parse a $GPRMC / $GNRMC sentence that already passed the
 /// checksum.  Returns true and fills `out` on success; false otherwise.
-bool parse_gprmc(const std::string& sentence, GpsRecord& out);
+/// The timestamp combines the date field (DDMMYY, YY < 80 → 20YY) with
+/// the time; an empty or absent date leaves it a time of day on
+/// 1970-01-01, a malformed one fails the sentence.
+bool parse_gprmc(std::string_view sentence, GpsRecord& out);
+
+/// Decode a checksum-verified GGA sentence (GP or GN talker).  False if
+/// the ID, field count or time are invalid.
+bool parse_gga(std::string_view sentence, GgaData& out);
+
+/// As above, setting `why` on failure.
+bool parse_gga(std::string_view sentence, GgaData& out, RejectReason& why);
+
+/// Decode a checksum-verified GSA sentence (GP or GN talker).  False if
+/// the ID or field count are invalid.
+bool parse_gsa(std::string_view sentence, GsaData& out);
+
+/// As above, setting `why` on failure.
+bool parse_gsa(std::string_view sentence, GsaData& out, RejectReason& why);
+
+/// Pass 2 for a sentence already classified by `sentence_handler`: runs
+/// the per-type parser without re-checking the ID.  Returns true and
+/// fills `out` when the sentence yields a record.
+bool dispatch_sentence(std::string_view sentence, SentenceHandler handler,
+                       GpsRecord& out);
+
+/// As above, setting `why` to the first check the sentence failed
+/// (kUnknownType for a handler that yields no record).
+bool dispatch_sentence(std::string_view sentence, SentenceHandler handler,
+                       GpsRecord& out, RejectReason& why);
 
 #endif // NMEA_PARSER_H
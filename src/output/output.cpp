@@ -1,25 +1,274 @@
 /*
- * output.cpp — route URL generation
+ * output.cpp — Buffered fd output and route URL generation
  */
 
 #include "output.h"
 
-#include <iomanip>
-#include <sstream>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 // ─── Output constants ──────────────────────────────────────────────────────
 
 static constexpr int         kCoordPrecision   = 6;
 static constexpr const char* kGoogleMapsBase   = "https://www.google.com/maps/dir";
+static constexpr std::size_t kNumberChars      = 32;    // any coordinate, speed or count
+static constexpr std::size_t kMaxFixedChars    = 330;   // DBL_MAX in fixed notation
+static constexpr int         kFastMaxPrecision = 9;
+static constexpr double      kFastMaxScaled    = 1099511627776.0;   // 2^40
+static constexpr double      kFastTieGuard     = 1.0 / 4096;        // ≫ scaling error below 2^40
+static constexpr int         kCoordDigits      = 7;                 // decimals of a coordinate unit
+static_assert(kCoordUnitsPerDegree == 10'000'000, "kCoordDigits must match the unit");
+
+// ─── Internal helpers ───────────────────────────────────────────────────────
+
+/// Fixed-notation formatting of small values without to_chars' general
+/// algorithm: scale by 10^precision, round, print the integer with a
+/// decimal point.  Below 2^40 the scaled value is off by at most 2^-13
+/// from the exact product, so unless it lies within kFastTieGuard of a
+/// rounding tie the rounding matches printf/to_chars exactly.  Returns
+/// nullptr (caller falls back) for anything else.
+static char* format_fixed_fast(char* p, double value, int precision)
+{
+    static constexpr double kPow10[kFastMaxPrecision + 1] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+    if (precision < 0 || precision > kFastMaxPrecision)
+        return nullptr;
+    const bool   negative = std::signbit(value);
+    const double scaled   = std::fabs(value) * kPow10[precision];
+    if (!(scaled < kFastMaxScaled))   // also rejects NaN / inf
+        return nullptr;
+    const double whole = std::floor(scaled);
+    const double frac  = scaled - whole;
+    if (std::fabs(frac - 0.5) < kFastTieGuard)
+        return nullptr;
+
+    std::uint64_t q   = static_cast<std::uint64_t>(whole) + (frac > 0.5);
+    const auto    div = static_cast<std::uint64_t>(kPow10[precision]);
+    if (negative)
+        *p++ = '-';
+    p = std::to_chars(p, p + kNumberChars, q / div).ptr;
+    if (precision > 0) {
+        *p++ = '.';
+        q %= div;
+        for (int i = precision - 1; i >= 0; --i, q /= 10)
+            p[i] = static_cast<char>('0' + q % 10);
+        p += precision;
+    }
+    return p;
+}
+
+/// Fixed notation of the coordinate `units` (1e-7 degree) with
+/// `precision` decimals (at most kCoordDigits), rounded half away from
+/// zero, by integer arithmetic alone.  A negative value keeps its sign
+/// even when it rounds to zero, as printf does.
+static char* format_coord(char* p, std::int32_t units, int precision)
+{
+    static constexpr std::uint32_t kPow10[kCoordDigits + 1] = {
+        1, 10, 100, 1'000, 10'000, 100'000, 1'000'000, 10'000'000};
+    precision = std::clamp(precision, 0, kCoordDigits);
+    const std::uint32_t drop = kPow10[kCoordDigits - precision];
+    const std::uint32_t div  = kPow10[precision];
+    std::uint64_t q = units < 0 ? 0 - static_cast<std::uint64_t>(static_cast<std::int64_t>(units))
+                                : static_cast<std::uint64_t>(units);
+    q = (q + drop / 2) / drop;
+    if (units < 0)
+        *p++ = '-';
+    p = std::to_chars(p, p + kNumberChars, q / div).ptr;
+    if (precision > 0) {
+        *p++ = '.';
+        q %= div;
+        for (int i = precision - 1; i >= 0; --i, q /= 10)
+            p[i] = static_cast<char>('0' + q % 10);
+        p += precision;
+    }
+    return p;
+}
+
+/// Append "/lat,lon" for `pt` at `p` (at least 2 * kNumberChars + 2 free).
+static char* format_waypoint(char* p, const GpsRecord& pt)
+{
+    *p++ = '/';
+    p = format_coord(p, pt.lat_e7, kCoordPrecision);
+    *p++ = ',';
+    return format_coord(p, pt.lon_e7, kCoordPrecision);
+}
+
+/// Write all of `data` to `fd`, retrying short writes and EINTR.
+static bool write_all(int fd, const char* data, std::size_t size)
+{
+    while (size > 0) {
+#if defined(_WIN32)
+        const int n = ::_write(fd, data, static_cast<unsigned>(std::min<std::size_t>(size, 1u << 30)));
+#else
+        const ssize_t n = ::write(fd, data, size);
+#endif
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// ─── Public API ─────────────────────────────────────────────────────────────
+
+void to_gpsd(const GpsRecord& rec, ntrip_stream_t& stream, gps_data_t& gpsdata)
+{
+    stream.latitude       = rec.latitude();
+    stream.longitude      = rec.longitude();
+    gpsdata.fix.latitude  = rec.latitude();
+    gpsdata.fix.longitude = rec.longitude();
+    gpsdata.fix.speed     = rec.speed;
+    gpsdata.fix.time      = static_cast<timestamp_t>(rec.timestamp_ms) / 1000.0;
+}
 
 std::string build_google_maps_url(const std::vector<GpsRecord>& route)
 {
     if (route.empty()) return {};
 
-    std::ostringstream url;
-    url << std::fixed << std::setprecision(kCoordPrecision);
-    url << kGoogleMapsBase;
+    std::string url(kGoogleMapsBase);
+    char buf[2 * kNumberChars + 2];
     for (const auto& pt : route)
-        url << '/' << pt.stream.latitude << ',' << pt.stream.longitude;
-    return url.str();
+        url.append(buf, format_waypoint(buf, pt));
+    return url;
+}
+
+std::size_t google_maps_url_count(std::size_t points, std::size_t max_waypoints)
+{
+    if (points == 0)
+        return 0;
+    if (max_waypoints < 2 || points <= max_waypoints)
+        return 1;
+    // Each extra leg re-uses the previous leg's last point.
+    return (points - 2) / (max_waypoints - 1) + 1;
+}
+
+std::size_t write_google_maps_urls(FdWriter& out, const std::vector<GpsRecord>& route,
+                                   std::size_t max_waypoints)
+{
+    const std::size_t urls = google_maps_url_count(route.size(), max_waypoints);
+    const std::size_t step = urls > 1 ? max_waypoints - 1 : route.size();
+    for (std::size_t u = 0; u < urls; ++u) {
+        const std::size_t first = u * step;
+        const std::size_t last  = std::min(route.size(), first + step + 1);
+        out.write(kGoogleMapsBase);
+        char buf[2 * kNumberChars + 2];
+        for (std::size_t i = first; i < last; ++i)
+            out.write({buf, static_cast<std::size_t>(
+                                format_waypoint(buf, route[i]) - buf)});
+        out.put('\n');
+    }
+    return urls;
+}
+
+// ─── FdWriter ───────────────────────────────────────────────────────────────
+
+FdWriter::FdWriter(int fd, std::size_t capacity)
+    : fd_(fd), buf_(std::max(capacity, kMaxFixedChars + kNumberChars))
+{
+}
+
+FdWriter::~FdWriter()
+{
+    flush();
+}
+
+char* FdWriter::reserve(std::size_t n)
+{
+    if (buf_.size() - len_ < n)
+        flush();
+    if (buf_.size() < n)
+        buf_.resize(n);
+    return buf_.data() + len_;
+}
+
+void FdWriter::pad(std::size_t start, std::size_t width)
+{
+    const std::size_t used = len_ - start;
+    if (used >= width)
+        return;
+    char* p = reserve(width - used);
+    std::memset(p, ' ', width - used);
+    len_ += width - used;
+}
+
+void FdWriter::write(std::string_view text, std::size_t width)
+{
+    if (text.size() > buf_.size() - len_) {
+        flush();
+        if (text.size() > buf_.size()) {
+            ok_ = write_all(fd_, text.data(), text.size()) && ok_;
+            pad(len_, width > text.size() ? width - text.size() : 0);
+            return;
+        }
+    }
+    const std::size_t start = len_;
+    std::memcpy(buf_.data() + len_, text.data(), text.size());
+    len_ += text.size();
+    pad(start, width);
+}
+
+void FdWriter::put(char c)
+{
+    *reserve(1) = c;
+    ++len_;
+}
+
+void FdWriter::number(std::size_t value, std::size_t width)
+{
+    char* p = reserve(kNumberChars + width);
+    const std::size_t start = len_;
+    len_ += static_cast<std::size_t>(std::to_chars(p, p + kNumberChars, value).ptr - p);
+    pad(start, width);
+}
+
+void FdWriter::coord(std::int32_t units, int precision, std::size_t width)
+{
+    char* p = reserve(kNumberChars + width);
+    const std::size_t start = len_;
+    len_ += static_cast<std::size_t>(format_coord(p, units, precision) - p);
+    pad(start, width);
+}
+
+void FdWriter::fixed(double value, int precision, std::size_t width)
+{
+    char* p = reserve(kNumberChars + width);
+    if (char* end = format_fixed_fast(p, value, precision)) {
+        const std::size_t start = len_;
+        len_ += static_cast<std::size_t>(end - p);
+        pad(start, width);
+        return;
+    }
+    auto r = std::to_chars(p, p + kNumberChars, value, std::chars_format::fixed, precision);
+    if (r.ec == std::errc::value_too_large) {
+        p = reserve(kMaxFixedChars + static_cast<std::size_t>(precision) + width);
+        r = std::to_chars(p, buf_.data() + buf_.size(), value, std::chars_format::fixed,
+                          precision);
+    }
+    const std::size_t start = len_;
+    len_ += static_cast<std::size_t>(r.ptr - p);
+    pad(start, width);
+}
+
+bool FdWriter::flush()
+{
+    if (len_ > 0) {
+        ok_ = write_all(fd_, buf_.data(), len_) && ok_;
+        len_ = 0;
+    }
+    return ok_;
 }
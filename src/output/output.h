@@ -1,16 +1,80 @@
 /*
- * output.h — GPS struct access and route URL generation
+ * output.h — GPS struct access, buffered fd output and route URL generation
  */
 
 #ifndef OUTPUT_H
 #define OUTPUT_H
 
 #include "nmea_parser.h"
+#include "gpsd_config.h"
+#include "gpsd.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
+/// FdWriter buffer size.
+inline constexpr std::size_t kOutputBufferBytes = 64u << 10;   // 64 KiB
+
+/// Waypoints Google Maps accepts in one /dir/ URL — the value to pass to
+/// --url-waypoints when the URLs are meant to be opened.
+inline constexpr std::size_t kGoogleMapsMaxWaypoints = 25;
+
+/// Presentation edge: copy a compact record into the gpsd structs —
+/// latitude/longitude into `ntrip_stream_t`, speed and time (Unix
+/// seconds) into `gps_data_t.fix`.
+void to_gpsd(const GpsRecord& rec, ntrip_stream_t& stream, gps_data_t& gpsdata);
+
+/// Buffered writer straight to a file descriptor.  Numbers are formatted
+/// with std::to_chars into the buffer itself, so a row costs no iostream
+/// state, locale lookups or temporary strings.  Every call takes an
+/// optional field `width`: the value is left-aligned and space-padded to
+/// it, as `std::left << std::setw(width)` would.  Anything buffered in
+/// std::cout must be flushed before writing to the same fd.
+class FdWriter {
+public:
+    explicit FdWriter(int fd, std::size_t capacity = kOutputBufferBytes);
+    ~FdWriter();
+
+    FdWriter(const FdWriter&)            = delete;
+    FdWriter& operator=(const FdWriter&) = delete;
+
+    void write(std::string_view text, std::size_t width = 0);
+    void put(char c);
+    void number(std::size_t value, std::size_t width = 0);
+    void fixed(double value, int precision, std::size_t width = 0);
+
+    /// A coordinate in 1e-7 degree units with `precision` (≤ 7) decimals,
+    /// formatted from the integer: no double rounding.
+    void coord(std::int32_t units, int precision, std::size_t width = 0);
+
+    /// Write out the buffer.  Returns false once any write has failed.
+    bool flush();
+    bool ok() const { return ok_; }
+
+private:
+    char* reserve(std::size_t n);
+    void  pad(std::size_t start, std::size_t width);
+
+    int               fd_;
+    std::vector<char> buf_;
+    std::size_t       len_ = 0;
+    bool              ok_  = true;
+};
+
 /// Build a Google Maps directions URL from an ordered list of waypoints.
 std::string build_google_maps_url(const std::vector<GpsRecord>& route);
 
+/// Number of URLs `write_google_maps_urls` produces for `points` waypoints.
+std::size_t google_maps_url_count(std::size_t points, std::size_t max_waypoints);
+
+/// Write the route as Google Maps directions URLs, one per line.  With
+/// `max_waypoints` ≥ 2 a longer route is split into legs of at most that
+/// many points, each starting at the point where the previous one ended;
+/// 0 writes a single URL.  Returns the number of URLs written.
+std::size_t write_google_maps_urls(FdWriter& out, const std::vector<GpsRecord>& route,
+                                   std::size_t max_waypoints);
+
 #endif // OUTPUT_H
@@ -0,0 +1,44 @@
+/*
+ * parallel.cpp — Minimal fork/join helper for independent work items
+ */
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+unsigned resolve_jobs(unsigned requested)
+{
+    if (requested == 0)
+        requested = std::thread::hardware_concurrency();
+    return std::max(requested, 1u);
+}
+
+void parallel_for(std::size_t count, unsigned jobs,
+                  const std::function<void(std::size_t)>& task)
+{
+    const auto workers = static_cast<std::size_t>(
+        std::min<std::size_t>(jobs, count));
+    if (workers <= 1) {
+        for (std::size_t i = 0; i < count; ++i)
+            task(i);
+        return;
+    }
+
+    std::atomic<std::size_t> next{0};
+    auto worker = [&] {
+        for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count; )
+            task(i);
+    };
+
+    // The calling thread is one of the workers.
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (std::size_t t = 1; t < workers; ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool)
+        th.join();
+}
@@ -0,0 +1,22 @@
+/*
+ * parallel.h — Minimal fork/join helper for independent work items
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+/// Resolve a user-supplied job count: 0 means "one per hardware thread".
+/// Always returns at least 1.
+unsigned resolve_jobs(unsigned requested);
+
+/// Run `task(i)` for every i in [0, count) on up to `jobs` threads.
+/// Work items are handed out dynamically, so uneven items balance out.
+/// Blocks until every item has finished.  With `jobs <= 1` (or a single
+/// item) everything runs on the calling thread.
+void parallel_for(std::size_t count, unsigned jobs,
+                  const std::function<void(std::size_t)>& task);
+
+#endif // PARALLEL_H
@@ -0,0 +1,21 @@
+/*
+ * pipeline.cpp — Compile-time configurable line → route pipeline
+ */
+
+#include "pipeline.h"
+
+// ─── Public API ─────────────────────────────────────────────────────────────
+
+PipelineCounters& PipelineCounters::operator+=(const PipelineCounters& other)
+{
+    lines          += other.lines;
+    skipped        += other.skipped;
+    checksum_fail  += other.checksum_fail;
+    parse_fail     += other.parse_fail;
+    records        += other.records;
+    late_dropped   += other.late_dropped;
+    future_dropped += other.future_dropped;
+    after_lww      += other.after_lww;
+    route_points   += other.route_points;
+    return *this;
+}
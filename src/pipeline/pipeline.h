@@ -0,0 +1,479 @@
+/*
+ * pipeline.h — Compile-time configurable line → route pipeline
+ *
+ * Pipeline<Config, Sink> chains the per-record stages — talker/type
+ * acceptance, checksum, RMC decode, temporal dedup and spatial dedup —
+ * into one inlined loop body ending in `Sink`.  The policy is a type:
+ *
+ *   - A config whose knobs are all `static constexpr` members (an empty
+ *     class) fixes them at compile time.  Stages it switches off are not
+ *     compiled in, their state is not even a member, and the checks that
+ *     remain test constants.  This is the stripped-down build for
+ *     embedded edge units (EdgePipelineConfig).
+ *   - A config that carries the same knobs as data members
+ *     (RuntimePipelineConfig) is read at run time.  The CLI's streaming
+ *     route stage is this instantiation.
+ *
+ * Both kinds name the knobs identically, so the pipeline reads them as
+ * `config.name` either way.  The parsers themselves (classify_sentence,
+ * verify_checksum_batch, dispatch_sentence) stay out of line, and each
+ * line is judged by ingest's check_line, so a line fares here as it does
+ * in every ingest path; what is inlined is the glue between them.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "dedup.h"
+#include "ingest.h"
+#include "nmea_parser.h"
+#include "reader.h"
+#include "sentence.h"
+#include "spatial.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// Set of talkers, one bit per Talker enumerator.
+using TalkerMask = std::uint32_t;
+
+constexpr TalkerMask talker_bit(Talker t)
+{
+    return TalkerMask{1} << static_cast<unsigned>(t);
+}
+
+/// The talkers whose RMC sentences the CLI accepts ($GPRMC, $GNRMC).
+inline constexpr TalkerMask kDefaultRmcTalkers = talker_bit(Talker::kGP) | talker_bit(Talker::kGN);
+
+/// Temporal dedup strategy.
+enum class TemporalDedup : std::uint8_t {
+    kOff,        // every record goes on to the spatial stage
+    kLatest,     // emit on arrival; drop records not newer than the last
+                 // emitted (StreamingDedup with a 0 ms window, no buffer)
+    kWindowed,   // StreamingDedup with `window_ms`
+};
+
+/// Knobs every config provides, as `static constexpr` members
+/// (compile-time config) or data members (runtime config):
+///
+///   TalkerMask     talkers          RMC talkers accepted
+///   bool           verify_checksum  check "*HH" before decoding
+///   ChecksumPolicy checksum         kAll, or kRelevant to skip the checksum
+///                                   of discarded types (--fast-reject)
+///   std::size_t    checksum_batch   lines per verify_checksum_batch pass in
+///                                   feed() (at most kMaxChecksumBatch)
+///   TemporalDedup  temporal         temporal dedup strategy
+///   std::int64_t   window_ms        kWindowed reorder window
+///   bool           spatial_dedup    run the spatial filter
+///   SpatialOptions spatial          its metric and thresholds, epsilon_deg /
+///                                   epsilon_m included (simplify ignored)
+
+/// Largest checksum batch; a runtime config's batch is clamped to it.
+inline constexpr std::size_t kMaxChecksumBatch = 256;
+
+/// Runtime instantiation: the knobs are set per run (from the CLI).
+struct RuntimePipelineConfig {
+    TalkerMask     talkers         = kDefaultRmcTalkers;
+    bool           verify_checksum = true;
+    ChecksumPolicy checksum        = ChecksumPolicy::kAll;
+    std::size_t    checksum_batch  = kDefaultChecksumBatch;
+    TemporalDedup  temporal        = TemporalDedup::kWindowed;
+    std::int64_t   window_ms       = kDefaultReorderWindowMs;
+    bool           spatial_dedup   = true;
+    SpatialOptions spatial;
+};
+
+/// Compile-time twin of the CLI's streaming defaults.
+struct DefaultPipelineConfig {
+    static constexpr TalkerMask     talkers         = kDefaultRmcTalkers;
+    static constexpr bool           verify_checksum = true;
+    static constexpr ChecksumPolicy checksum        = ChecksumPolicy::kAll;
+    static constexpr std::size_t    checksum_batch  = kDefaultChecksumBatch;
+    static constexpr TemporalDedup  temporal        = TemporalDedup::kWindowed;
+    static constexpr std::int64_t   window_ms       = kDefaultReorderWindowMs;
+    static constexpr bool           spatial_dedup   = true;
+    static constexpr SpatialOptions spatial{};
+};
+
+/// Edge units (nmea_edge): GP/GN RMC only, checksums of discarded types
+/// skipped, emit-on-arrival dedup and the degree jitter filter — no
+/// reorder buffer, no allocation after start-up.
+struct EdgePipelineConfig {
+    static constexpr TalkerMask     talkers         = kDefaultRmcTalkers;
+    static constexpr bool           verify_checksum = true;
+    static constexpr ChecksumPolicy checksum        = ChecksumPolicy::kRelevant;
+    static constexpr std::size_t    checksum_batch  = kDefaultChecksumBatch;
+    static constexpr TemporalDedup  temporal        = TemporalDedup::kLatest;
+    static constexpr std::int64_t   window_ms       = 0;
+    static constexpr bool           spatial_dedup   = true;
+    static constexpr SpatialOptions spatial{};
+};
+
+/// True when `Config` fixes its knobs at compile time.
+template <typename Config>
+inline constexpr bool kCompileTimeConfig = std::is_empty_v<Config>;
+
+/// Line and record outcomes of one Pipeline.
+struct PipelineCounters {
+    std::size_t lines          = 0;   // non-empty lines offered
+    std::size_t skipped        = 0;   // not relevant, or not an accepted talker's RMC
+    std::size_t checksum_fail  = 0;
+    std::size_t parse_fail     = 0;   // incomplete, unsupported or failed the RMC decode
+    std::size_t records        = 0;   // decoded (or pushed) records
+    std::size_t late_dropped   = 0;   // temporal dedup: arrived after a newer one was emitted
+    std::size_t future_dropped = 0;   // temporal dedup: unconfirmed far-future outliers
+    std::size_t after_lww      = 0;   // records past temporal dedup
+    std::size_t route_points   = 0;   // records handed to the sink
+
+    PipelineCounters& operator+=(const PipelineCounters& other);
+};
+
+/// Everything a Pipeline has accumulated, saved by --checkpoint so a
+/// later run carries on where this one stopped.  The config and the sink
+/// are not part of it.
+struct PipelineState {
+    PipelineCounters    counters;
+    StreamingDedupState window;               // TemporalDedup::kWindowed
+    bool                has_latest   = false;   // TemporalDedup::kLatest
+    std::int64_t        latest_ms    = 0;
+    bool                has_ahead    = false;   // kLatest: unconfirmed far-ahead record
+    GpsRecord           latest_ahead{};
+    bool                has_last     = false;   // spatial stage: last kept point
+    GpsRecord           last{};
+};
+
+/// Appends every route point to a vector.
+struct VectorSink {
+    std::vector<GpsRecord>* out;
+
+    void operator()(const GpsRecord& rec) const { out->push_back(rec); }
+};
+
+/// Lines (or already-decoded records) in, route points out to `Sink`, a
+/// callable taking `const GpsRecord&`.  Not copyable: the windowed dedup
+/// stage calls back into the pipeline.
+template <typename Config, typename Sink>
+class Pipeline {
+    // Which stages exist.  A runtime config may switch on any of them.
+    static constexpr bool kChecksumStage = [] {
+        if constexpr (kCompileTimeConfig<Config>) return Config::verify_checksum;
+        else return true;
+    }();
+    static constexpr bool kLatestStage = [] {
+        if constexpr (kCompileTimeConfig<Config>) return Config::temporal == TemporalDedup::kLatest;
+        else return true;
+    }();
+    static constexpr bool kWindowedStage = [] {
+        if constexpr (kCompileTimeConfig<Config>) return Config::temporal == TemporalDedup::kWindowed;
+        else return true;
+    }();
+    static constexpr bool kSpatialStage = [] {
+        if constexpr (kCompileTimeConfig<Config>) return Config::spatial_dedup;
+        else return true;
+    }();
+    // A compile-time degree filter is inlined; anything else is a RouteFilter.
+    static constexpr bool kInlineDegrees = [] {
+        if constexpr (kCompileTimeConfig<Config>)
+            return Config::spatial_dedup && Config::spatial.metric == SpatialMetric::kDegrees;
+        else return false;
+    }();
+    static constexpr bool kRouteFilterStage = kSpatialStage && !kInlineDegrees;
+    // feed()'s batch arrays: exactly the batch when it is a constant.
+    static constexpr std::size_t kBatchCapacity = [] {
+        if constexpr (kCompileTimeConfig<Config>) return Config::checksum_batch;
+        else return kMaxChecksumBatch;
+    }();
+    static_assert(kBatchCapacity >= 1 && kBatchCapacity <= kMaxChecksumBatch,
+                  "checksum_batch must be in [1, kMaxChecksumBatch]");
+
+    struct NoStage {};
+    struct LatestState {
+        bool         has_emitted = false;
+        std::int64_t last_ms     = 0;
+        bool         has_ahead   = false;   // unconfirmed far-ahead record
+        GpsRecord    ahead{};
+    };
+    struct DegreeState {
+        bool      has_last = false;
+        GpsRecord last{};
+    };
+
+public:
+    explicit Pipeline(Sink sink, Config config = {})
+        : config_(std::move(config)), sink_(std::move(sink))
+    {
+        if constexpr (kWindowedStage)
+            if (config_.temporal == TemporalDedup::kWindowed)
+                lww_.emplace(config_.window_ms, [this](const GpsRecord& rec) { spatial(rec); });
+        if constexpr (kRouteFilterStage)
+            if (config_.spatial_dedup)
+                filter_.emplace(config_.spatial);
+    }
+
+    Pipeline(const Pipeline&)            = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    /// Run one line through every stage.  Returns true if it decoded to
+    /// a record (which may still be deduplicated away).  Empty lines are
+    /// ignored.
+    bool line(std::string_view line)
+    {
+        if (line.empty())
+            return false;
+        ++counters_.lines;
+        const SentenceHandler handler = classify(line);
+        ChecksumResult verdict = ChecksumResult::kOk;
+        if constexpr (kChecksumStage)
+            if (needs_checksum(handler))
+                verdict = verify_checksum(line);
+        return finish(line, handler, verdict);
+    }
+
+    /// Run every line of `buf` (the last may lack its '\n'), verifying
+    /// checksums checksum_batch lines at a time.
+    void feed(std::string_view buf)
+    {
+        std::array<std::string_view, kBatchCapacity> lines;
+        std::array<SentenceHandler, kBatchCapacity>  handlers;
+        std::array<ChecksumResult, kBatchCapacity>   verdicts;
+        std::array<std::string_view, kBatchCapacity> checked;
+        std::array<std::size_t, kBatchCapacity>      checked_at;
+        std::array<ChecksumResult, kBatchCapacity>   checked_verdicts;
+        const std::size_t batch = std::clamp<std::size_t>(config_.checksum_batch, 1, kBatchCapacity);
+
+        LineCursor cursor(buf);
+        bool more = true;
+        while (more) {
+            std::size_t n = 0;
+            std::string_view text;
+            while (n < batch && (more = cursor.next(text)))
+                if (!text.empty())
+                    lines[n++] = text;
+            counters_.lines += n;
+
+            std::size_t verify = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                handlers[i] = classify(lines[i]);
+                verdicts[i] = ChecksumResult::kOk;
+                if constexpr (kChecksumStage) {
+                    if (needs_checksum(handlers[i])) {
+                        checked[verify]      = lines[i];
+                        checked_at[verify++] = i;
+                    }
+                }
+            }
+            if constexpr (kChecksumStage) {
+                verify_checksum_batch(checked.data(), verify, checked_verdicts.data());
+                for (std::size_t k = 0; k < verify; ++k)
+                    verdicts[checked_at[k]] = checked_verdicts[k];
+            }
+            for (std::size_t i = 0; i < n; ++i)
+                finish(lines[i], handlers[i], verdicts[i]);
+        }
+    }
+
+    /// Enter an already-decoded record at the temporal dedup stage.
+    void push(const GpsRecord& rec)
+    {
+        ++counters_.records;
+        if constexpr (kWindowedStage) {
+            if (lww_) {
+                lww_->push(rec);
+                counters_.late_dropped   = lww_->late_dropped();
+                counters_.future_dropped = lww_->future_dropped();
+                return;
+            }
+        }
+        if constexpr (kLatestStage) {
+            if (config_.temporal == TemporalDedup::kLatest) {
+                latest(rec);
+                return;
+            }
+        }
+        spatial(rec);
+    }
+
+    /// End of input: release what temporal dedup still holds.
+    void flush()
+    {
+        if constexpr (kWindowedStage) {
+            if (lww_)
+                lww_->flush();
+        }
+        if constexpr (kLatestStage) {
+            if (latest_.has_ahead) {   // nothing contradicted it
+                latest_.has_ahead = false;
+                release_latest(latest_.ahead);
+            }
+        }
+    }
+
+    const PipelineCounters& counters() const { return counters_; }
+    const Config&           config()   const { return config_; }
+
+    /// Snapshot of every stage (take it before flush()), or restore one
+    /// taken under the same config.  Nothing reaches the sink either way.
+    PipelineState state() const
+    {
+        PipelineState s;
+        s.counters = counters_;
+        if constexpr (kWindowedStage) {
+            if (lww_)
+                s.window = lww_->state();
+        }
+        if constexpr (kLatestStage) {
+            s.has_latest   = latest_.has_emitted;
+            s.latest_ms    = latest_.last_ms;
+            s.has_ahead    = latest_.has_ahead;
+            s.latest_ahead = latest_.ahead;
+        }
+        if constexpr (kInlineDegrees) {
+            s.has_last = degrees_.has_last;
+            s.last     = degrees_.last;
+        } else if constexpr (kRouteFilterStage) {
+            if (filter_ && filter_->has_last()) {
+                s.has_last = true;
+                s.last     = filter_->last();
+            }
+        }
+        return s;
+    }
+
+    void restore(const PipelineState& s)
+    {
+        counters_ = s.counters;
+        if constexpr (kWindowedStage) {
+            if (lww_)
+                lww_->restore(s.window);
+        }
+        if constexpr (kLatestStage) {
+            latest_.has_emitted = s.has_latest;
+            latest_.last_ms     = s.latest_ms;
+            latest_.has_ahead   = s.has_ahead;
+            latest_.ahead       = s.latest_ahead;
+        }
+        if constexpr (kInlineDegrees) {
+            degrees_.has_last = s.has_last;
+            degrees_.last     = s.last;
+        } else if constexpr (kRouteFilterStage) {
+            if (filter_ && s.has_last)
+                filter_->resume(s.last);
+        }
+    }
+
+private:
+    /// The line's handler, with RMCs of talkers outside `talkers` turned
+    /// into discarded lines.
+    SentenceHandler classify(std::string_view line) const
+    {
+        const SentenceId      id      = classify_sentence(line);
+        const SentenceHandler handler = sentence_handler(id);
+        return handler == SentenceHandler::kRmc && !(config_.talkers & talker_bit(id.talker))
+            ? SentenceHandler::kNotRelevant : handler;
+    }
+
+    bool needs_checksum(SentenceHandler handler) const
+    {
+        return config_.verify_checksum && !(config_.checksum == ChecksumPolicy::kRelevant &&
+                                            handler == SentenceHandler::kNotRelevant);
+    }
+
+    /// Judge a classified, checked line as ingest does, then decode it.
+    bool finish(std::string_view line, SentenceHandler handler, ChecksumResult verdict)
+    {
+        switch (check_line(handler, verdict, config_.checksum)) {
+        case LineCheck::kParse:
+            break;
+        case LineCheck::kNotRelevant:
+            ++counters_.skipped;
+            return false;
+        case LineCheck::kIncomplete:
+            ++counters_.parse_fail;
+            return false;
+        case LineCheck::kChecksumMismatch:
+            ++counters_.checksum_fail;
+            return false;
+        }
+        GpsRecord rec{};
+        if (!dispatch_sentence(line, handler, rec)) {
+            ++counters_.parse_fail;
+            return false;
+        }
+        push(rec);
+        return true;
+    }
+
+    // kLatest: StreamingDedup's rules at a 0 ms window, with no buffer
+    // beyond the one far-ahead record waiting for confirmation.
+    void latest(const GpsRecord& rec)
+    {
+        constexpr std::int64_t lead = max_lead_ms(0);
+        const std::int64_t     key  = rec.timestamp_ms;
+        if (latest_.has_emitted && key <= latest_.last_ms) {
+            ++counters_.late_dropped;
+            return;
+        }
+        if (latest_.has_emitted && key - latest_.last_ms > lead) {
+            const std::int64_t ahead = latest_.ahead.timestamp_ms;
+            if (latest_.has_ahead && key - ahead <= lead && ahead - key <= lead) {
+                latest_.has_ahead = false;
+                if (ahead < key)
+                    release_latest(latest_.ahead);
+                release_latest(rec);
+                if (key < ahead)
+                    release_latest(latest_.ahead);
+            } else {
+                counters_.future_dropped += latest_.has_ahead;
+                latest_.has_ahead = true;
+                latest_.ahead     = rec;
+            }
+            return;
+        }
+        if (latest_.has_ahead) {   // the record after it fell back: an outlier
+            ++counters_.future_dropped;
+            latest_.has_ahead = false;
+        }
+        release_latest(rec);
+    }
+
+    void release_latest(const GpsRecord& rec)
+    {
+        latest_.has_emitted = true;
+        latest_.last_ms     = rec.timestamp_ms;
+        spatial(rec);
+    }
+
+    void spatial(const GpsRecord& rec)
+    {
+        ++counters_.after_lww;
+        if constexpr (kInlineDegrees) {
+            constexpr std::int64_t eps = coord_units(Config::spatial.epsilon_deg);
+            if (degrees_.has_last && within_units(rec, degrees_.last, eps))
+                return;
+            degrees_.has_last = true;
+            degrees_.last     = rec;
+        } else if constexpr (kRouteFilterStage) {
+            if (filter_ && !filter_->accept(rec))
+                return;
+        }
+        ++counters_.route_points;
+        sink_(rec);
+    }
+
+    Config           config_;
+    Sink             sink_;
+    PipelineCounters counters_;
+    std::conditional_t<kWindowedStage, std::optional<StreamingDedup>, NoStage> lww_;
+    std::conditional_t<kLatestStage, LatestState, NoStage>                    latest_;
+    std::conditional_t<kInlineDegrees, DegreeState, NoStage>                  degrees_;
+    std::conditional_t<kRouteFilterStage, std::optional<RouteFilter>, NoStage> filter_;
+};
+
+#endif // PIPELINE_H
@@ -0,0 +1,454 @@
+/*
+ * query.cpp — Time-window and bounding-box queries over a route
+ */
+
+#include "query.h"
+#include "reader.h"
+#include "route_io.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <system_error>
+
+// ─── Query constants ───────────────────────────────────────────────────────
+
+static constexpr std::int64_t kMsPerHour       = 3'600'000;
+static constexpr std::int64_t kMsPerMinute     = 60'000;
+static constexpr std::int64_t kMsPerSecond     = 1'000;
+static constexpr std::size_t  kIsoDateChars    = 10;   // YYYY-MM-DD
+static constexpr std::size_t  kMaxFracDigits   = 3;    // milliseconds
+static constexpr double       kMaxLatitudeDeg  = 90.0;
+static constexpr double       kMaxLongitudeDeg = 180.0;
+static constexpr std::size_t  kBoxFields       = 4;    // west, south, east, north
+
+namespace {
+
+// ─── Parsing helpers ────────────────────────────────────────────────────────
+
+/// Read `count` decimal digits of `text` at `pos` into `out`.
+bool fixed_digits(std::string_view text, std::size_t pos, std::size_t count, int& out)
+{
+    if (pos + count > text.size())
+        return false;
+    out = 0;
+    for (std::size_t i = pos; i < pos + count; ++i) {
+        if (text[i] < '0' || text[i] > '9')
+            return false;
+        out = out * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+/// Parse the whole of `text` as a signed decimal number.
+bool parse_degrees(std::string_view text, double& out)
+{
+    const char* last = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), last, out);
+    return ec == std::errc() && ptr == last && !text.empty();
+}
+
+// ─── Index file I/O ─────────────────────────────────────────────────────────
+
+template <typename T>
+void write_column(std::ofstream& out, const std::vector<T>& column)
+{
+    if constexpr (kBigEndianHost) {
+        for (const T& value : column) {
+            char bytes[sizeof(T)];
+            store_le(bytes, value);
+            out.write(bytes, sizeof bytes);
+        }
+    } else {
+        out.write(reinterpret_cast<const char*>(column.data()),
+                  static_cast<std::streamsize>(column.size() * sizeof(T)));
+    }
+}
+
+/// Copy `count` values from `p` into `column`; returns the end of them.
+template <typename T>
+const char* read_column(const char* p, std::size_t count, std::vector<T>& column)
+{
+    column.resize(count);
+    if constexpr (kBigEndianHost) {
+        for (std::size_t i = 0; i < count; ++i)
+            column[i] = load_le<T>(p + i * sizeof(T));
+    } else {
+        std::memcpy(column.data(), p, count * sizeof(T));
+    }
+    return p + count * sizeof(T);
+}
+
+bool fail(std::string& error, const std::string& path, const char* what)
+{
+    error = "'" + path + "': " + what;
+    return false;
+}
+
+} // namespace
+
+// ─── Parsing ────────────────────────────────────────────────────────────────
+
+bool parse_query_time(std::string_view text, std::int64_t& out)
+{
+    if (text.empty())
+        return false;
+    if (text.find('-', 1) == std::string_view::npos) {
+        const char* last = text.data() + text.size();
+        auto [ptr, ec] = std::from_chars(text.data(), last, out);
+        return ec == std::errc() && ptr == last;
+    }
+
+    // UTC ISO 8601.  A day is valid when it comes before the first of the
+    // next month, so no month-length table is needed.
+    int y = 0, m = 0, d = 0;
+    if (text.size() < kIsoDateChars || text[4] != '-' || text[7] != '-' ||
+        !fixed_digits(text, 0, 4, y) || !fixed_digits(text, 5, 2, m) ||
+        !fixed_digits(text, 8, 2, d) || m < 1 || m > 12 || d < 1)
+        return false;
+    const std::int64_t days = days_from_civil(y, m, d);
+    if (days >= days_from_civil(m == 12 ? y + 1 : y, m == 12 ? 1 : m + 1, 1))
+        return false;
+    std::int64_t ms = days * kMsPerDay;
+
+    std::size_t pos = kIsoDateChars;
+    if (pos < text.size()) {
+        int hh = 0, mm = 0, ss = 0;
+        if ((text[pos] != 'T' && text[pos] != ' ') || !fixed_digits(text, pos + 1, 2, hh) ||
+            pos + 3 >= text.size() || text[pos + 3] != ':' ||
+            !fixed_digits(text, pos + 4, 2, mm) || hh > 23 || mm > 59)
+            return false;
+        pos += 6;
+        if (pos < text.size() && text[pos] == ':') {
+            if (!fixed_digits(text, pos + 1, 2, ss) || ss > 59)
+                return false;
+            pos += 3;
+            if (pos < text.size() && text[pos] == '.') {
+                std::size_t digits = 0;
+                std::int64_t scale = kMsPerSecond;
+                for (++pos; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; ++pos) {
+                    if (++digits > kMaxFracDigits)
+                        return false;
+                    scale /= 10;
+                    ms += (text[pos] - '0') * scale;
+                }
+                if (digits == 0)
+                    return false;
+            }
+        }
+        if (pos < text.size() && text[pos] == 'Z')
+            ++pos;
+        if (pos != text.size())
+            return false;
+        ms += hh * kMsPerHour + mm * kMsPerMinute + ss * kMsPerSecond;
+    }
+    out = ms;
+    return true;
+}
+
+bool parse_geo_box(std::string_view text, GeoBox& out)
+{
+    double deg[kBoxFields];
+    for (std::size_t i = 0; i < kBoxFields; ++i) {
+        const std::size_t comma = i + 1 < kBoxFields ? text.find(',') : text.size();
+        if (comma == std::string_view::npos || !parse_degrees(text.substr(0, comma), deg[i]))
+            return false;
+        text.remove_prefix(std::min(comma + 1, text.size()));
+    }
+    const double west = deg[0], south = deg[1], east = deg[2], north = deg[3];
+    if (std::fabs(west) > kMaxLongitudeDeg || std::fabs(east) > kMaxLongitudeDeg ||
+        std::fabs(south) > kMaxLatitudeDeg || std::fabs(north) > kMaxLatitudeDeg ||
+        south > north)
+        return false;
+    out.west  = static_cast<std::int32_t>(coord_units(west));
+    out.south = static_cast<std::int32_t>(coord_units(south));
+    out.east  = static_cast<std::int32_t>(coord_units(east));
+    out.north = static_cast<std::int32_t>(coord_units(north));
+    return true;
+}
+
+// ─── RouteIndex ─────────────────────────────────────────────────────────────
+
+RouteIndex::RouteIndex(Span<const GpsRecord> route)
+{
+    const std::size_t n = route.size();
+    times_.resize(n);
+    bool ordered = true;
+    for (std::size_t i = 0; i < n; ++i) {
+        times_[i] = route[i].timestamp_ms;
+        ordered   = ordered && (i == 0 || times_[i] >= times_[i - 1]);
+    }
+    if (!ordered) {
+        time_order_.resize(n);
+        std::iota(time_order_.begin(), time_order_.end(), std::uint32_t{0});
+        std::stable_sort(time_order_.begin(), time_order_.end(),
+                         [&](std::uint32_t a, std::uint32_t b) {
+                             return route[a].timestamp_ms < route[b].timestamp_ms;
+                         });
+        for (std::size_t i = 0; i < n; ++i)
+            times_[i] = route[time_order_[i]].timestamp_ms;
+    }
+    if (n == 0)
+        return;
+
+    // Grid over the bounding box, with about kIndexPointsPerCell points
+    // per cell and rows and columns in proportion to its sides.
+    std::int32_t north = route[0].lat_e7, east = route[0].lon_e7;
+    south_ = north;
+    west_  = east;
+    for (const GpsRecord& r : route) {
+        south_ = std::min(south_, r.lat_e7);
+        north  = std::max(north, r.lat_e7);
+        west_  = std::min(west_, r.lon_e7);
+        east   = std::max(east, r.lon_e7);
+    }
+    const std::uint64_t span_lat = static_cast<std::uint64_t>(std::int64_t{north} - south_) + 1;
+    const std::uint64_t span_lon = static_cast<std::uint64_t>(std::int64_t{east} - west_) + 1;
+    const std::uint64_t cells = std::clamp<std::uint64_t>(n / kIndexPointsPerCell, 1, kIndexMaxCells);
+    const auto rows = std::clamp<std::uint64_t>(
+        static_cast<std::uint64_t>(std::llround(std::sqrt(
+            static_cast<double>(cells) * static_cast<double>(span_lat) / static_cast<double>(span_lon)))),
+        1, cells);
+    const std::uint64_t cols = std::max<std::uint64_t>(cells / rows, 1);
+    cell_lat_ = static_cast<std::uint32_t>((span_lat + rows - 1) / rows);
+    cell_lon_ = static_cast<std::uint32_t>((span_lon + cols - 1) / cols);
+    rows_     = static_cast<std::uint32_t>((span_lat + cell_lat_ - 1) / cell_lat_);
+    cols_     = static_cast<std::uint32_t>((span_lon + cell_lon_ - 1) / cell_lon_);
+
+    // Counting sort of positions by cell; walking the route in order
+    // keeps each cell's list ascending.
+    const auto cell_of = [&](const GpsRecord& r) {
+        const auto row = static_cast<std::uint64_t>(std::int64_t{r.lat_e7} - south_) / cell_lat_;
+        const auto col = static_cast<std::uint64_t>(std::int64_t{r.lon_e7} - west_) / cell_lon_;
+        return static_cast<std::size_t>(row * cols_ + col);
+    };
+    cell_start_.assign(std::size_t{rows_} * cols_ + 1, 0);
+    for (const GpsRecord& r : route)
+        ++cell_start_[cell_of(r) + 1];
+    std::partial_sum(cell_start_.begin(), cell_start_.end(), cell_start_.begin());
+    std::vector<std::uint32_t> next(cell_start_.begin(), cell_start_.end() - 1);
+    cell_points_.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+        cell_points_[next[cell_of(route[i])]++] = static_cast<std::uint32_t>(i);
+}
+
+void RouteIndex::time_range(const RouteQuery& query, std::size_t& lo, std::size_t& hi) const
+{
+    lo = query.from_ms ? static_cast<std::size_t>(
+                             std::lower_bound(times_.begin(), times_.end(), *query.from_ms) -
+                             times_.begin())
+                       : 0;
+    hi = query.to_ms ? static_cast<std::size_t>(
+                           std::lower_bound(times_.begin(), times_.end(), *query.to_ms) -
+                           times_.begin())
+                     : times_.size();
+    hi = std::max(lo, hi);
+}
+
+template <typename Visit>
+void RouteIndex::cells_under(const GeoBox& box, Visit visit) const
+{
+    if (rows_ == 0)
+        return;
+    const std::int64_t top   = std::int64_t{south_} + std::int64_t{rows_} * cell_lat_ - 1;
+    const std::int64_t right = std::int64_t{west_} + std::int64_t{cols_} * cell_lon_ - 1;
+    const std::int64_t s = std::max<std::int64_t>(box.south, south_);
+    const std::int64_t n = std::min<std::int64_t>(box.north, top);
+    if (s > n)
+        return;
+    const std::int64_t r0 = (s - south_) / cell_lat_, r1 = (n - south_) / cell_lat_;
+
+    // Column span of each longitude range; a box across the antimeridian
+    // has two, which become one where they meet in a shared column.
+    const bool wraps = box.west > box.east;
+    struct ColumnSpan {
+        std::int64_t first, last;
+    } spans[2];
+    std::size_t span_count = 0;
+    const auto add_span = [&](std::int64_t w, std::int64_t e) {
+        w = std::max<std::int64_t>(w, west_);
+        e = std::min<std::int64_t>(e, right);
+        if (w <= e)
+            spans[span_count++] = {(w - west_) / cell_lon_, (e - west_) / cell_lon_};
+    };
+    if (wraps) {
+        add_span(west_, box.east);
+        add_span(box.west, right);
+        if (span_count == 2 && spans[1].first <= spans[0].last) {
+            spans[0].last = spans[1].last;
+            span_count  = 1;
+        }
+    } else {
+        add_span(box.west, box.east);
+    }
+    const auto lon_inside = [&](std::int64_t lon0, std::int64_t lon1) {
+        return wraps ? lon0 >= box.west || lon1 <= box.east
+                     : lon0 >= box.west && lon1 <= box.east;
+    };
+
+    for (std::int64_t r = r0; r <= r1; ++r) {
+        const std::int64_t lat0 = south_ + r * cell_lat_, lat1 = lat0 + cell_lat_ - 1;
+        const bool rows_in = lat0 >= box.south && lat1 <= box.north;
+        for (std::size_t k = 0; k < span_count; ++k) {
+            for (std::int64_t c = spans[k].first; c <= spans[k].last; ++c) {
+                const std::int64_t lon0 = west_ + c * cell_lon_, lon1 = lon0 + cell_lon_ - 1;
+                const auto cell = static_cast<std::size_t>(r * cols_ + c);
+                visit(cell_points_.data() + cell_start_[cell],
+                      cell_points_.data() + cell_start_[cell + 1],
+                      rows_in && lon_inside(lon0, lon1));
+            }
+        }
+    }
+}
+
+std::vector<std::uint32_t> RouteIndex::find(Span<const GpsRecord> route,
+                                            const RouteQuery& query) const
+{
+    std::vector<std::uint32_t> out;
+    std::size_t lo = 0, hi = times_.size();
+    if (query.from_ms || query.to_ms)
+        time_range(query, lo, hi);
+    const auto position = [&](std::size_t row) {
+        return time_order_.empty() ? static_cast<std::uint32_t>(row) : time_order_[row];
+    };
+
+    // Take the smaller candidate set — the time window or the points in
+    // the cells under the box — and test the other condition on it.
+    std::size_t in_cells = 0;
+    if (query.bbox)
+        cells_under(*query.bbox, [&](const std::uint32_t* first, const std::uint32_t* last, bool) {
+            in_cells += static_cast<std::size_t>(last - first);
+        });
+    if (!query.bbox || hi - lo <= in_cells) {
+        for (std::size_t row = lo; row < hi; ++row) {
+            const std::uint32_t p = position(row);
+            if (!query.bbox || query.bbox->contains(route[p]))
+                out.push_back(p);
+        }
+        if (!time_order_.empty())
+            std::sort(out.begin(), out.end());
+        return out;
+    }
+    cells_under(*query.bbox, [&](const std::uint32_t* first, const std::uint32_t* last,
+                                 bool inside) {
+        for (const std::uint32_t* p = first; p != last; ++p) {
+            const GpsRecord& r = route[*p];
+            if ((inside || query.bbox->contains(r)) &&
+                (!query.from_ms || r.timestamp_ms >= *query.from_ms) &&
+                (!query.to_ms || r.timestamp_ms < *query.to_ms))
+                out.push_back(*p);
+        }
+    });
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+bool RouteIndex::save(const std::string& path, std::string& error) const
+{
+    char header[kRouteIndexHeaderBytes] = {};
+    std::memcpy(header, kRouteIndexMagic, sizeof kRouteIndexMagic);
+    store_le(header + 4, kRouteIndexVersion);
+    store_le(header + 6, time_order_.empty() ? kIndexTimeOrdered : std::uint16_t{0});
+    store_le(header + 8, static_cast<std::uint64_t>(times_.size()));
+    store_le(header + 16, rows_);
+    store_le(header + 20, cols_);
+    store_le(header + 24, south_);
+    store_le(header + 28, west_);
+    store_le(header + 32, cell_lat_);
+    store_le(header + 36, cell_lon_);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        return fail(error, path, "cannot open for writing");
+    out.write(header, sizeof header);
+    write_column(out, times_);
+    write_column(out, time_order_);
+    write_column(out, cell_start_);
+    write_column(out, cell_points_);
+    out.close();
+    if (!out)
+        return fail(error, path, "write failed");
+    return true;
+}
+
+bool RouteIndex::load(const std::string& path, std::string& error)
+{
+    *this = RouteIndex();
+    InputFile file;
+    if (!file.open(path))
+        return fail(error, path, "cannot open");
+    const char*       base = file.data().data();
+    const std::size_t size = file.size();
+    if (size < kRouteIndexHeaderBytes ||
+        std::memcmp(base, kRouteIndexMagic, sizeof kRouteIndexMagic) != 0)
+        return fail(error, path, "not a route index");
+    if (load_le<std::uint16_t>(base + 4) != kRouteIndexVersion)
+        return fail(error, path, "unsupported route index version");
+
+    const bool          ordered = load_le<std::uint16_t>(base + 6) & kIndexTimeOrdered;
+    const std::uint64_t count   = load_le<std::uint64_t>(base + 8);
+    const std::uint32_t rows = load_le<std::uint32_t>(base + 16);
+    const std::uint32_t cols = load_le<std::uint32_t>(base + 20);
+    const std::uint64_t cells = std::uint64_t{rows} * cols;
+    const std::uint32_t cell_lat = load_le<std::uint32_t>(base + 32);
+    const std::uint32_t cell_lon = load_le<std::uint32_t>(base + 36);
+    const auto bad = [&] { return fail(error, path, "truncated or corrupt route index"); };
+    if (count > std::numeric_limits<std::uint32_t>::max() || cells > kIndexMaxCells ||
+        (cells == 0) != (count == 0) || cell_lat == 0 || cell_lon == 0)
+        return bad();
+    const std::uint64_t columns = count * sizeof(std::int64_t) +
+                                  (ordered ? 0 : count * sizeof(std::uint32_t)) +
+                                  (cells + 1) * sizeof(std::uint32_t) +
+                                  count * sizeof(std::uint32_t);
+    if (size - kRouteIndexHeaderBytes != columns)
+        return bad();
+
+    const auto n = static_cast<std::size_t>(count);
+    const char* p = base + kRouteIndexHeaderBytes;
+    p = read_column(p, n, times_);
+    p = read_column(p, ordered ? 0 : n, time_order_);
+    p = read_column(p, static_cast<std::size_t>(cells) + 1, cell_start_);
+    read_column(p, n, cell_points_);
+    rows_     = rows;
+    cols_     = cols;
+    south_    = load_le<std::int32_t>(base + 24);
+    west_     = load_le<std::int32_t>(base + 28);
+    cell_lat_ = cell_lat;
+    cell_lon_ = cell_lon;
+
+    // find() indexes the route with these, so check every one.
+    const auto in_range = [&](std::uint32_t v) { return v < n; };
+    if (!std::is_sorted(times_.begin(), times_.end()) ||
+        !std::all_of(time_order_.begin(), time_order_.end(), in_range) ||
+        !std::all_of(cell_points_.begin(), cell_points_.end(), in_range) ||
+        cell_start_.front() != 0 || cell_start_.back() != n ||
+        !std::is_sorted(cell_start_.begin(), cell_start_.end())) {
+        *this = RouteIndex();
+        return bad();
+    }
+    return true;
+}
+
+std::vector<GpsRecord> select_route(Span<const GpsRecord> route, const RouteIndex& index,
+                                    const RouteQuery& query)
+{
+    const std::vector<std::uint32_t> hits = index.find(route, query);
+    std::vector<GpsRecord> out;
+    out.reserve(hits.size());
+    for (const std::uint32_t p : hits)
+        out.push_back(route[p]);
+    return out;
+}
+
+std::vector<GpsRecord> select_route(Span<const GpsRecord> route, const RouteQuery& query)
+{
+    std::vector<GpsRecord> out;
+    for (const GpsRecord& rec : route)
+        if (query.matches(rec))
+            out.push_back(rec);
+    return out;
+}
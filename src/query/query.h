@@ -0,0 +1,147 @@
+/*
+ * query.h — Time-window and bounding-box queries over a route (--from,
+ *           --to, --bbox, --export-index)
+ *
+ * Analysts usually want a slice of a day's route — an hour, or the
+ * points inside one area — not the whole table.  RouteIndex is built once
+ * per deduplicated route: a sorted timestamp column for time windows and
+ * a uniform grid over the route's bounding box for areas.  A query reads
+ * only the rows of the time window or the grid cells under the box,
+ * whichever holds fewer points, and tests just those.
+ *
+ * Points are identified by their position in the route, which is also
+ * their record number in an --export-bin file of the same route, so an
+ * index saved next to a binary export answers queries against it without
+ * re-parsing anything.
+ */
+
+#ifndef QUERY_H
+#define QUERY_H
+
+#include "arena.h"
+#include "nmea_parser.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Binary index file layout (little-endian, like route files):
+///
+///   offset  size  field
+///        0     4  magic "NMIX"
+///        4     2  version (kRouteIndexVersion)
+///        6     2  flags (kIndexTimeOrdered: the route is in time order
+///                 and the time-order column is omitted)
+///        8     8  point count
+///       16     8  grid rows, grid columns (uint32 each)
+///       24     8  south-west corner of the grid, lat then lon (int32 each)
+///       32     8  cell height and width in coordinate units (uint32 each)
+///       40     8  reserved (0)
+///       48     …  sorted timestamps (int64 × count), time order
+///                 (uint32 × count, unless time ordered), cell starts
+///                 (uint32 × cells + 1), cell points (uint32 × count)
+inline constexpr char          kRouteIndexMagic[4]    = {'N', 'M', 'I', 'X'};
+inline constexpr std::uint16_t kRouteIndexVersion     = 1;
+inline constexpr std::size_t   kRouteIndexHeaderBytes = 48;
+inline constexpr std::uint16_t kIndexTimeOrdered      = 1;
+
+/// Points per grid cell the index aims for, and the cap on the number of
+/// cells (so a sparse route spread over a continent stays small).
+inline constexpr std::size_t kIndexPointsPerCell = 16;
+inline constexpr std::size_t kIndexMaxCells      = std::size_t{1} << 20;
+
+/// A latitude/longitude box in coordinate units, edges included.  A box
+/// whose west edge is east of its east edge crosses the antimeridian.
+struct GeoBox {
+    std::int32_t south = 0;
+    std::int32_t west  = 0;
+    std::int32_t north = 0;
+    std::int32_t east  = 0;
+
+    bool contains(const GpsRecord& rec) const
+    {
+        const bool lon = west <= east ? rec.lon_e7 >= west && rec.lon_e7 <= east
+                                      : rec.lon_e7 >= west || rec.lon_e7 <= east;
+        return lon && rec.lat_e7 >= south && rec.lat_e7 <= north;
+    }
+};
+
+/// What to keep of a route: points in [from_ms, to_ms) and inside `bbox`.
+/// Unset parts don't restrict.
+struct RouteQuery {
+    std::optional<std::int64_t> from_ms;   // --from, inclusive
+    std::optional<std::int64_t> to_ms;     // --to, exclusive
+    std::optional<GeoBox>       bbox;      // --bbox
+
+    bool active() const { return from_ms || to_ms || bbox; }
+
+    /// The query applied to one point — the linear-scan reference.
+    bool matches(const GpsRecord& rec) const
+    {
+        return (!from_ms || rec.timestamp_ms >= *from_ms) &&
+               (!to_ms || rec.timestamp_ms < *to_ms) && (!bbox || bbox->contains(rec));
+    }
+};
+
+/// Parse a --from / --to time: Unix milliseconds, or UTC ISO 8601 as
+/// `YYYY-MM-DD`, `YYYY-MM-DDTHH:MM[:SS[.sss]]` with an optional `Z` (a
+/// space may stand for the `T`).  Returns false if `text` is neither.
+bool parse_query_time(std::string_view text, std::int64_t& out);
+
+/// Parse a --bbox `WEST,SOUTH,EAST,NORTH` in decimal degrees (GeoJSON's
+/// bbox order).  Returns false on malformed text, a latitude beyond ±90°,
+/// a longitude beyond ±180° or south above north.
+bool parse_geo_box(std::string_view text, GeoBox& out);
+
+/// Index over one route; see the file comment.  Positions are 32-bit.
+class RouteIndex {
+public:
+    RouteIndex() = default;
+
+    /// Index `route` (need not be in time order).
+    explicit RouteIndex(Span<const GpsRecord> route);
+
+    std::size_t size() const { return times_.size(); }
+
+    /// Positions in `route` — the route this index was built from — of
+    /// the points matching `query`, in route order.
+    std::vector<std::uint32_t> find(Span<const GpsRecord> route, const RouteQuery& query) const;
+
+    /// Write the index to `path`.  Returns false and sets `error` if it
+    /// can't be written.
+    bool save(const std::string& path, std::string& error) const;
+
+    /// Read an index written by save().  Returns false and sets `error`
+    /// if it can't be read or is not a well-formed index of this version.
+    bool load(const std::string& path, std::string& error);
+
+private:
+    /// Rows [lo, hi) of the time column holding [query.from_ms, query.to_ms).
+    void time_range(const RouteQuery& query, std::size_t& lo, std::size_t& hi) const;
+
+    /// Calls `visit(first, last, inside)` for the point lists of the
+    /// cells under `box`; `inside` means the whole cell lies in the box.
+    template <typename Visit>
+    void cells_under(const GeoBox& box, Visit visit) const;
+
+    std::vector<std::int64_t>  times_;              // timestamps, ascending
+    std::vector<std::uint32_t> time_order_;         // position of each row of times_; empty = identity
+    std::vector<std::uint32_t> cell_start_ = {0};   // cells + 1 offsets into cell_points_
+    std::vector<std::uint32_t> cell_points_;        // positions, cell by cell, ascending within a cell
+    std::uint32_t rows_ = 0, cols_ = 0;
+    std::int32_t  south_ = 0, west_ = 0;
+    std::uint32_t cell_lat_ = 1, cell_lon_ = 1;   // cell size in coordinate units
+};
+
+/// Convenience: the points of `route` matching `query`, in route order.
+std::vector<GpsRecord> select_route(Span<const GpsRecord> route, const RouteIndex& index,
+                                    const RouteQuery& query);
+
+/// The same selection by one pass of RouteQuery::matches — cheaper than
+/// building an index to answer a single query.
+std::vector<GpsRecord> select_route(Span<const GpsRecord> route, const RouteQuery& query);
+
+#endif // QUERY_H
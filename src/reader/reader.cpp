@@ -0,0 +1,150 @@
+/*
+ * reader.cpp — Zero-copy input file access and line splitting
+ */
+
+#include "reader.h"
+
+#include <cstring>
+#include <utility>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ─── InputFile ──────────────────────────────────────────────────────────────
+
+InputFile::~InputFile()
+{
+    close();
+}
+
+InputFile::InputFile(InputFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+InputFile& InputFile::operator=(InputFile&& other) noexcept
+{
+    if (this != &other) {
+        close();
+        mapped_ = other.mapped_;
+        size_   = other.size_;
+        buffer_ = std::move(other.buffer_);
+        data_   = mapped_ ? other.data_ : buffer_.data();
+        other.data_   = nullptr;
+        other.size_   = 0;
+        other.mapped_ = false;
+    }
+    return *this;
+}
+
+void InputFile::close()
+{
+#if !defined(_WIN32)
+    if (mapped_)
+        ::munmap(const_cast<char*>(data_), size_);
+#endif
+    data_   = nullptr;
+    size_   = 0;
+    mapped_ = false;
+    buffer_.clear();
+}
+
+#if defined(_WIN32)
+
+bool InputFile::open(const std::string& path)
+{
+    close();
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs)
+        return false;
+    buffer_.assign(std::istreambuf_iterator<char>(ifs),
+                   std::istreambuf_iterator<char>());
+    if (ifs.bad())
+        return false;
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return true;
+}
+
+#else
+
+static constexpr std::size_t kReadChunk = 64 * 1024;   // non-regular file read size
+
+bool InputFile::open(const std::string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // Pipes, FIFOs and character devices can't be mapped — buffer them.
+    if (!S_ISREG(st.st_mode)) {
+        char chunk[kReadChunk];
+        ssize_t n = 0;
+        while ((n = ::read(fd, chunk, sizeof chunk)) > 0)
+            buffer_.append(chunk, static_cast<std::size_t>(n));
+        ::close(fd);
+        if (n < 0) {
+            buffer_.clear();
+            return false;
+        }
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+        return true;
+    }
+
+    // mmap rejects zero-length mappings; an empty file is simply no lines.
+    if (st.st_size == 0) {
+        ::close(fd);
+        data_ = buffer_.data();
+        return true;
+    }
+
+    const auto len = static_cast<std::size_t>(st.st_size);
+    void* addr = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);    // the mapping keeps its own reference to the file
+    if (addr == MAP_FAILED)
+        return false;
+
+    ::madvise(addr, len, MADV_SEQUENTIAL);
+    data_   = static_cast<const char*>(addr);
+    size_   = len;
+    mapped_ = true;
+    return true;
+}
+
+#endif
+
+// ─── LineCursor ─────────────────────────────────────────────────────────────
+
+bool LineCursor::next(std::string_view& line)
+{
+    if (pos_ >= buf_.size())
+        return false;
+
+    const char* begin = buf_.data() + pos_;
+    const std::size_t remaining = buf_.size() - pos_;
+    const auto* nl = static_cast<const char*>(std::memchr(begin, '\n', remaining));
+
+    std::size_t len = nl ? static_cast<std::size_t>(nl - begin) : remaining;
+    pos_ += nl ? len + 1 : len;
+
+    // Strip trailing CR (files may use \r\n line endings).
+    if (len > 0 && begin[len - 1] == '\r')
+        --len;
+    line = std::string_view(begin, len);
+    return true;
+}
@@ -0,0 +1,61 @@
+/*
+ * reader.h — Zero-copy input file access and line splitting
+ */
+
+#ifndef READER_H
+#define READER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/// Read-only view of an entire input file.
+///   - POSIX:          the file is memory-mapped; `data()` points into the mapping
+///   - Windows/MinGW:  buffered-read fallback into an owned buffer
+/// Move-only; the view stays valid for the lifetime of the object.
+class InputFile {
+public:
+    InputFile() = default;
+    ~InputFile();
+
+    InputFile(const InputFile&)            = delete;
+    InputFile& operator=(const InputFile&) = delete;
+    InputFile(InputFile&& other) noexcept;
+    InputFile& operator=(InputFile&& other) noexcept;
+
+    /// Open and map `path`.  Returns false if the file can't be opened or
+    /// read; the object is left empty in that case.
+    bool open(const std::string& path);
+
+    /// Release the mapping / buffer.
+    void close();
+
+    std::string_view data() const { return {data_, size_}; }
+    std::size_t      size() const { return size_; }
+
+private:
+    const char* data_   = nullptr;
+    std::size_t size_   = 0;
+    bool        mapped_ = false;   // true when data_ must be munmap'ed
+    std::string buffer_;           // owns the bytes in the fallback path
+};
+
+/// Yields successive lines of a buffer as views, scanning for '\n' with
+/// memchr (vectorised in every mainstream libc).  A trailing '\r' is
+/// stripped; a final line without a newline is still returned.
+class LineCursor {
+public:
+    explicit LineCursor(std::string_view buf) : buf_(buf) {}
+
+    /// Fetch the next line into `line`.  Returns false at end of buffer.
+    bool next(std::string_view& line);
+
+    /// Byte offset of the next unread line within the buffer.
+    std::size_t offset() const { return pos_; }
+
+private:
+    std::string_view buf_;
+    std::size_t      pos_ = 0;
+};
+
+#endif // READER_H
@@ -0,0 +1,108 @@
+/*
+ * reject.cpp — Per-reason reject counters and a sample of rejected lines
+ */
+
+#include "reject.h"
+
+#include <utility>
+
+// ─── Sampler constants ─────────────────────────────────────────────────────
+
+static constexpr std::uint64_t kSplitMixGamma = 0x9e3779b97f4a7c15ull;
+
+// ─── Internal helpers ───────────────────────────────────────────────────────
+
+namespace {
+
+/// splitmix64: one multiply-xorshift step per draw, plenty for sampling.
+std::uint64_t next_random(std::uint64_t& state)
+{
+    std::uint64_t z = (state += kSplitMixGamma);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+void fill_sample(RejectSample& s, RejectReason reason, SentenceType type,
+                 std::string_view line, LineOrigin at)
+{
+    s.at     = at;
+    s.reason = reason;
+    s.type   = type;
+    s.line.assign(line.substr(0, kRejectSampleBytes));
+}
+
+} // namespace
+
+// ─── Public API ─────────────────────────────────────────────────────────────
+
+void RejectStats::add(RejectReason reason, SentenceType type, std::string_view line,
+                      LineOrigin at)
+{
+    ++counts[static_cast<std::size_t>(reason)][static_cast<std::size_t>(type)];
+
+    // Reservoir sampling (Algorithm R): the n-th reject replaces a random
+    // slot with probability kRejectSampleCount / n.  Past the first few
+    // thousand rejects almost every call stops at the draw.
+    ++offered;
+    if (samples.size() < kRejectSampleCount) {
+        samples.emplace_back();
+        fill_sample(samples.back(), reason, type, line, at);
+        return;
+    }
+    const std::uint64_t slot = next_random(rng) % offered;
+    if (slot < kRejectSampleCount)
+        fill_sample(samples[slot], reason, type, line, at);
+}
+
+std::size_t RejectStats::total(RejectReason reason) const
+{
+    std::size_t n = 0;
+    for (std::size_t c : counts[static_cast<std::size_t>(reason)])
+        n += c;
+    return n;
+}
+
+std::size_t RejectStats::total() const
+{
+    std::size_t n = 0;
+    for (std::size_t r = 0; r < kRejectReasonCount; ++r)
+        n += total(static_cast<RejectReason>(r));
+    return n;
+}
+
+RejectStats& RejectStats::operator+=(const RejectStats& other)
+{
+    for (std::size_t r = 0; r < kRejectReasonCount; ++r)
+        for (std::size_t t = 0; t < kSentenceTypeCount; ++t)
+            counts[r][t] += other.counts[r][t];
+
+    if (other.offered == 0)
+        return *this;
+    if (offered == 0) {
+        samples = other.samples;
+        offered = other.offered;
+        return *this;
+    }
+
+    // Each side holds a uniform sample of its own rejects.  Drawing
+    // without replacement from the union — the next line comes from this
+    // side with probability (its rejects not yet drawn) / (all not yet
+    // drawn), then a random one of that side's sampled lines — gives a
+    // uniform sample of both together.
+    std::vector<RejectSample> pools[2] = {std::move(samples), other.samples};
+    std::uint64_t left[2] = {offered, other.offered};
+    samples.clear();
+    while (samples.size() < kRejectSampleCount && !(pools[0].empty() && pools[1].empty())) {
+        const int side = next_random(rng) % (left[0] + left[1]) < left[0] ? 0 : 1;
+        std::vector<RejectSample>& pool = pools[side];
+        --left[side];
+        const std::size_t pick = static_cast<std::size_t>(next_random(rng) % pool.size());
+        samples.push_back(std::move(pool[pick]));
+        if (pick + 1 != pool.size())
+            pool[pick] = std::move(pool.back());
+        pool.pop_back();
+    }
+    offered += other.offered;
+    return *this;
+}
@@ -0,0 +1,72 @@
+/*
+ * reject.h — Per-reason reject counters and a sample of rejected lines
+ *
+ * Always on.  Every line ingest rejects bumps one counter indexed by
+ * reason and sentence type, and is offered to a small reservoir sample
+ * that keeps the line's text and its position in the input.  A
+ * RejectStats lives in each IngestCounters, so it is kept per thread /
+ * per chunk and merged at the end like the other counters; the merged
+ * sample is still uniform over every rejected line.  --stats and
+ * --stats-json report both.
+ */
+
+#ifndef REJECT_H
+#define REJECT_H
+
+#include "nmea_parser.h"
+#include "sentence.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Rejected lines kept per sample, and the most of each line's text kept.
+inline constexpr std::size_t kRejectSampleCount = 16;
+inline constexpr std::size_t kRejectSampleBytes = 120;
+
+/// Where a buffer starts within its input, so a line's byte offset
+/// can be reported relative to the input instead of the buffer.
+struct LineOrigin {
+    std::size_t   file   = 0;   // index in the input list
+    std::uint64_t offset = 0;   // byte offset within that input
+};
+
+/// One sampled rejected line.
+struct RejectSample {
+    LineOrigin   at;                                // the line's first byte
+    RejectReason reason = RejectReason::kNone;
+    SentenceType type   = SentenceType::kUnknown;
+    std::string  line;                               // truncated to kRejectSampleBytes
+};
+
+/// Reject counters and sample for one thread, chunk or run.
+struct RejectStats {
+    std::array<std::array<std::size_t, kSentenceTypeCount>, kRejectReasonCount> counts{};
+    std::vector<RejectSample> samples;    // ≤ kRejectSampleCount, in no particular order
+    std::uint64_t             offered = 0;   // rejects the sample was drawn from
+    std::uint64_t             rng     = 0;   // sampler state (fixed seed: reproducible)
+
+    /// Count a rejected `line` of `type` found at `at` and offer it
+    /// to the sample.
+    void add(RejectReason reason, SentenceType type, std::string_view line, LineOrigin at);
+
+    std::size_t count(RejectReason reason, SentenceType type) const
+    {
+        return counts[static_cast<std::size_t>(reason)][static_cast<std::size_t>(type)];
+    }
+
+    /// Rejects for `reason` over all sentence types.
+    std::size_t total(RejectReason reason) const;
+
+    /// Rejects for every reason.
+    std::size_t total() const;
+
+    /// Add `other`'s counters and merge the samples so the result is a
+    /// uniform sample of both streams together.
+    RejectStats& operator+=(const RejectStats& other);
+};
+
+#endif // REJECT_H
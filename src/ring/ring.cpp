@@ -0,0 +1,38 @@
+/*
+ * ring.cpp — Bounded lock-free single-producer/single-consumer ring buffer
+ */
+
+#include "ring.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+// ─── Backoff constants ─────────────────────────────────────────────────────
+
+// A stage that is only briefly ahead finds room within a few hundred
+// nanoseconds, so spin first; past that, give the core away, and once the
+// other side is clearly stalled (a slow sink, an idle live source) sleep,
+// doubling up to kMaxSleep so a long wait costs next to no CPU.
+static constexpr unsigned kSpinRounds  = 64;
+static constexpr unsigned kYieldRounds = 192;
+static constexpr auto     kMinSleep    = std::chrono::microseconds(50);
+static constexpr auto     kMaxSleep    = std::chrono::microseconds(1000);
+
+void RingBackoff::wait()
+{
+    if (rounds_ < kSpinRounds) {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    } else if (rounds_ < kYieldRounds) {
+        std::this_thread::yield();
+    } else {
+        sleep_ = sleep_ < kMinSleep ? kMinSleep : std::min(sleep_ * 2, kMaxSleep);
+        std::this_thread::sleep_for(sleep_);
+        return;
+    }
+    ++rounds_;
+}
@@ -0,0 +1,154 @@
+/*
+ * ring.h — Bounded lock-free single-producer/single-consumer ring buffer
+ *
+ * Connects pipeline stages that run on their own threads (--pipeline,
+ * --live).  Each side owns one index and keeps a cached copy of the
+ * other, on separate cache lines, so a push or pop touches shared state
+ * only when its cached view runs out.  Batch operations move many items
+ * per index update.  A full ring makes the producer wait (backpressure),
+ * so memory stays bounded however far one stage falls behind.
+ */
+
+#ifndef RING_H
+#define RING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/// Padding unit that keeps the producer's and consumer's hot fields
+/// apart.  64 bytes on every target we build for.
+inline constexpr std::size_t kCacheLineBytes = 64;
+
+/// Spin → yield → sleep wait used by the blocking ring operations.  A
+/// fresh instance per wait: it escalates the longer that wait goes on.
+class RingBackoff {
+public:
+    void wait();
+
+private:
+    unsigned                  rounds_ = 0;
+    std::chrono::microseconds sleep_{0};
+};
+
+/// Bounded SPSC queue of `T` (default-constructible, move-assignable).
+/// Exactly one thread may push and one other thread may pop.  The
+/// producer calls `close` once it is done; the consumer then drains what
+/// is left and sees end of stream.
+template <typename T>
+class SpscRing {
+public:
+    /// At least `capacity` slots (rounded up to a power of two).
+    explicit SpscRing(std::size_t capacity)
+    {
+        std::size_t n = 2;
+        while (n < capacity)
+            n <<= 1;
+        slots_.resize(n);
+        mask_ = n - 1;
+    }
+
+    SpscRing(const SpscRing&)            = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    std::size_t capacity() const { return slots_.size(); }
+
+    // ── Producer side ──────────────────────────────────────────────────
+
+    /// Move up to `n` items from `items` into the ring without waiting.
+    /// Returns how many were taken.
+    std::size_t try_push(T* items, std::size_t n)
+    {
+        const std::size_t tail = producer_.tail.load(std::memory_order_relaxed);
+        std::size_t free = capacity() - (tail - producer_.cached_head);
+        if (free < n) {
+            producer_.cached_head = consumer_.head.load(std::memory_order_acquire);
+            free = capacity() - (tail - producer_.cached_head);
+        }
+        if (n > free)
+            n = free;
+        for (std::size_t i = 0; i < n; ++i)
+            slots_[(tail + i) & mask_] = std::move(items[i]);
+        if (n)
+            producer_.tail.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    /// Move all `n` items in, waiting for room as needed.
+    void push(T* items, std::size_t n)
+    {
+        RingBackoff backoff;
+        while (n) {
+            const std::size_t pushed = try_push(items, n);
+            items += pushed;
+            n     -= pushed;
+            if (n)
+                backoff.wait();
+        }
+    }
+
+    void push(T&& item) { push(&item, 1); }
+
+    /// No more items will be pushed.
+    void close() { closed_.store(true, std::memory_order_release); }
+
+    // ── Consumer side ──────────────────────────────────────────────────
+
+    /// Move up to `max` items into `out` without waiting.  Returns how
+    /// many were taken.
+    std::size_t try_pop(T* out, std::size_t max)
+    {
+        const std::size_t head = consumer_.head.load(std::memory_order_relaxed);
+        std::size_t ready = consumer_.cached_tail - head;
+        if (ready < max) {
+            consumer_.cached_tail = producer_.tail.load(std::memory_order_acquire);
+            ready = consumer_.cached_tail - head;
+        }
+        if (max > ready)
+            max = ready;
+        for (std::size_t i = 0; i < max; ++i)
+            out[i] = std::move(slots_[(head + i) & mask_]);
+        if (max)
+            consumer_.head.store(head + max, std::memory_order_release);
+        return max;
+    }
+
+    /// Wait for at least one item and take up to `max`.  Returns 0 only
+    /// once the ring is closed and empty.
+    std::size_t pop(T* out, std::size_t max)
+    {
+        RingBackoff backoff;
+        for (;;) {
+            // Read the flag before polling: anything pushed before close()
+            // is then visible to the try_pop that follows.
+            const bool done = closed_.load(std::memory_order_acquire);
+            if (const std::size_t n = try_pop(out, max))
+                return n;
+            if (done)
+                return 0;
+            backoff.wait();
+        }
+    }
+
+    bool pop(T& item) { return pop(&item, 1) == 1; }
+
+private:
+    struct alignas(kCacheLineBytes) ProducerSide {
+        std::atomic<std::size_t> tail{0};
+        std::size_t              cached_head = 0;
+    };
+    struct alignas(kCacheLineBytes) ConsumerSide {
+        std::atomic<std::size_t> head{0};
+        std::size_t              cached_tail = 0;
+    };
+
+    ProducerSide      producer_;
+    ConsumerSide      consumer_;
+    std::atomic<bool> closed_{false};
+    std::vector<T>    slots_;
+    std::size_t       mask_ = 0;
+};
+
+#endif // RING_H
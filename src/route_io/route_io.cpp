@@ -0,0 +1,433 @@
+/*
+ * route_io.cpp — Route export (binary columnar, GeoJSON, CSV) and reload
+ */
+
+#include "route_io.h"
+#include "output.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#if defined(_WIN32)
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+// ─── Route I/O constants ───────────────────────────────────────────────────
+
+static constexpr int         kStdoutFd         = 1;
+static constexpr std::size_t kMaxVarintBytes   = 10;   // 64 bits / 7 per byte
+static constexpr unsigned    kVarintPayload    = 0x7f;
+static constexpr unsigned    kVarintContinue   = 0x80;
+
+namespace {
+
+// ─── Output file ────────────────────────────────────────────────────────────
+
+/// Descriptor for an export target; "-" is stdout and is left open.
+class OutputFd {
+public:
+    explicit OutputFd(const std::string& path)
+    {
+        if (path == "-") {
+            fd_ = kStdoutFd;
+            return;
+        }
+#if defined(_WIN32)
+        fd_ = ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+                      _S_IREAD | _S_IWRITE);
+#else
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+        owned_ = fd_ >= 0;
+    }
+
+    ~OutputFd() { close(); }
+
+    OutputFd(const OutputFd&)            = delete;
+    OutputFd& operator=(const OutputFd&) = delete;
+
+    int  fd() const { return fd_; }
+
+    /// Close an owned descriptor; false if the close reported an error.
+    bool close()
+    {
+        if (!owned_)
+            return true;
+        owned_ = false;
+#if defined(_WIN32)
+        return ::_close(fd_) == 0;
+#else
+        return ::close(fd_) == 0;
+#endif
+    }
+
+private:
+    int  fd_    = -1;
+    bool owned_ = false;
+};
+
+// ─── Varint codec ───────────────────────────────────────────────────────────
+
+std::uint64_t zigzag(std::int64_t v)
+{
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t v)
+{
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+void put_varint(std::string& out, std::uint64_t v)
+{
+    char buf[kMaxVarintBytes];
+    std::size_t n = 0;
+    while (v >= kVarintContinue) {
+        buf[n++] = static_cast<char>((v & kVarintPayload) | kVarintContinue);
+        v >>= 7;
+    }
+    buf[n++] = static_cast<char>(v);
+    out.append(buf, n);
+}
+
+/// Decode one varint from [p, end).  Returns nullptr when it runs past
+/// `end` or exceeds 64 bits.
+const char* get_varint(const char* p, const char* end, std::uint64_t& v)
+{
+    v = 0;
+    for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+        const auto byte = static_cast<unsigned char>(*p++);
+        v |= static_cast<std::uint64_t>(byte & kVarintPayload) << shift;
+        if (!(byte & kVarintContinue))
+            return p;
+    }
+    return nullptr;
+}
+
+/// The value's bit pattern as an unsigned integer of the same width.
+template <typename U, typename T>
+U bits_of(T value)
+{
+    static_assert(sizeof(U) == sizeof(T), "bit pattern width mismatch");
+    U u;
+    std::memcpy(&u, &value, sizeof u);
+    return u;
+}
+
+template <typename T, typename U>
+T from_bits(U u)
+{
+    static_assert(sizeof(U) == sizeof(T), "bit pattern width mismatch");
+    T value;
+    std::memcpy(&value, &u, sizeof value);
+    return value;
+}
+
+/// Delta-encode one column: `key(rec)` yields the field as an unsigned
+/// integer; wrapping differences are zigzagged so small steps in either
+/// direction stay short.
+template <typename U, typename Key>
+std::string encode_delta(Span<const GpsRecord> route, Key key)
+{
+    std::string out;
+    out.reserve(route.size() * 3);
+    U prev = 0;
+    for (const GpsRecord& rec : route) {
+        const U cur = key(rec);
+        using S = std::make_signed_t<U>;
+        put_varint(out, zigzag(static_cast<S>(static_cast<U>(cur - prev))));
+        prev = cur;
+    }
+    return out;
+}
+
+/// Decode `count` deltas from [p, end) through `store(i, value)`.
+template <typename U, typename Store>
+bool decode_delta(const char* p, const char* end, std::size_t count, Store store)
+{
+    U prev = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint64_t v;
+        if (!(p = get_varint(p, end, v)))
+            return false;
+        prev = static_cast<U>(prev + static_cast<U>(unzigzag(v)));
+        store(i, prev);
+    }
+    return p == end;
+}
+
+// ─── Header ─────────────────────────────────────────────────────────────────
+
+std::size_t padded(std::size_t bytes)
+{
+    return (bytes + kRouteColumnAlign - 1) / kRouteColumnAlign * kRouteColumnAlign;
+}
+
+bool fail(std::string& error, const std::string& path, const char* what)
+{
+    error = "'" + path + "': " + what;
+    return false;
+}
+
+/// FdWriter::number for a signed value (pre-epoch timestamps).
+void write_signed(FdWriter& out, std::int64_t value)
+{
+    std::uint64_t magnitude = static_cast<std::uint64_t>(value);
+    if (value < 0) {
+        out.put('-');
+        magnitude = 0 - magnitude;
+    }
+    out.number(static_cast<std::size_t>(magnitude));
+}
+
+/// Flush `out` and close `file`; reports the first failure as a write error.
+bool finish(FdWriter& out, OutputFd& file, const std::string& path, std::string& error)
+{
+    const bool written = out.flush();
+    if (!file.close() || !written)
+        return fail(error, path, "write failed");
+    return true;
+}
+
+} // namespace
+
+// ─── Writers ────────────────────────────────────────────────────────────────
+
+bool write_route_binary(Span<const GpsRecord> route, const std::string& path,
+                        RouteEncoding encoding, std::string& error)
+{
+    const std::size_t n = route.size();
+    std::string columns[kRouteColumnCount];
+    if (encoding == RouteEncoding::kDelta) {
+        columns[0] = encode_delta<std::uint64_t>(route, [](const GpsRecord& r) {
+            return static_cast<std::uint64_t>(r.timestamp_ms);
+        });
+        columns[1] = encode_delta<std::uint32_t>(route, [](const GpsRecord& r) {
+            return static_cast<std::uint32_t>(r.lat_e7);
+        });
+        columns[2] = encode_delta<std::uint32_t>(route, [](const GpsRecord& r) {
+            return static_cast<std::uint32_t>(r.lon_e7);
+        });
+        columns[3] = encode_delta<std::uint32_t>(route, [](const GpsRecord& r) {
+            return bits_of<std::uint32_t>(r.speed);
+        });
+    } else {
+        columns[0].resize(n * sizeof(std::int64_t));
+        columns[1].resize(n * sizeof(std::int32_t));
+        columns[2].resize(n * sizeof(std::int32_t));
+        columns[3].resize(n * sizeof(float));
+        for (std::size_t i = 0; i < n; ++i) {
+            store_le(&columns[0][i * sizeof(std::int64_t)], route[i].timestamp_ms);
+            store_le(&columns[1][i * sizeof(std::int32_t)], route[i].lat_e7);
+            store_le(&columns[2][i * sizeof(std::int32_t)], route[i].lon_e7);
+            store_le(&columns[3][i * sizeof(float)], route[i].speed);
+        }
+    }
+
+    char header[kRouteHeaderBytes] = {};
+    std::memcpy(header, kRouteFileMagic, sizeof kRouteFileMagic);
+    store_le(header + 4, kRouteFileVersion);
+    store_le(header + 6, static_cast<std::uint16_t>(encoding));
+    store_le(header + 8, static_cast<std::uint64_t>(n));
+    for (std::size_t c = 0; c < kRouteColumnCount; ++c)
+        store_le(header + 16 + 8 * c, static_cast<std::uint64_t>(columns[c].size()));
+
+    OutputFd file(path);
+    if (file.fd() < 0)
+        return fail(error, path, "cannot open for writing");
+    FdWriter out(file.fd());
+    out.write({header, sizeof header});
+    for (const std::string& col : columns) {
+        out.write(col);
+        for (std::size_t pad = col.size(); pad < padded(col.size()); ++pad)
+            out.put('\0');
+    }
+    return finish(out, file, path, error);
+}
+
+bool write_route_geojson(Span<const GpsRecord> route, const std::string& path,
+                         std::string& error)
+{
+    OutputFd file(path);
+    if (file.fd() < 0)
+        return fail(error, path, "cannot open for writing");
+    FdWriter out(file.fd());
+    out.write("{\"type\":\"FeatureCollection\",\"features\":[");
+    for (std::size_t i = 0; i < route.size(); ++i) {
+        const GpsRecord& r = route[i];
+        out.write(i ? ",\n" : "\n");
+        out.write("{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\",\"coordinates\":[");
+        out.coord(r.lon_e7, kExportCoordPrecision);   // GeoJSON positions are [lon, lat]
+        out.put(',');
+        out.coord(r.lat_e7, kExportCoordPrecision);
+        out.write("]},\"properties\":{\"timestamp_ms\":");
+        write_signed(out, r.timestamp_ms);
+        out.write(",\"speed_mps\":");
+        out.fixed(r.speed, kExportSpeedPrecision);
+        out.write("}}");
+    }
+    out.write("\n]}\n");
+    return finish(out, file, path, error);
+}
+
+bool write_route_csv(Span<const GpsRecord> route, const std::string& path,
+                     std::string& error)
+{
+    OutputFd file(path);
+    if (file.fd() < 0)
+        return fail(error, path, "cannot open for writing");
+    FdWriter out(file.fd());
+    out.write("timestamp_ms,latitude,longitude,speed_mps\n");
+    for (const GpsRecord& r : route) {
+        write_signed(out, r.timestamp_ms);
+        out.put(',');
+        out.coord(r.lat_e7, kExportCoordPrecision);
+        out.put(',');
+        out.coord(r.lon_e7, kExportCoordPrecision);
+        out.put(',');
+        out.fixed(r.speed, kExportSpeedPrecision);
+        out.put('\n');
+    }
+    return finish(out, file, path, error);
+}
+
+// ─── Reader ─────────────────────────────────────────────────────────────────
+
+bool RouteFile::open(const std::string& path, std::string& error)
+{
+    close();
+    if (!file_.open(path))
+        return fail(error, path, "cannot open");
+
+    const char*       base = file_.data().data();
+    const std::size_t size = file_.size();
+    if (size < kRouteHeaderBytes || std::memcmp(base, kRouteFileMagic, sizeof kRouteFileMagic) != 0) {
+        close();
+        return fail(error, path, "not a route file");
+    }
+    const auto version  = load_le<std::uint16_t>(base + 4);
+    const auto encoding = load_le<std::uint16_t>(base + 6);
+    const auto count    = load_le<std::uint64_t>(base + 8);
+    if (version != kRouteFileVersion ||
+        encoding > static_cast<std::uint16_t>(RouteEncoding::kDelta)) {
+        close();
+        return fail(error, path, "unsupported route file version or encoding");
+    }
+
+    // Every column must fit in what is left of the file, in order.
+    std::size_t offset = kRouteHeaderBytes;
+    for (std::size_t c = 0; c < kRouteColumnCount; ++c) {
+        const auto bytes = load_le<std::uint64_t>(base + 16 + 8 * c);
+        if (bytes > size - offset || padded(bytes) > size - offset) {
+            close();
+            return fail(error, path, "truncated route file");
+        }
+        column_data_[c]  = base + offset;
+        column_bytes_[c] = bytes;
+        offset += padded(bytes);
+    }
+
+    encoding_ = static_cast<RouteEncoding>(encoding);
+    if (encoding_ == RouteEncoding::kRaw) {
+        static constexpr std::size_t kWidth[kRouteColumnCount] = {
+            sizeof(std::int64_t), sizeof(std::int32_t), sizeof(std::int32_t), sizeof(float)};
+        for (std::size_t c = 0; c < kRouteColumnCount; ++c) {
+            if (count > column_bytes_[c] / kWidth[c] || column_bytes_[c] != count * kWidth[c]) {
+                close();
+                return fail(error, path, "column length does not match record count");
+            }
+        }
+        if constexpr (kBigEndianHost) {
+            // Not usable in place: swap every value into a native copy.
+            const std::size_t bytes = offset - kRouteHeaderBytes;
+            native_.resize((bytes + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+            char* copy = reinterpret_cast<char*>(native_.data());
+            std::memcpy(copy, base + kRouteHeaderBytes, bytes);
+            for (std::size_t c = 0; c < kRouteColumnCount; ++c) {
+                char* col = copy + (column_data_[c] - base - kRouteHeaderBytes);
+                for (std::size_t i = 0; i < count; ++i)
+                    std::reverse(col + i * kWidth[c], col + (i + 1) * kWidth[c]);
+                column_data_[c] = col;
+            }
+        } else if (reinterpret_cast<std::uintptr_t>(base) % kRouteColumnAlign != 0) {
+            // Columns sit at 8-byte offsets of a page-aligned mapping (or
+            // an allocator-aligned buffer in the fallback), so this only
+            // guards against an exotic InputFile.
+            close();
+            return fail(error, path, "mapping is not 8-byte aligned");
+        }
+        columns_.size         = count;
+        columns_.timestamp_ms = reinterpret_cast<const std::int64_t*>(column_data_[0]);
+        columns_.lat_e7       = reinterpret_cast<const std::int32_t*>(column_data_[1]);
+        columns_.lon_e7       = reinterpret_cast<const std::int32_t*>(column_data_[2]);
+        columns_.speed        = reinterpret_cast<const float*>(column_data_[3]);
+    } else if (count > column_bytes_[0]) {
+        // Every varint is at least one byte.
+        close();
+        return fail(error, path, "column length does not match record count");
+    }
+    count_ = count;
+    return true;
+}
+
+void RouteFile::close()
+{
+    file_.close();
+    count_    = 0;
+    encoding_ = RouteEncoding::kRaw;
+    for (std::size_t c = 0; c < kRouteColumnCount; ++c) {
+        column_data_[c]  = nullptr;
+        column_bytes_[c] = 0;
+    }
+    columns_ = RouteColumns{};
+    native_.clear();
+}
+
+bool RouteFile::load(std::vector<GpsRecord>& out, std::string& error) const
+{
+    out.resize(count_);
+    if (encoding_ == RouteEncoding::kRaw) {
+        for (std::size_t i = 0; i < count_; ++i)
+            out[i] = columns_[i];
+        return true;
+    }
+
+    const auto range = [&](std::size_t c) {
+        return std::make_pair(column_data_[c], column_data_[c] + column_bytes_[c]);
+    };
+    auto [t0, t1] = range(0);
+    auto [a0, a1] = range(1);
+    auto [o0, o1] = range(2);
+    auto [s0, s1] = range(3);
+    const bool ok =
+        decode_delta<std::uint64_t>(t0, t1, count_, [&](std::size_t i, std::uint64_t v) {
+            out[i].timestamp_ms = static_cast<std::int64_t>(v);
+        }) &&
+        decode_delta<std::uint32_t>(a0, a1, count_, [&](std::size_t i, std::uint32_t v) {
+            out[i].lat_e7 = static_cast<std::int32_t>(v);
+        }) &&
+        decode_delta<std::uint32_t>(o0, o1, count_, [&](std::size_t i, std::uint32_t v) {
+            out[i].lon_e7 = static_cast<std::int32_t>(v);
+        }) &&
+        decode_delta<std::uint32_t>(s0, s1, count_, [&](std::size_t i, std::uint32_t v) {
+            out[i].speed = from_bits<float>(v);
+        });
+    if (!ok) {
+        out.clear();
+        error = "corrupt delta-encoded route column";
+    }
+    return ok;
+}
+
+bool read_route_binary(const std::string& path, std::vector<GpsRecord>& out,
+                       std::string& error)
+{
+    RouteFile file;
+    return file.open(path, error) && file.load(out, error);
+}
@@ -0,0 +1,152 @@
+/*
+ * route_io.h — Route export (binary columnar, GeoJSON, CSV) and reload
+ */
+
+#ifndef ROUTE_IO_H
+#define ROUTE_IO_H
+
+#include "arena.h"
+#include "nmea_parser.h"
+#include "reader.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/// Binary route file layout (little-endian):
+///
+///   offset  size  field
+///        0     4  magic "NMRT"
+///        4     2  version (kRouteFileVersion)
+///        6     2  encoding (RouteEncoding)
+///        8     8  record count
+///       16    32  byte length of each column: timestamp, lat, lon, speed
+///       48     …  the four columns, each padded to an 8-byte boundary
+///
+/// kRaw stores the columns as plain int64 / int32 / int32 / float
+/// arrays (coordinates in GpsRecord's 1e-7 degree units), so a mapped
+/// file is usable in place on a little-endian host.  kDelta stores each column as zigzag varints
+/// of the difference from the previous value — of the integer timestamp
+/// and coordinates, and of the IEEE bit pattern for the speed, so
+/// decoding is exact.  Version 1 files held double coordinates.
+inline constexpr char          kRouteFileMagic[4]  = {'N', 'M', 'R', 'T'};
+inline constexpr std::uint16_t kRouteFileVersion   = 2;
+inline constexpr std::size_t   kRouteHeaderBytes   = 48;
+inline constexpr std::size_t   kRouteColumnCount   = 4;
+inline constexpr std::size_t   kRouteColumnAlign   = 8;
+
+/// Route and index files are little-endian on every host.  A big-endian
+/// host byte-swaps each field it stores or loads through these.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+inline constexpr bool kBigEndianHost = true;
+#else
+inline constexpr bool kBigEndianHost = false;
+#endif
+
+/// Store `value` at `p` (any alignment) in little-endian byte order.
+template <typename T>
+void store_le(char* p, T value)
+{
+    std::memcpy(p, &value, sizeof value);
+    if constexpr (kBigEndianHost)
+        std::reverse(p, p + sizeof value);
+}
+
+/// Load a little-endian `T` from `p` (any alignment).
+template <typename T>
+T load_le(const char* p)
+{
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, p, sizeof bytes);
+    if constexpr (kBigEndianHost)
+        std::reverse(bytes, bytes + sizeof bytes);
+    T value;
+    std::memcpy(&value, bytes, sizeof value);
+    return value;
+}
+
+/// Decimal places of the GeoJSON / CSV writers: every digit of a
+/// coordinate unit (1e-7°), so text exports lose nothing.
+inline constexpr int kExportCoordPrecision = 7;
+inline constexpr int kExportSpeedPrecision = 6;
+
+enum class RouteEncoding : std::uint16_t {
+    kRaw   = 0,   // fixed-width columns, mappable in place
+    kDelta = 1,   // delta + zigzag varints, roughly half the size
+};
+
+/// Column view of a route: one array per field.
+struct RouteColumns {
+    std::size_t         size         = 0;
+    const std::int64_t* timestamp_ms = nullptr;
+    const std::int32_t* lat_e7       = nullptr;
+    const std::int32_t* lon_e7       = nullptr;
+    const float*        speed        = nullptr;
+
+    GpsRecord operator[](std::size_t i) const
+    {
+        return {timestamp_ms[i], lat_e7[i], lon_e7[i], speed[i]};
+    }
+};
+
+// ─── Writers ────────────────────────────────────────────────────────────────
+//
+// Each writer creates or truncates `path` ("-" = stdout) and returns false
+// with `error` set if it can't be opened or written.
+
+/// Write `route` as a binary columnar route file.
+bool write_route_binary(Span<const GpsRecord> route, const std::string& path,
+                        RouteEncoding encoding, std::string& error);
+
+/// Write `route` as a GeoJSON FeatureCollection of Point features, each
+/// carrying `timestamp_ms` and `speed_mps` properties.
+bool write_route_geojson(Span<const GpsRecord> route, const std::string& path,
+                         std::string& error);
+
+/// Write `route` as CSV: `timestamp_ms,latitude,longitude,speed_mps`.
+bool write_route_csv(Span<const GpsRecord> route, const std::string& path,
+                     std::string& error);
+
+// ─── Reader ─────────────────────────────────────────────────────────────────
+
+/// A binary route file mapped read-only (see InputFile).  `open` checks
+/// the header and column lengths against the file size; for kRaw files
+/// `columns()` then points straight into the mapping, with no copy or
+/// decode (on a big-endian host, into a byte-swapped copy made by
+/// `open`).  `load` works for either encoding.
+class RouteFile {
+public:
+    /// Map and validate `path`.  Returns false and sets `error` if it
+    /// can't be read or is not a well-formed route file.
+    bool open(const std::string& path, std::string& error);
+
+    void close();
+
+    std::size_t   size() const     { return count_; }
+    RouteEncoding encoding() const { return encoding_; }
+
+    /// In-place columns of a kRaw file; empty for kDelta.
+    const RouteColumns& columns() const { return columns_; }
+
+    /// Decode every record into `out` (replacing its contents).  Returns
+    /// false and sets `error` if a kDelta column is truncated or corrupt.
+    bool load(std::vector<GpsRecord>& out, std::string& error) const;
+
+private:
+    InputFile     file_;
+    std::size_t   count_    = 0;
+    RouteEncoding encoding_ = RouteEncoding::kRaw;
+    const char*   column_data_[kRouteColumnCount]  = {};
+    std::size_t   column_bytes_[kRouteColumnCount] = {};
+    RouteColumns  columns_;
+    std::vector<std::uint64_t> native_;   // big-endian host: kRaw columns swapped
+};
+
+/// Convenience: open `path` and load it into `out`.
+bool read_route_binary(const std::string& path, std::vector<GpsRecord>& out,
+                       std::string& error);
+
+#endif // ROUTE_IO_H
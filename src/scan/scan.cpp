@@ -0,0 +1,265 @@
+/*
+ * scan.cpp — Vectorised single-pass sentence scanner (checksum + delimiters)
+ *
+ * Each kernel walks the line in vector-width blocks.  Per block it
+ * XOR-accumulates the bytes, and compares against ',' and '*' to extract
+ * bitmasks.  Because XOR is its own inverse, the checksum of [1, star) is
+ * obtained afterwards from the total by folding out byte 0 and the short
+ * "*HH" tail — so no second pass is needed once the last '*' is known.
+ */
+
+#include "scan.h"
+
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  if defined(__SSE2__)
+#    include <immintrin.h>
+#    define SCAN_HAVE_SSE2 1
+#    if defined(__GNUC__)
+#      define SCAN_HAVE_AVX2 1
+#    endif
+#  endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#  include <arm_neon.h>
+#  define SCAN_HAVE_NEON 1
+#endif
+
+// ─── Scan constants ────────────────────────────────────────────────────────
+
+static constexpr char kScanStar  = '*';
+static constexpr char kScanComma = ',';
+
+using ScanKernel = void (*)(const char*, std::size_t, SentenceScan&);
+
+// ─── Shared helpers ─────────────────────────────────────────────────────────
+
+/// Record a block's comma bits (block starts at byte `pos`).
+static inline void store_mask_bits(SentenceScan& out, std::size_t pos,
+                                   std::uint64_t bits)
+{
+    if (bits == 0 || pos >= kScanMaskBytes)
+        return;
+    out.comma_mask[pos / 64] |= bits << (pos % 64);
+}
+
+/// Scalar handling of bytes [i, n): folds into `total`, updates masks.
+static inline void scan_tail(const char* p, std::size_t i, std::size_t n,
+                             std::uint8_t& total, SentenceScan& out)
+{
+    for (; i < n; ++i) {
+        total ^= static_cast<std::uint8_t>(p[i]);
+        if (p[i] == kScanStar)
+            out.star = i;
+        else if (p[i] == kScanComma && i < kScanMaskBytes)
+            out.comma_mask[i / 64] |= std::uint64_t{1} << (i % 64);
+    }
+}
+
+/// Turn the XOR of every byte into the XOR of [1, star).
+static inline void finish_scan(const char* p, std::size_t n, std::uint8_t total,
+                               SentenceScan& out)
+{
+    out.mask_complete = n <= kScanMaskBytes;
+    if (out.star == std::string_view::npos || out.star == 0)
+        return;     // no '*', or nothing between byte 0 and it
+    total ^= static_cast<std::uint8_t>(p[0]);
+    for (std::size_t i = out.star; i < n; ++i)
+        total ^= static_cast<std::uint8_t>(p[i]);
+    out.xor_sum = total;
+}
+
+#if defined(SCAN_HAVE_SSE2) || defined(SCAN_HAVE_NEON)
+/// Index of the highest set bit of a non-zero mask.
+static inline unsigned highest_bit(std::uint32_t m)
+{
+    return 31u - static_cast<unsigned>(__builtin_clz(m));
+}
+#endif
+
+// ─── Scalar kernel ──────────────────────────────────────────────────────────
+
+static void scan_scalar(const char* p, std::size_t n, SentenceScan& out)
+{
+    std::uint8_t total = 0;
+    scan_tail(p, 0, n, total, out);
+    finish_scan(p, n, total, out);
+}
+
+// ─── SSE2 kernel (16-byte blocks) ───────────────────────────────────────────
+
+#if defined(SCAN_HAVE_SSE2)
+
+static inline std::uint8_t hxor128(__m128i v)
+{
+    v = _mm_xor_si128(v, _mm_srli_si128(v, 8));
+    v = _mm_xor_si128(v, _mm_srli_si128(v, 4));
+    v = _mm_xor_si128(v, _mm_srli_si128(v, 2));
+    v = _mm_xor_si128(v, _mm_srli_si128(v, 1));
+    return static_cast<std::uint8_t>(_mm_cvtsi128_si32(v) & 0xFF);
+}
+
+static void scan_sse2(const char* p, std::size_t n, SentenceScan& out)
+{
+    const __m128i comma = _mm_set1_epi8(kScanComma);
+    const __m128i star  = _mm_set1_epi8(kScanStar);
+    __m128i acc = _mm_setzero_si128();
+
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        acc = _mm_xor_si128(acc, v);
+        auto cm = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, comma)));
+        auto sm = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, star)));
+        store_mask_bits(out, i, cm);
+        if (sm)
+            out.star = i + highest_bit(sm);
+    }
+
+    std::uint8_t total = hxor128(acc);
+    scan_tail(p, i, n, total, out);
+    finish_scan(p, n, total, out);
+}
+
+#endif // SCAN_HAVE_SSE2
+
+// ─── AVX2 kernel (32-byte blocks) ───────────────────────────────────────────
+
+#if defined(SCAN_HAVE_AVX2)
+
+__attribute__((target("avx2")))
+static void scan_avx2(const char* p, std::size_t n, SentenceScan& out)
+{
+    const __m256i comma = _mm256_set1_epi8(kScanComma);
+    const __m256i star  = _mm256_set1_epi8(kScanStar);
+    __m256i acc = _mm256_setzero_si256();
+
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        acc = _mm256_xor_si256(acc, v);
+        auto cm = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, comma)));
+        auto sm = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, star)));
+        store_mask_bits(out, i, cm);
+        if (sm)
+            out.star = i + highest_bit(sm);
+    }
+
+    __m128i acc128 = _mm_xor_si128(_mm256_castsi256_si128(acc),
+                                   _mm256_extracti128_si256(acc, 1));
+    // One 16-byte step narrows the scalar tail to < 16 bytes.
+    if (i + 16 <= n) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        acc128 = _mm_xor_si128(acc128, v);
+        auto cm = static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm256_castsi256_si128(comma))));
+        auto sm = static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm256_castsi256_si128(star))));
+        store_mask_bits(out, i, cm);
+        if (sm)
+            out.star = i + highest_bit(sm);
+        i += 16;
+    }
+
+    std::uint8_t total = hxor128(acc128);
+    scan_tail(p, i, n, total, out);
+    finish_scan(p, n, total, out);
+}
+
+#endif // SCAN_HAVE_AVX2
+
+// ─── NEON kernel (16-byte blocks, AArch64) ──────────────────────────────────
+
+#if defined(SCAN_HAVE_NEON)
+
+/// Compress a 0x00/0xFF byte-compare result into a 16-bit mask.
+static inline std::uint32_t neon_movemask(uint8x16_t cmp)
+{
+    static const uint8_t kBitWeights[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                            1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t bits = vandq_u8(cmp, vld1q_u8(kBitWeights));
+    return vaddv_u8(vget_low_u8(bits)) |
+           (static_cast<std::uint32_t>(vaddv_u8(vget_high_u8(bits))) << 8);
+}
+
+static void scan_neon(const char* p, std::size_t n, SentenceScan& out)
+{
+    const uint8x16_t comma = vdupq_n_u8(static_cast<uint8_t>(kScanComma));
+    const uint8x16_t star  = vdupq_n_u8(static_cast<uint8_t>(kScanStar));
+    uint8x16_t acc = vdupq_n_u8(0);
+
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p + i));
+        acc = veorq_u8(acc, v);
+        store_mask_bits(out, i, neon_movemask(vceqq_u8(v, comma)));
+        if (std::uint32_t sm = neon_movemask(vceqq_u8(v, star)))
+            out.star = i + highest_bit(sm);
+    }
+
+    uint8x8_t x = veor_u8(vget_low_u8(acc), vget_high_u8(acc));
+    std::uint64_t lanes = vget_lane_u64(vreinterpret_u64_u8(x), 0);
+    lanes ^= lanes >> 32;
+    lanes ^= lanes >> 16;
+    lanes ^= lanes >> 8;
+    std::uint8_t total = static_cast<std::uint8_t>(lanes);
+    scan_tail(p, i, n, total, out);
+    finish_scan(p, n, total, out);
+}
+
+#endif // SCAN_HAVE_NEON
+
+// ─── Runtime dispatch ───────────────────────────────────────────────────────
+
+struct KernelChoice {
+    ScanKernel  fn;
+    const char* name;
+};
+
+static KernelChoice select_kernel()
+{
+#if defined(SCAN_HAVE_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return {scan_avx2, "avx2"};
+#endif
+#if defined(SCAN_HAVE_SSE2)
+    return {scan_sse2, "sse2"};
+#elif defined(SCAN_HAVE_NEON)
+    return {scan_neon, "neon"};
+#else
+    return {scan_scalar, "scalar"};
+#endif
+}
+
+/// CPU probe runs once, on first use (safe during static initialisation).
+static const KernelChoice& best_kernel()
+{
+    static const KernelChoice choice = select_kernel();
+    return choice;
+}
+
+static std::atomic<bool> g_force_scalar{false};
+
+void scan_sentence(std::string_view s, SentenceScan& out)
+{
+    out = SentenceScan{};
+    if (s.empty()) {
+        out.mask_complete = true;
+        return;
+    }
+    ScanKernel fn = g_force_scalar.load(std::memory_order_relaxed)
+                        ? scan_scalar : best_kernel().fn;
+    fn(s.data(), s.size(), out);
+}
+
+const char* scan_kernel_name()
+{
+    return g_force_scalar.load(std::memory_order_relaxed) ? "scalar"
+                                                          : best_kernel().name;
+}
+
+void scan_force_scalar(bool force)
+{
+    g_force_scalar.store(force, std::memory_order_relaxed);
+}
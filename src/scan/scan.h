@@ -0,0 +1,40 @@
+/*
+ * scan.h — Vectorised single-pass sentence scanner (checksum + delimiters)
+ */
+
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/// Bytes covered by the delimiter bitmask.  NMEA 0183 caps a sentence at
+/// 82 characters, so real sentences always fit; longer lines still get a
+/// correct checksum but `mask_complete` is false.
+inline constexpr std::size_t kScanMaskBytes = 128;
+inline constexpr std::size_t kScanMaskWords = kScanMaskBytes / 64;
+
+/// Everything the validation passes need from one sweep over a sentence.
+struct SentenceScan {
+    std::size_t   star = std::string_view::npos;  // index of the last '*'
+    std::uint8_t  xor_sum = 0;                    // XOR of bytes [1, star)
+    bool          mask_complete = false;          // line fits in comma_mask
+    std::uint64_t comma_mask[kScanMaskWords] = {};  // bit i ⇔ byte i is ','
+};
+
+/// Scan `s` once: locate the last '*', XOR-fold the bytes between the
+/// leading '$' and that '*', and record every ',' in a bitmask.  Uses the
+/// widest kernel the CPU supports (AVX2 / SSE2 / NEON), picked at first
+/// use; a scalar kernel is the portable fallback.
+void scan_sentence(std::string_view s, SentenceScan& out);
+
+/// Name of the kernel `scan_sentence` dispatches to: "avx2", "sse2",
+/// "neon" or "scalar".
+const char* scan_kernel_name();
+
+/// Test/benchmark hook: force the portable scalar kernel (true) or go
+/// back to runtime selection (false).
+void scan_force_scalar(bool force);
+
+#endif // SCAN_H
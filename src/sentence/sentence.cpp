@@ -0,0 +1,134 @@
+/*
+ * sentence.cpp — Table-driven NMEA sentence classification
+ */
+
+#include "sentence.h"
+
+#include <array>
+#include <cstring>
+
+// ─── Sentence identification constants ─────────────────────────────────────
+
+static constexpr char        kNmeaStart      = '$';
+static constexpr char        kNmeaFieldDelim = ',';
+static constexpr std::size_t kIdLen          = 6;          // "$TTSSS"
+static constexpr std::size_t kTalkerShift    = 8;          // skip the '$'
+static constexpr std::size_t kTypeShift      = 24;         // skip "$TT"
+static constexpr std::uint64_t kTalkerMask   = 0xFFFF;     // two bytes
+static constexpr std::uint64_t kTypeMask     = 0xFFFFFF;   // three bytes
+
+// ─── Lookup tables (generated at compile time) ─────────────────────────────
+
+namespace {
+
+struct TalkerEntry {
+    std::uint64_t code;
+    Talker        talker;
+    const char*   name;
+};
+
+struct TypeEntry {
+    std::uint64_t code;
+    SentenceType  type;
+    const char*   name;
+};
+
+constexpr std::array<TalkerEntry, kTalkerCount - 1> kTalkers = {{
+    {pack_sentence_tag("GP"), Talker::kGP, "GP"},
+    {pack_sentence_tag("GN"), Talker::kGN, "GN"},
+    {pack_sentence_tag("GL"), Talker::kGL, "GL"},
+    {pack_sentence_tag("GA"), Talker::kGA, "GA"},
+    {pack_sentence_tag("BD"), Talker::kBD, "BD"},
+}};
+
+constexpr std::array<TypeEntry, kSentenceTypeCount - 1> kTypes = {{
+    {pack_sentence_tag("RMC"), SentenceType::kRMC, "RMC"},
+    {pack_sentence_tag("GGA"), SentenceType::kGGA, "GGA"},
+    {pack_sentence_tag("GSA"), SentenceType::kGSA, "GSA"},
+    {pack_sentence_tag("VTG"), SentenceType::kVTG, "VTG"},
+    {pack_sentence_tag("GSV"), SentenceType::kGSV, "GSV"},
+}};
+
+using HandlerTable = std::array<std::array<SentenceHandler, kSentenceTypeCount>, kTalkerCount>;
+
+/// Talker × type → handler.  Only GPS and multi-constellation sentences
+/// feed the pipeline; add a row/column entry here to handle a new type.
+constexpr HandlerTable make_handler_table(bool fuse)
+{
+    HandlerTable t{};   // value-initialised: kUnsupported
+    for (Talker talker : {Talker::kGP, Talker::kGN}) {
+        auto& row = t[static_cast<std::size_t>(talker)];
+        row[static_cast<std::size_t>(SentenceType::kRMC)] = SentenceHandler::kRmc;
+        row[static_cast<std::size_t>(SentenceType::kGGA)] =
+            fuse ? SentenceHandler::kGga : SentenceHandler::kNotRelevant;
+        row[static_cast<std::size_t>(SentenceType::kGSA)] =
+            fuse ? SentenceHandler::kGsa : SentenceHandler::kNotRelevant;
+    }
+    return t;
+}
+
+constexpr HandlerTable kHandlers       = make_handler_table(false);
+constexpr HandlerTable kFusionHandlers = make_handler_table(true);
+
+// Each table's position must match its enumerator for the name lookups.
+constexpr bool tables_in_enum_order()
+{
+    for (std::size_t i = 0; i < kTalkers.size(); ++i)
+        if (static_cast<std::size_t>(kTalkers[i].talker) != i + 1)
+            return false;
+    for (std::size_t i = 0; i < kTypes.size(); ++i)
+        if (static_cast<std::size_t>(kTypes[i].type) != i + 1)
+            return false;
+    return true;
+}
+static_assert(tables_in_enum_order(), "lookup tables out of enum order");
+
+} // namespace
+
+// ─── Public API ─────────────────────────────────────────────────────────────
+
+SentenceId classify_sentence(std::string_view sentence)
+{
+    SentenceId id;
+    if (sentence.size() <= kIdLen || sentence[0] != kNmeaStart ||
+        sentence[kIdLen] != kNmeaFieldDelim)
+        return id;
+
+    // One unaligned 8-byte load when the view is long enough, else bytewise.
+    std::uint64_t key;
+    if (sentence.size() >= sizeof key) {
+        std::memcpy(&key, sentence.data(), sizeof key);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        key = __builtin_bswap64(key);
+#endif
+    } else {
+        key = pack_sentence_tag(sentence);
+    }
+
+    const std::uint64_t talker = (key >> kTalkerShift) & kTalkerMask;
+    const std::uint64_t type   = (key >> kTypeShift) & kTypeMask;
+    for (const auto& e : kTalkers)
+        if (e.code == talker) { id.talker = e.talker; break; }
+    for (const auto& e : kTypes)
+        if (e.code == type) { id.type = e.type; break; }
+    if (!id.known())
+        id = SentenceId{};
+    return id;
+}
+
+SentenceHandler sentence_handler(SentenceId id, bool fuse)
+{
+    const HandlerTable& table = fuse ? kFusionHandlers : kHandlers;
+    return table[static_cast<std::size_t>(id.talker)]
+                [static_cast<std::size_t>(id.type)];
+}
+
+const char* talker_name(Talker t)
+{
+    return t == Talker::kUnknown ? "??" : kTalkers[static_cast<std::size_t>(t) - 1].name;
+}
+
+const char* sentence_type_name(SentenceType t)
+{
+    return t == SentenceType::kUnknown ? "???" : kTypes[static_cast<std::size_t>(t) - 1].name;
+}
@@ -0,0 +1,81 @@
+/*
+ * sentence.h — Table-driven NMEA sentence classification
+ *
+ * A sentence is identified from its first six bytes ("$TTSSS") as one
+ * packed integer, split into talker and type and looked up in small
+ * constexpr tables; no substrings, no string compares.
+ */
+
+#ifndef SENTENCE_H
+#define SENTENCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/// Talker IDs we recognise (bytes 1–2).
+enum class Talker : std::uint8_t {
+    kUnknown,
+    kGP,    // GPS
+    kGN,    // multi-constellation
+    kGL,    // GLONASS
+    kGA,    // Galileo
+    kBD,    // BeiDou
+};
+
+/// Sentence formatters we recognise (bytes 3–5).
+enum class SentenceType : std::uint8_t {
+    kUnknown,
+    kRMC,   // recommended minimum
+    kGGA,   // fix data
+    kGSA,   // DOP and active satellites
+    kVTG,   // track and ground speed
+    kGSV,   // satellites in view
+};
+
+inline constexpr std::size_t kTalkerCount       = 6;   // including kUnknown
+inline constexpr std::size_t kSentenceTypeCount = 6;   // including kUnknown
+
+/// Classified sentence.  Both parts are kUnknown unless the line starts
+/// with '$', a recognised talker and type, and a ',' right after the ID.
+struct SentenceId {
+    Talker       talker = Talker::kUnknown;
+    SentenceType type   = SentenceType::kUnknown;
+
+    bool known() const
+    {
+        return talker != Talker::kUnknown && type != SentenceType::kUnknown;
+    }
+};
+
+/// What the pipeline does with a classified sentence.
+enum class SentenceHandler : std::uint8_t {
+    kUnsupported,   // unrecognised or not handled — counted as a parse failure
+    kNotRelevant,   // recognised, deliberately skipped
+    kRmc,           // decoded by the RMC parser
+    kGga,           // decoded for epoch fusion (--fuse only)
+    kGsa,           // decoded for epoch fusion (--fuse only)
+};
+
+/// Pack up to the first 6 bytes of `tag` little-endian into an integer:
+/// the byte at offset i lands in bits [8i, 8i+8).
+constexpr std::uint64_t pack_sentence_tag(std::string_view tag)
+{
+    std::uint64_t v = 0;
+    for (std::size_t i = 0; i < tag.size() && i < 6; ++i)
+        v |= static_cast<std::uint64_t>(static_cast<unsigned char>(tag[i])) << (8 * i);
+    return v;
+}
+
+/// Identify talker and type from the sentence prefix.
+SentenceId classify_sentence(std::string_view sentence);
+
+/// Dispatch-table lookup: the handler for `id`.  With `fuse`, GGA and GSA
+/// map to their decoders instead of kNotRelevant.
+SentenceHandler sentence_handler(SentenceId id, bool fuse = false);
+
+/// "GP", "RMC", … ("??" / "???" for kUnknown).
+const char* talker_name(Talker t);
+const char* sentence_type_name(SentenceType t);
+
+#endif // SENTENCE_H
@@ -0,0 +1,467 @@
+/*
+ * spatial.cpp — Metric spatial dedup and route simplification
+ */
+
+#include "spatial.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <queue>
+#include <utility>
+
+// ─── Spatial constants ─────────────────────────────────────────────────────
+
+static constexpr double      kPi       = 3.14159265358979323846;
+static constexpr double      kDegToRad = kPi / 180.0;
+static constexpr std::size_t kMaxBlock = 256;   // scores computed per vector pass
+static constexpr std::size_t kFirstBlock = 8;
+
+// ─── Internal helpers ───────────────────────────────────────────────────────
+
+namespace {
+
+// The metre metrics below are only used for kEquirectangular and
+// kHaversine; kDegrees is served by dedup_spatial / SpatialFilter.
+
+/// Everything a distance test needs about one point, derived once.
+struct Point {
+    double lat = 0.0, lon = 0.0;           // radians
+    double cos_lat = 0.0;
+    double sin_hlat = 0.0, cos_hlat = 0.0; // sin/cos of lat/2 (haversine only)
+    double sin_hlon = 0.0, cos_hlon = 0.0; // sin/cos of lon/2 (haversine only)
+};
+
+Point make_point(const GpsRecord& rec, bool haversine)
+{
+    Point p;
+    p.lat = rec.latitude() * kDegToRad;
+    p.lon = rec.longitude() * kDegToRad;
+    if (!haversine) {
+        p.cos_lat = std::cos(p.lat);
+        return p;
+    }
+    p.sin_hlat = std::sin(p.lat * 0.5);
+    p.cos_hlat = std::cos(p.lat * 0.5);
+    p.sin_hlon = std::sin(p.lon * 0.5);
+    p.cos_hlon = std::cos(p.lon * 0.5);
+    p.cos_lat  = (p.cos_hlat - p.sin_hlat) * (p.cos_hlat + p.sin_hlat);   // cos 2x
+    return p;
+}
+
+/// Structure-of-arrays form of `Point` for a whole route.
+struct PointColumns {
+    bool                haversine;
+    std::vector<double> lat, lon, cos_lat, sin_hlat, cos_hlat, sin_hlon, cos_hlon;
+
+    /// Columns for records[order[0..n)], or records[0..n) if `order` is null.
+    PointColumns(Span<const GpsRecord> records, const std::uint32_t* order, std::size_t n,
+                 bool use_haversine)
+        : haversine(use_haversine)
+    {
+        lat.resize(n);
+        lon.resize(n);
+        cos_lat.resize(n);
+        if (haversine) {
+            sin_hlat.resize(n); cos_hlat.resize(n);
+            sin_hlon.resize(n); cos_hlon.resize(n);
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            const Point p = make_point(records[order ? order[i] : i], haversine);
+            lat[i]     = p.lat;
+            lon[i]     = p.lon;
+            cos_lat[i] = p.cos_lat;
+            if (haversine) {
+                sin_hlat[i] = p.sin_hlat; cos_hlat[i] = p.cos_hlat;
+                sin_hlon[i] = p.sin_hlon; cos_hlon[i] = p.cos_hlon;
+            }
+        }
+    }
+
+    Point at(std::size_t i) const
+    {
+        Point p;
+        p.lat     = lat[i];
+        p.lon     = lon[i];
+        p.cos_lat = cos_lat[i];
+        if (haversine) {
+            p.sin_hlat = sin_hlat[i]; p.cos_hlat = cos_hlat[i];
+            p.sin_hlon = sin_hlon[i]; p.cos_hlon = cos_hlon[i];
+        }
+        return p;
+    }
+};
+
+/// Wrap a longitude difference in radians into [-π, π].
+inline double wrap_lon(double d)
+{
+    return d > kPi ? d - 2.0 * kPi : (d < -kPi ? d + 2.0 * kPi : d);
+}
+
+// Distance scores of a point against anchor `a`.  Each score is monotonic
+// in distance and avoids sqrt/asin, so "farther than the threshold" is a
+// single compare.  The same inline code serves the vector loops and the
+// one-at-a-time RouteFilter, so both make identical decisions.
+
+inline double score_equirect(double lat, double lon, const Point& a)
+{
+    const double dy = lat - a.lat;
+    const double dx = wrap_lon(lon - a.lon) * a.cos_lat;
+    return dx * dx + dy * dy;   // (distance / R)²
+}
+
+inline double score_haversine(double sh_lat, double ch_lat, double sh_lon,
+                              double ch_lon, double c_lat, const Point& a)
+{
+    const double s1 = sh_lat * a.cos_hlat - ch_lat * a.sin_hlat;   // sin(Δφ/2)
+    const double s2 = sh_lon * a.cos_hlon - ch_lon * a.sin_hlon;   // sin(Δλ/2)
+    return s1 * s1 + c_lat * a.cos_lat * s2 * s2;                  // haversine "a"
+}
+
+inline double score_point(const Point& p, const Point& a, bool haversine)
+{
+    return haversine
+        ? score_haversine(p.sin_hlat, p.cos_hlat, p.sin_hlon, p.cos_hlon, p.cos_lat, a)
+        : score_equirect(p.lat, p.lon, a);
+}
+
+/// Score threshold equivalent to a distance of `epsilon_m`.
+double score_threshold(double epsilon_m, bool haversine)
+{
+    if (haversine) {
+        const double s = std::sin(epsilon_m / (2.0 * kEarthRadiusM));
+        return s * s;
+    }
+    const double r = epsilon_m / kEarthRadiusM;
+    return r * r;
+}
+
+/// Scores for points [begin, end) against `a` into `out` — a straight
+/// loop over the columns with no branches for the compiler to vectorise.
+void score_block(const PointColumns& c, std::size_t begin, std::size_t end,
+                 const Point& a, double* out)
+{
+    const std::size_t n = end - begin;
+    const double* lat = c.lat.data() + begin;
+    const double* lon = c.lon.data() + begin;
+    const double* cl  = c.cos_lat.data() + begin;
+    if (!c.haversine) {
+        for (std::size_t k = 0; k < n; ++k)
+            out[k] = score_equirect(lat[k], lon[k], a);
+        return;
+    }
+    const double* shl = c.sin_hlat.data() + begin;
+    const double* chl = c.cos_hlat.data() + begin;
+    const double* sho = c.sin_hlon.data() + begin;
+    const double* cho = c.cos_hlon.data() + begin;
+    for (std::size_t k = 0; k < n; ++k)
+        out[k] = score_haversine(shl[k], chl[k], sho[k], cho[k], cl[k], a);
+}
+
+/// Metre-metric jitter scan over `cols`, calling `keep(k)` for every
+/// position k that belongs on the route.
+template <typename Keep>
+void keep_far_points(const PointColumns& cols, const SpatialOptions& opts, Keep&& keep)
+{
+    const std::size_t n = cols.lat.size();
+    if (n == 0)
+        return;
+
+    // The kept point is the anchor for every later comparison, so the
+    // scan is sequential in anchors — but between two kept points every
+    // candidate is scored against the same anchor.  Score a block at a
+    // time (vectorised), then pick the first one over the threshold.  The
+    // block size follows the last gap between kept points: ~1 on a moving
+    // route, large when parked and everything is jitter.
+    const double thresh = score_threshold(opts.epsilon_m, cols.haversine);
+    std::array<double, kMaxBlock> scores;
+
+    keep(0);
+    Point       anchor = cols.at(0);
+    std::size_t block  = kFirstBlock;
+    std::size_t i      = 1;
+    while (i < n) {
+        const std::size_t end = std::min(n, i + block);
+        score_block(cols, i, end, anchor, scores.data());
+
+        std::size_t hit = end;
+        for (std::size_t k = i; k < end; ++k) {
+            if (scores[k - i] > thresh) {
+                hit = k;
+                break;
+            }
+        }
+        if (hit == end) {
+            i     = end;
+            block = std::min(block * 2, kMaxBlock);
+            continue;
+        }
+        keep(hit);
+        anchor = cols.at(hit);
+        block  = hit - i + 1;
+        i      = hit + 1;
+    }
+}
+
+/// Local equirectangular projection of a route to metres (SoA), centred
+/// on the first point with the route's mean latitude as scale.
+struct Projected {
+    std::vector<double> x, y;
+
+    explicit Projected(const std::vector<GpsRecord>& route)
+        : x(route.size()), y(route.size())
+    {
+        if (route.empty())
+            return;
+        double mean_lat = 0.0;
+        for (const auto& r : route)
+            mean_lat += r.latitude();
+        mean_lat /= static_cast<double>(route.size());
+
+        const double kx   = kEarthRadiusM * std::cos(mean_lat * kDegToRad);
+        const double lat0 = route[0].latitude() * kDegToRad;
+        const double lon0 = route[0].longitude() * kDegToRad;
+        for (std::size_t i = 0; i < route.size(); ++i) {
+            x[i] = kx * wrap_lon(route[i].longitude() * kDegToRad - lon0);
+            y[i] = kEarthRadiusM * (route[i].latitude() * kDegToRad - lat0);
+        }
+    }
+};
+
+/// Triangle area (m²) of points a, b, c in the projection.
+inline double triangle_area(const Projected& p, std::size_t a, std::size_t b, std::size_t c)
+{
+    return 0.5 * std::fabs(p.x[a] * (p.y[b] - p.y[c]) +
+                           p.x[b] * (p.y[c] - p.y[a]) +
+                           p.x[c] * (p.y[a] - p.y[b]));
+}
+
+std::vector<GpsRecord> gather(const std::vector<GpsRecord>& route,
+                              const std::vector<std::uint8_t>& keep)
+{
+    std::vector<GpsRecord> out;
+    for (std::size_t i = 0; i < route.size(); ++i)
+        if (keep[i])
+            out.push_back(route[i]);
+    return out;
+}
+
+} // namespace
+
+// ─── Public API ─────────────────────────────────────────────────────────────
+
+double distance_m(const GpsRecord& a, const GpsRecord& b, SpatialMetric metric)
+{
+    const bool   haversine = metric != SpatialMetric::kEquirectangular;
+    const double score     = score_point(make_point(b, haversine), make_point(a, haversine),
+                                         haversine);
+    return haversine ? 2.0 * kEarthRadiusM * std::asin(std::sqrt(std::min(1.0, score)))
+                     : kEarthRadiusM * std::sqrt(score);
+}
+
+std::vector<GpsRecord>
+dedup_spatial_metric(const std::vector<GpsRecord>& records, const SpatialOptions& opts)
+{
+    // The per-axis degree test is already a couple of compares per point.
+    if (opts.metric == SpatialMetric::kDegrees)
+        return dedup_spatial(records, opts.epsilon_deg);
+
+    const PointColumns cols(records, nullptr, records.size(),
+                            opts.metric == SpatialMetric::kHaversine);
+    std::vector<GpsRecord> result;
+    result.reserve(records.size());
+    keep_far_points(cols, opts, [&](std::size_t k) { result.push_back(records[k]); });
+    return result;
+}
+
+Span<std::uint32_t>
+dedup_spatial_metric_indices(Span<const GpsRecord> records, Span<const std::uint32_t> order,
+                             const SpatialOptions& opts, Arena& arena)
+{
+    if (opts.metric == SpatialMetric::kDegrees)
+        return dedup_spatial_indices(records, order, opts.epsilon_deg, arena);
+
+    const PointColumns cols(records, order.data(), order.size(),
+                            opts.metric == SpatialMetric::kHaversine);
+    auto* out = arena.allocate_array<std::uint32_t>(order.size());
+    std::size_t n = 0;
+    keep_far_points(cols, opts, [&](std::size_t k) { out[n++] = order[k]; });
+    return {out, n};
+}
+
+std::size_t dedup_spatial_metric_in_place(Span<GpsRecord> records, const SpatialOptions& opts)
+{
+    if (opts.metric == SpatialMetric::kDegrees)
+        return dedup_spatial_in_place(records, opts.epsilon_deg);
+
+    // The columns are a snapshot, so compacting `records` while the scan
+    // runs is safe (positions only ever move forward).
+    const PointColumns cols(records, nullptr, records.size(),
+                            opts.metric == SpatialMetric::kHaversine);
+    std::size_t n = 0;
+    keep_far_points(cols, opts, [&](std::size_t k) { records[n++] = records[k]; });
+    return n;
+}
+
+void dedup_spatial_metric_in_place(std::vector<GpsRecord>& records, const SpatialOptions& opts)
+{
+    records.resize(dedup_spatial_metric_in_place(Span<GpsRecord>(records), opts));
+}
+
+std::vector<GpsRecord>
+simplify_douglas_peucker(const std::vector<GpsRecord>& route, double tolerance_m)
+{
+    const std::size_t n = route.size();
+    if (n < 3)
+        return route;
+
+    const Projected p(route);
+    std::vector<std::uint8_t> keep(n, 0);
+    std::vector<double>       dist2(n);
+    keep[0] = keep[n - 1] = 1;
+    const double tol2 = tolerance_m * tolerance_m;
+
+    std::vector<std::pair<std::size_t, std::size_t>> stack{{0, n - 1}};
+    while (!stack.empty()) {
+        const auto [a, b] = stack.back();
+        stack.pop_back();
+        if (b - a < 2)
+            continue;
+
+        // Squared distance of every interior point to segment a–b.
+        const double ax = p.x[a], ay = p.y[a];
+        const double dx = p.x[b] - ax, dy = p.y[b] - ay;
+        const double len2 = dx * dx + dy * dy;
+        const double inv  = len2 > 0.0 ? 1.0 / len2 : 0.0;
+        const double* xs = p.x.data();
+        const double* ys = p.y.data();
+        double* d2 = dist2.data();
+        for (std::size_t k = a + 1; k < b; ++k) {
+            const double rx = xs[k] - ax, ry = ys[k] - ay;
+            const double t  = std::min(1.0, std::max(0.0, (rx * dx + ry * dy) * inv));
+            const double ex = rx - t * dx, ey = ry - t * dy;
+            d2[k] = ex * ex + ey * ey;
+        }
+        double worst = 0.0;
+        for (std::size_t k = a + 1; k < b; ++k)
+            worst = std::max(worst, d2[k]);
+        if (worst <= tol2)
+            continue;
+
+        std::size_t split = a + 1;
+        while (d2[split] != worst)
+            ++split;
+        keep[split] = 1;
+        stack.push_back({a, split});
+        stack.push_back({split, b});
+    }
+    return gather(route, keep);
+}
+
+std::vector<GpsRecord>
+simplify_visvalingam(const std::vector<GpsRecord>& route, double min_area_m2)
+{
+    const std::size_t n = route.size();
+    if (n < 3)
+        return route;
+
+    const Projected p(route);
+    std::vector<double>      area(n, 0.0);
+    std::vector<std::size_t> prev(n), next(n);
+    std::vector<std::uint8_t> keep(n, 1);
+    for (std::size_t i = 0; i < n; ++i) {
+        prev[i] = i - 1;   // wraps for i = 0; never read for endpoints
+        next[i] = i + 1;
+    }
+    for (std::size_t i = 1; i + 1 < n; ++i)
+        area[i] = triangle_area(p, i - 1, i, i + 1);
+
+    using Entry = std::pair<double, std::size_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+    for (std::size_t i = 1; i + 1 < n; ++i)
+        heap.push({area[i], i});
+
+    while (!heap.empty()) {
+        const auto [a, i] = heap.top();
+        heap.pop();
+        if (!keep[i] || a != area[i])
+            continue;                    // removed, or superseded entry
+        if (a >= min_area_m2)
+            break;
+
+        keep[i] = 0;
+        const std::size_t l = prev[i], r = next[i];
+        next[l] = r;
+        prev[r] = l;
+        // Neighbours' areas never drop below the removed one, so removal
+        // order stays monotonic (Visvalingam & Whyatt).
+        if (l > 0) {
+            area[l] = std::max(a, triangle_area(p, prev[l], l, r));
+            heap.push({area[l], l});
+        }
+        if (r + 1 < n) {
+            area[r] = std::max(a, triangle_area(p, l, r, next[r]));
+            heap.push({area[r], r});
+        }
+    }
+    return gather(route, keep);
+}
+
+std::vector<GpsRecord>
+simplify_route(const std::vector<GpsRecord>& route, const SpatialOptions& opts)
+{
+    switch (opts.simplify) {
+    case SimplifyAlgorithm::kDouglasPeucker:
+        return simplify_douglas_peucker(
+            route, opts.tolerance > 0.0 ? opts.tolerance : kDefaultDpToleranceM);
+    case SimplifyAlgorithm::kVisvalingam:
+        return simplify_visvalingam(
+            route, opts.tolerance > 0.0 ? opts.tolerance : kDefaultVwAreaM2);
+    case SimplifyAlgorithm::kNone:
+        break;
+    }
+    return route;
+}
+
+// ─── RouteFilter ────────────────────────────────────────────────────────────
+
+RouteFilter::RouteFilter(const SpatialOptions& opts)
+    : opts_(opts), degrees_(opts.epsilon_deg),
+      threshold_(score_threshold(opts.epsilon_m, opts.metric == SpatialMetric::kHaversine))
+{
+}
+
+bool RouteFilter::accept(const GpsRecord& rec)
+{
+    if (opts_.metric == SpatialMetric::kDegrees)
+        return degrees_.accept(rec);
+
+    if (has_last_) {
+        const bool  haversine = opts_.metric == SpatialMetric::kHaversine;
+        const Point a = make_point(last_, haversine);
+        const Point p = make_point(rec, haversine);
+        if (!(score_point(p, a, haversine) > threshold_))
+            return false;
+    }
+    last_     = rec;
+    has_last_ = true;
+    return true;
+}
+
+bool RouteFilter::has_last() const
+{
+    return opts_.metric == SpatialMetric::kDegrees ? degrees_.has_last() : has_last_;
+}
+
+const GpsRecord& RouteFilter::last() const
+{
+    return opts_.metric == SpatialMetric::kDegrees ? degrees_.last() : last_;
+}
+
+void RouteFilter::resume(const GpsRecord& last)
+{
+    degrees_.resume(last);
+    last_     = last;
+    has_last_ = true;
+}
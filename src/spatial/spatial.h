@@ -0,0 +1,119 @@
+/*
+ * spatial.h — Metric spatial dedup and route simplification
+ *
+ * Points are held as structure-of-arrays columns (one contiguous array per
+ * quantity) so the distance loops are plain, branch-free arithmetic over
+ * doubles that the compiler vectorises.  Trigonometry is done once per
+ * point up front, never per pair.
+ */
+
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include "arena.h"
+#include "dedup.h"
+#include "nmea_parser.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Mean Earth radius (IUGG), metres.
+inline constexpr double kEarthRadiusM = 6371008.8;
+
+/// Default metre threshold for --spatial equirect|haversine; close to the
+/// ~1.1 m that kSpatialEpsilon means at the equator.
+inline constexpr double kDefaultSpatialEpsilonM = 1.0;
+
+/// Default --simplify tolerances: Douglas-Peucker distance (m) and
+/// Visvalingam effective area (m²).
+inline constexpr double kDefaultDpToleranceM = 5.0;
+inline constexpr double kDefaultVwAreaM2     = 25.0;
+
+/// Distance test used by spatial dedup.
+enum class SpatialMetric {
+    kDegrees,          // per-axis |Δlat|, |Δlon| against a degree epsilon (original)
+    kEquirectangular,  // flat-earth metres, cos(lat) of the kept point
+    kHaversine,        // great-circle metres
+};
+
+/// Optional route thinning after dedup.
+enum class SimplifyAlgorithm {
+    kNone,
+    kDouglasPeucker,   // keep points farther than tolerance (m) from the simplified line
+    kVisvalingam,      // drop points whose triangle area is below tolerance (m²)
+};
+
+/// Spatial stage configuration (--spatial, --spatial-eps-m, --simplify,
+/// --simplify-tolerance).
+struct SpatialOptions {
+    SpatialMetric     metric      = SpatialMetric::kDegrees;
+    double            epsilon_deg = kSpatialEpsilon;
+    double            epsilon_m   = kDefaultSpatialEpsilonM;
+    SimplifyAlgorithm simplify    = SimplifyAlgorithm::kNone;
+    double            tolerance   = 0.0;   // 0 = algorithm default
+};
+
+/// Distance between two records in metres: flat-earth for
+/// kEquirectangular, great-circle otherwise.
+double distance_m(const GpsRecord& a, const GpsRecord& b, SpatialMetric metric);
+
+/// Spatial dedup: keep a point only if it is farther than the threshold
+/// (`opts.epsilon_deg` for kDegrees, else `opts.epsilon_m`) from the last
+/// kept point.  kDegrees gives exactly `dedup_spatial`'s result.
+std::vector<GpsRecord>
+dedup_spatial_metric(const std::vector<GpsRecord>& records, const SpatialOptions& opts);
+
+/// Index form of `dedup_spatial_metric` over the records `order` selects;
+/// returns the kept subset of `order`, allocated from `arena`.
+Span<std::uint32_t>
+dedup_spatial_metric_indices(Span<const GpsRecord> records, Span<const std::uint32_t> order,
+                             const SpatialOptions& opts, Arena& arena);
+
+/// In-place `dedup_spatial_metric`: kept records are compacted to the
+/// front of `records` (order preserved) and their count is returned.
+std::size_t dedup_spatial_metric_in_place(Span<GpsRecord> records, const SpatialOptions& opts);
+
+/// As above on a vector, erasing the tail.
+void dedup_spatial_metric_in_place(std::vector<GpsRecord>& records, const SpatialOptions& opts);
+
+/// Douglas-Peucker simplification with a metre tolerance.  First and last
+/// points are always kept.
+std::vector<GpsRecord>
+simplify_douglas_peucker(const std::vector<GpsRecord>& route, double tolerance_m);
+
+/// Visvalingam-Whyatt simplification: repeatedly remove the point whose
+/// triangle with its neighbours has the smallest area, until every
+/// remaining area is at least `min_area_m2`.  Endpoints are kept.
+std::vector<GpsRecord>
+simplify_visvalingam(const std::vector<GpsRecord>& route, double min_area_m2);
+
+/// Run `opts.simplify` (with its default tolerance if unset); returns the
+/// route unchanged for kNone.
+std::vector<GpsRecord>
+simplify_route(const std::vector<GpsRecord>& route, const SpatialOptions& opts);
+
+/// Incremental form of `dedup_spatial_metric` for the streaming and live
+/// pipelines: same decisions, constant state.
+class RouteFilter {
+public:
+    explicit RouteFilter(const SpatialOptions& opts);
+
+    /// Return true (and remember `rec`) if it belongs on the route.
+    bool accept(const GpsRecord& rec);
+
+    /// The last point accepted, if any; resume() carries on from a saved
+    /// one (--checkpoint).
+    bool             has_last() const;
+    const GpsRecord& last() const;
+    void             resume(const GpsRecord& last);
+
+private:
+    SpatialOptions opts_;
+    SpatialFilter  degrees_;
+    double         threshold_ = 0.0;   // metric score equivalent of epsilon_m
+    bool           has_last_ = false;
+    GpsRecord      last_{};
+};
+
+#endif // SPATIAL_H
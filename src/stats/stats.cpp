@@ -0,0 +1,273 @@
+/*
+ * stats.cpp — Per-stage timing, throughput and memory instrumentation
+ */
+
+#include "stats.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+// ─── Stats constants ───────────────────────────────────────────────────────
+
+static constexpr double kNsPerSecond = 1e9;
+static constexpr double kNsPerMs     = 1e6;
+static constexpr double kBytesPerMB  = 1e6;
+
+static constexpr const char* kStageNames[kStageCount] = {
+    "read", "checksum", "classify", "parse",
+    "temporal_dedup", "spatial_dedup", "output",
+};
+
+// ─── Internal helpers ───────────────────────────────────────────────────────
+
+/// Events per second, or 0 when nothing was timed.
+static double per_second(std::uint64_t count, std::int64_t ns)
+{
+    return ns > 0 ? static_cast<double>(count) * kNsPerSecond / static_cast<double>(ns)
+                  : 0.0;
+}
+
+static double to_ms(std::int64_t ns)
+{
+    return static_cast<double>(ns) / kNsPerMs;
+}
+
+/// Column label of a sentence type: "RMC", …, "other" for kUnknown.
+static const char* type_label(SentenceType t)
+{
+    return t == SentenceType::kUnknown ? "other" : sentence_type_name(t);
+}
+
+/// The sample in input order, for reading.
+static std::vector<RejectSample> sorted_samples(const RejectStats& rejects)
+{
+    std::vector<RejectSample> samples = rejects.samples;
+    std::sort(samples.begin(), samples.end(), [](const RejectSample& a, const RejectSample& b) {
+        return a.at.file != b.at.file ? a.at.file < b.at.file : a.at.offset < b.at.offset;
+    });
+    return samples;
+}
+
+/// Name of input `file` ("#N" when the report has no paths, as in live mode).
+static std::string input_name(const StatsReport& report, std::size_t file)
+{
+    return file < report.inputs.size() ? report.inputs[file] : "#" + std::to_string(file);
+}
+
+/// `text` as the body of a JSON string.
+static std::string json_escape(std::string_view text)
+{
+    static constexpr char kHex[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text) {
+        const auto u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (u < 0x20 || u >= 0x7f) {
+            out += "\\u00";
+            out += kHex[u >> 4];
+            out += kHex[u & 0xf];
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+/// The "=== Rejected Lines ===" section of the stats table.
+static void print_rejects_table(const StatsReport& report, std::ostream& os)
+{
+    const RejectStats& rejects = report.rejects;
+    os << "\n=== Rejected Lines ===\n";
+    if (rejects.total() == 0) {
+        os << "  (none)\n";
+        return;
+    }
+    os << std::left << "  " << std::setw(18) << "Reason" << std::right << std::setw(10) << "Total";
+    for (std::size_t t = 1; t <= kSentenceTypeCount; ++t)
+        os << std::setw(9) << type_label(static_cast<SentenceType>(t % kSentenceTypeCount));
+    os << '\n';
+    for (std::size_t r = 1; r < kRejectReasonCount; ++r) {
+        const auto reason = static_cast<RejectReason>(r);
+        if (rejects.total(reason) == 0)
+            continue;
+        os << "  " << std::left << std::setw(18) << reject_reason_name(reason) << std::right
+           << std::setw(10) << rejects.total(reason);
+        for (std::size_t t = 1; t <= kSentenceTypeCount; ++t)
+            os << std::setw(9)
+               << rejects.count(reason, static_cast<SentenceType>(t % kSentenceTypeCount));
+        os << '\n';
+    }
+    if (rejects.samples.empty()) {
+        os << "  Sample: none (parse cache hits keep counts only)\n";
+        return;
+    }
+    os << "  Sample (" << rejects.samples.size() << " of " << rejects.offered << "):\n";
+    for (const RejectSample& s : sorted_samples(rejects))
+        os << "    " << input_name(report, s.at.file) << ':' << s.at.offset << "  "
+           << reject_reason_name(s.reason) << "  " << type_label(s.type) << "  " << s.line << '\n';
+}
+
+// ─── Public API ─────────────────────────────────────────────────────────────
+
+StageTimes& StageTimes::operator+=(const StageTimes& other)
+{
+    for (std::size_t i = 0; i < kStageCount; ++i) {
+        stage[i].ns    += other.stage[i].ns;
+        stage[i].items += other.stage[i].items;
+        stage[i].bytes += other.stage[i].bytes;
+        if (other.stage[i].peak_rss_kb > stage[i].peak_rss_kb)
+            stage[i].peak_rss_kb = other.stage[i].peak_rss_kb;
+    }
+    return *this;
+}
+
+const char* stage_name(Stage s)
+{
+    return kStageNames[static_cast<unsigned>(s)];
+}
+
+long peak_rss_kb()
+{
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return usage.ru_maxrss;   // KiB on Linux
+#endif
+}
+
+void mark_peak_rss(StageSample& sample)
+{
+    if constexpr (kStatsEnabled)
+        sample.peak_rss_kb = peak_rss_kb();
+}
+
+void print_stats_table(const StatsReport& report, std::ostream& os)
+{
+    const auto flags = os.flags();
+    const auto prec  = os.precision();
+
+    os << "\n=== Stage Timing ===\n";
+    if (!kStatsEnabled) {
+        os << "  (instrumentation compiled out: rebuild without NMEA_NO_STATS)\n";
+        print_rejects_table(report, os);
+        return;
+    }
+    os << std::left << "  " << std::setw(16) << "Stage"
+       << std::right << std::setw(11) << "Time (ms)"
+       << std::setw(12) << "Items"
+       << std::setw(14) << "Items/s"
+       << std::setw(10) << "MB/s"
+       << std::setw(14) << "Peak RSS (KB)" << '\n';
+    os << std::fixed;
+    for (std::size_t i = 0; i < kStageCount; ++i) {
+        const StageSample& s = report.stages.stage[i];
+        os << "  " << std::left << std::setw(16) << kStageNames[i] << std::right
+           << std::setprecision(3) << std::setw(11) << to_ms(s.ns)
+           << std::setw(12) << s.items
+           << std::setprecision(0) << std::setw(14) << per_second(s.items, s.ns)
+           << std::setprecision(1) << std::setw(10)
+           << per_second(s.bytes, s.ns) / kBytesPerMB
+           << std::setw(14) << s.peak_rss_kb << '\n';
+    }
+    os << std::setprecision(3)
+       << "  Ingest wall (ms)     : " << to_ms(report.ingest_ns)
+       << "  (" << report.jobs << (report.jobs == 1 ? " job" : " jobs") << ")\n"
+       << "  Total wall (ms)      : " << to_ms(report.wall_ns) << '\n'
+       << std::setprecision(1)
+       << "  Throughput           : "
+       << per_second(report.input_bytes, report.wall_ns) / kBytesPerMB << " MB/s, "
+       << std::setprecision(0) << per_second(report.lines, report.wall_ns) << " lines/s\n"
+       << "  Peak RSS (KB)        : " << report.peak_rss_kb << '\n';
+    print_rejects_table(report, os);
+
+    os.flags(flags);
+    os.precision(prec);
+}
+
+bool write_stats_json(const StatsReport& report, const std::string& path,
+                      std::string& error)
+{
+    std::ofstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file) {
+            error = "cannot write stats to '" + path + "'";
+            return false;
+        }
+    }
+    std::ostream& os = path == "-" ? std::cout : file;
+
+    os << std::fixed << std::setprecision(3)
+       << "{\n"
+       << "  \"enabled\": " << (kStatsEnabled ? "true" : "false") << ",\n"
+       << "  \"mode\": \"" << report.mode << "\",\n"
+       << "  \"jobs\": " << report.jobs << ",\n"
+       << "  \"wall_ms\": " << to_ms(report.wall_ns) << ",\n"
+       << "  \"ingest_wall_ms\": " << to_ms(report.ingest_ns) << ",\n"
+       << "  \"input_bytes\": " << report.input_bytes << ",\n"
+       << "  \"lines\": " << report.lines << ",\n"
+       << "  \"bytes_per_sec\": " << per_second(report.input_bytes, report.wall_ns) << ",\n"
+       << "  \"lines_per_sec\": " << per_second(report.lines, report.wall_ns) << ",\n"
+       << "  \"peak_rss_kb\": " << report.peak_rss_kb << ",\n"
+       << "  \"stages\": [\n";
+    for (std::size_t i = 0; i < kStageCount; ++i) {
+        const StageSample& s = report.stages.stage[i];
+        os << "    {\"name\": \"" << kStageNames[i] << "\""
+           << ", \"time_ms\": " << to_ms(s.ns)
+           << ", \"items\": " << s.items
+           << ", \"bytes\": " << s.bytes
+           << ", \"items_per_sec\": " << per_second(s.items, s.ns)
+           << ", \"bytes_per_sec\": " << per_second(s.bytes, s.ns)
+           << ", \"peak_rss_kb\": " << s.peak_rss_kb << "}"
+           << (i + 1 < kStageCount ? ",\n" : "\n");
+    }
+    const RejectStats& rejects = report.rejects;
+    os << "  ],\n"
+       << "  \"rejects\": {\n"
+       << "    \"total\": " << rejects.total() << ",\n"
+       << "    \"by_reason\": [\n";
+    for (std::size_t r = 1; r < kRejectReasonCount; ++r) {
+        const auto reason = static_cast<RejectReason>(r);
+        os << "      {\"reason\": \"" << reject_reason_name(reason) << "\""
+           << ", \"total\": " << rejects.total(reason) << ", \"by_type\": {";
+        for (std::size_t t = 1; t <= kSentenceTypeCount; ++t) {
+            const auto type = static_cast<SentenceType>(t % kSentenceTypeCount);
+            os << (t > 1 ? ", " : "") << '"' << type_label(type) << "\": "
+               << rejects.count(reason, type);
+        }
+        os << "}}" << (r + 1 < kRejectReasonCount ? ",\n" : "\n");
+    }
+    os << "    ],\n"
+       << "    \"sampled_from\": " << rejects.offered << ",\n"
+       << "    \"samples\": [";
+    const std::vector<RejectSample> samples = sorted_samples(rejects);
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        const RejectSample& s = samples[i];
+        os << (i ? ",\n" : "\n")
+           << "      {\"file\": \"" << json_escape(input_name(report, s.at.file)) << "\""
+           << ", \"offset\": " << s.at.offset
+           << ", \"reason\": \"" << reject_reason_name(s.reason) << "\""
+           << ", \"type\": \"" << type_label(s.type) << "\""
+           << ", \"line\": \"" << json_escape(s.line) << "\"}";
+    }
+    os << (samples.empty() ? "]\n" : "\n    ]\n")
+       << "  }\n}\n";
+    os.flush();
+    if (!os) {
+        error = "failed writing stats to '" + path + "'";
+        return false;
+    }
+    return true;
+}
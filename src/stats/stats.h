@@ -0,0 +1,120 @@
+/*
+ * stats.h — Per-stage timing, throughput and memory instrumentation
+ *
+ * Compile with -DNMEA_NO_STATS (make STATS=0) to remove every timer from
+ * the hot path; the structures stay so callers need no #ifdefs, but all
+ * samples read zero.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "reject.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifdef NMEA_NO_STATS
+inline constexpr bool kStatsEnabled = false;
+#else
+inline constexpr bool kStatsEnabled = true;
+#endif
+
+/// Pipeline stages, in processing order.
+enum class Stage : unsigned {
+    kRead,            // file open/map, decompression and line splitting
+    kChecksum,        // verify_checksum_batch
+    kClassify,        // is_not_relevant
+    kParse,           // parse_gprmc
+    kTemporalDedup,   // last-write-wins
+    kSpatialDedup,    // jitter suppression
+    kOutput,          // route table + URL
+};
+
+inline constexpr std::size_t kStageCount = 7;
+
+/// Accumulated cost of one stage.  `ns` is summed over threads, so for
+/// parallel ingest it is CPU time rather than wall time.
+struct StageSample {
+    std::int64_t  ns          = 0;
+    std::uint64_t items       = 0;   // lines or records handled
+    std::uint64_t bytes       = 0;   // input bytes handled (0 = not meaningful)
+    long          peak_rss_kb = 0;   // process high-water mark when the stage ended
+};
+
+/// One sample per stage.  Kept per thread / per chunk alongside the line
+/// counters and summed at the end.
+struct StageTimes {
+    std::array<StageSample, kStageCount> stage{};
+
+    StageSample&       operator[](Stage s)       { return stage[static_cast<unsigned>(s)]; }
+    const StageSample& operator[](Stage s) const { return stage[static_cast<unsigned>(s)]; }
+
+    StageTimes& operator+=(const StageTimes& other);
+};
+
+/// RAII timer adding its lifetime to a StageSample.  Compiles to nothing
+/// under NMEA_NO_STATS.
+class StageTimer {
+public:
+    explicit StageTimer(StageSample& sample) noexcept : sample_(sample)
+    {
+        if constexpr (kStatsEnabled)
+            start_ = std::chrono::steady_clock::now();
+    }
+
+    ~StageTimer()
+    {
+        if constexpr (kStatsEnabled)
+            sample_.ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start_).count();
+    }
+
+    StageTimer(const StageTimer&)            = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    StageSample&                          sample_;
+    std::chrono::steady_clock::time_point start_{};
+};
+
+/// Whole-run report handed to the printers.
+struct StatsReport {
+    std::string   mode;              // "batch", "stream"
+    unsigned      jobs        = 1;
+    std::int64_t  wall_ns     = 0;   // end-to-end, including output
+    std::int64_t  ingest_ns   = 0;   // wall time of read→parse
+    std::uint64_t input_bytes = 0;
+    std::uint64_t lines       = 0;
+    long          peak_rss_kb = 0;
+    StageTimes    stages;
+    RejectStats   rejects;           // lines rejected, by reason and type
+    std::vector<std::string> inputs;   // input paths, to name the samples' files
+};
+
+/// Short lower-case identifier ("read", "temporal_dedup", …) used in
+/// both the table and the JSON.
+const char* stage_name(Stage s);
+
+/// Peak resident set size of this process in KiB (0 where unsupported).
+long peak_rss_kb();
+
+/// Record the current RSS high-water mark on `sample` (no-op when
+/// instrumentation is compiled out).
+void mark_peak_rss(StageSample& sample);
+
+/// Human-readable "=== Stage Timing ===" table, then the
+/// "=== Rejected Lines ===" counts and sample.
+void print_stats_table(const StatsReport& report, std::ostream& os);
+
+/// Write `report` as JSON to `path` ("-" = stdout), rejects included.  Returns false and
+/// sets `error` if the file cannot be written.
+bool write_stats_json(const StatsReport& report, const std::string& path,
+                      std::string& error);
+
+#endif // STATS_H
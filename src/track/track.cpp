@@ -0,0 +1,124 @@
+/*
+ * track.cpp — Per-track route separation (--track-by, --track)
+ */
+
+#include "track.h"
+#include "parallel.h"
+#include "sentence.h"
+
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+
+// ─── Public API ─────────────────────────────────────────────────────────────
+
+TrackTable plan_file_tracks(const std::vector<std::string>& inputs,
+                            const TrackMapping& mapping,
+                            std::vector<std::uint32_t>& file_tracks)
+{
+    std::unordered_map<std::string, const std::string*> name_of;
+    for (const auto& [name, file] : mapping)
+        name_of[file] = &name;
+
+    TrackTable table;
+    std::unordered_map<std::string, std::uint32_t> id_of;
+    file_tracks.clear();
+    file_tracks.reserve(inputs.size());
+    for (const std::string& input : inputs) {
+        const auto mapped = name_of.find(input);
+        const std::string& name = mapped != name_of.end() ? *mapped->second : input;
+        const auto [it, added] = id_of.emplace(name, static_cast<std::uint32_t>(table.names.size()));
+        if (added)
+            table.names.push_back(name);
+        file_tracks.push_back(it->second);
+    }
+    return table;
+}
+
+TrackTable plan_talker_tracks()
+{
+    TrackTable table;
+    for (std::size_t t = 0; t < kTalkerCount; ++t)
+        table.names.emplace_back(talker_name(static_cast<Talker>(t)));
+    return table;
+}
+
+std::vector<std::size_t> partition_by_track(Span<GpsRecord> records, std::size_t track_count,
+                                            Arena& scratch)
+{
+    std::vector<std::size_t> offsets(track_count + 1, 0);
+    for (const GpsRecord& rec : records)
+        ++offsets[rec.track + 1];
+    for (std::size_t t = 0; t < track_count; ++t)
+        offsets[t + 1] += offsets[t];
+    for (std::size_t t = 0; t < track_count; ++t)
+        if (offsets[t + 1] - offsets[t] == records.size())
+            return offsets;   // a single track: already in place
+
+    const Span<GpsRecord> copy = scratch.copy(Span<const GpsRecord>(records));
+    std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
+    for (std::size_t i = 0; i < records.size(); ++i)
+        records[next[copy[i].track]++] = copy[i];
+    return offsets;
+}
+
+std::vector<TrackRoute> dedup_tracks(Span<GpsRecord> records, std::size_t track_count,
+                                     DedupEngine engine, const SpatialOptions& spatial,
+                                     unsigned jobs, Arena& scratch, StageTimes& timing)
+{
+    const std::vector<std::size_t> offsets = partition_by_track(records, track_count, scratch);
+
+    std::vector<TrackRoute> routes;
+    for (std::size_t t = 0; t < track_count; ++t) {
+        if (offsets[t + 1] > offsets[t]) {
+            TrackRoute r;
+            r.track   = static_cast<std::uint32_t>(t);
+            r.records = offsets[t + 1] - offsets[t];
+            routes.push_back(std::move(r));
+        }
+    }
+
+    // Each task owns one track's slice of `records` and its own timing.
+    std::vector<StageTimes> task_timing(routes.size());
+    parallel_for(routes.size(), jobs, [&](std::size_t i) {
+        TrackRoute& r = routes[i];
+        StageTimes& t = task_timing[i];
+        const Span<GpsRecord> slice(records.data() + offsets[r.track], r.records);
+        {
+            StageTimer timer(t[Stage::kTemporalDedup]);
+            r.after_lww = dedup_last_write_wins_in_place(slice, engine);
+        }
+        t[Stage::kTemporalDedup].items = r.records;
+        {
+            StageTimer timer(t[Stage::kSpatialDedup]);
+            r.after_spatial = dedup_spatial_metric_in_place(
+                Span<GpsRecord>(slice.data(), r.after_lww), spatial);
+            r.route.assign(slice.begin(), slice.begin() + r.after_spatial);
+            if (spatial.simplify != SimplifyAlgorithm::kNone)
+                r.route = simplify_route(r.route, spatial);
+        }
+        t[Stage::kSpatialDedup].items = r.after_lww;
+    });
+    for (const StageTimes& t : task_timing)
+        timing += t;
+    return routes;
+}
+
+std::string track_path(const std::string& path, const std::string& name)
+{
+    if (path == "-")
+        return path;
+
+    std::string safe = name;
+    for (char& c : safe) {
+        const auto u = static_cast<unsigned char>(c);
+        if (!std::isalnum(u) && c != '-' && c != '_' && c != '.')
+            c = '_';
+    }
+    const std::size_t slash = path.find_last_of("/\\");
+    const std::size_t dot   = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash) ||
+        dot == (slash == std::string::npos ? 0 : slash + 1))
+        return path + "." + safe;
+    return path.substr(0, dot) + "." + safe + path.substr(dot);
+}
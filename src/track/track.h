@@ -0,0 +1,77 @@
+/*
+ * track.h — Per-track route separation (--track-by, --track)
+ *
+ * Several vehicles' logs fed to one run must not share a timestamp map,
+ * or their fixes interleave into one route.  Ingest tags every record
+ * with a track (GpsRecord::track); this module names the tracks, splits
+ * the records by track and runs the dedup pipeline on each track
+ * independently, sharding tracks across worker threads.  Every task
+ * works on its own slice of the records, so there are no locks.
+ */
+
+#ifndef TRACK_H
+#define TRACK_H
+
+#include "arena.h"
+#include "dedup.h"
+#include "ingest.h"
+#include "nmea_parser.h"
+#include "spatial.h"
+#include "stats.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Track names, indexed by track id.
+struct TrackTable {
+    std::vector<std::string> names;
+};
+
+/// `--track NAME=FILE` entries: the input FILE belongs to track NAME.
+using TrackMapping = std::vector<std::pair<std::string, std::string>>;
+
+/// Name the tracks of a TrackBy::kFile run and fill `file_tracks` with
+/// the track of every input.  An input mapped by `mapping` joins the
+/// track of that name (several inputs may share one); any other input is
+/// a track of its own, named after its path.  Tracks are numbered in
+/// order of first appearance among `inputs`.
+TrackTable plan_file_tracks(const std::vector<std::string>& inputs,
+                            const TrackMapping& mapping,
+                            std::vector<std::uint32_t>& file_tracks);
+
+/// Tracks of a TrackBy::kTalker run: one per Talker enumerator.
+TrackTable plan_talker_tracks();
+
+/// Result of the pipeline for one track.
+struct TrackRoute {
+    std::uint32_t          track         = 0;
+    std::size_t            records       = 0;   // parsed records of the track
+    std::size_t            after_lww     = 0;
+    std::size_t            after_spatial = 0;
+    std::vector<GpsRecord> route;               // after --simplify, if any
+};
+
+/// Stable partition of `records` by track (a counting sort through a
+/// scratch copy in `scratch`).  Returns `track_count + 1` offsets: track
+/// t occupies [offsets[t], offsets[t + 1]).  Every track id must be below
+/// `track_count`.
+std::vector<std::size_t> partition_by_track(Span<GpsRecord> records, std::size_t track_count,
+                                            Arena& scratch);
+
+/// Partition `records`, then run last-write-wins, spatial dedup and
+/// simplification on each non-empty track in place, `jobs` tracks at a
+/// time.  Results come back in track order.  Stage time is summed over
+/// tasks into `timing` (temporal and spatial dedup), as for ingest chunks.
+std::vector<TrackRoute> dedup_tracks(Span<GpsRecord> records, std::size_t track_count,
+                                     DedupEngine engine, const SpatialOptions& spatial,
+                                     unsigned jobs, Arena& scratch, StageTimes& timing);
+
+/// `path` with `.name` inserted before its extension, for per-track
+/// exports; characters other than letters, digits, '-', '_' and '.' in
+/// the name become '_'.
+std::string track_path(const std::string& path, const std::string& name);
+
+#endif // TRACK_H
@@ -0,0 +1,28 @@
+/*
+ * util.cpp — Helpers shared by the modules that persist state (cache, checkpoint)
+ */
+
+#include "util.h"
+
+#include <chrono>
+#include <functional>
+#include <thread>
+
+// ─── Hashing ────────────────────────────────────────────────────────────────
+
+std::uint64_t fnv1a(std::uint64_t h, const void* data, std::size_t size)
+{
+    const auto* p = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i)
+        h = (h ^ p[i]) * kFnvPrime;
+    return h;
+}
+
+// ─── Files ──────────────────────────────────────────────────────────────────
+
+std::string temp_name(const std::string& path)
+{
+    const auto salt = std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+        static_cast<std::size_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    return path + ".tmp" + std::to_string(salt);
+}
@@ -0,0 +1,33 @@
+/*
+ * util.h — Helpers shared by the modules that persist state (cache, checkpoint)
+ */
+
+#ifndef UTIL_H
+#define UTIL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// ─── Hashing ────────────────────────────────────────────────────────────────
+
+/// 64-bit FNV-1a parameters; start a hash at `kFnvOffset`.
+inline constexpr std::uint64_t kFnvOffset = 0xcbf29ce484222325ull;
+inline constexpr std::uint64_t kFnvPrime  = 0x100000001b3ull;
+
+/// Fold `size` bytes at `data` into the FNV-1a hash `h`.
+std::uint64_t fnv1a(std::uint64_t h, const void* data, std::size_t size);
+
+/// Fold the bytes of `value` into `h`.
+template <typename T>
+std::uint64_t fnv1a(std::uint64_t h, const T& value)
+{
+    return fnv1a(h, &value, sizeof value);
+}
+
+// ─── Files ──────────────────────────────────────────────────────────────────
+
+/// A temporary name next to `path`, unique to this thread of this run.
+std::string temp_name(const std::string& path);
+
+#endif // UTIL_H